@@ -0,0 +1,240 @@
+/******************************************************************************
+ *   @file LatencyHistogram.h                                                 *
+ *   @copyright                                                               *
+ *                                                                            *
+ *   This program is free software; you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published by     *
+ *   the Free Software Foundation; either version 2 of the License, or        *
+ *   (at your option) any later version.                                      *
+ *                                                                            *
+ *   This program is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *   GNU General Public License for more details.                             *
+ *                                                                            *
+ *   You should have received a copy of the GNU General Public License        *
+ *   along with this program; if not, write to the                            *
+ *   Free Software Foundation, Inc.,                                          *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.                *
+ *****************************************************************************/
+
+#ifndef _LatencyHistogram_h_
+#define _LatencyHistogram_h_
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Log-linear histogram of non-negative values, e.g. latencies in
+ *        nanoseconds.
+ *
+ *        Values below SUB_BUCKET_COUNT are counted exactly. Larger values
+ *        are grouped by their highest set bit, and each of these power of
+ *        two ranges is split into SUB_BUCKET_COUNT buckets of equal width.
+ *        The relative error of a reported value is therefore at most
+ *        1/SUB_BUCKET_COUNT over the whole range of long long.
+ *
+ *        Record() may only be called by one thread at a time. The other
+ *        methods may be called concurrently with Record(); they then see
+ *        a recent, but not necessarily consistent, state.
+ */
+class LatencyHistogram
+{
+public:
+    /**
+     * @brief Creates an empty histogram.
+     */
+    LatencyHistogram() ;
+
+    /**
+     * @brief Adds a value to the histogram. Negative values are counted
+     *        as zero.
+     */
+    void
+    Record( const long long value ) ;
+
+    /**
+     * @brief Returns the number of values recorded.
+     */
+    unsigned long long
+    GetNumOfSamples() const ;
+
+    /**
+     * @brief Returns the smallest value that is at least as large as the
+     *        specified percentage of the recorded values, rounded up to
+     *        the upper bound of its bucket. Returns zero if no values have
+     *        been recorded.
+     * @param percentile A value between 0 and 100, e.g. 99.9.
+     */
+    long long
+    GetPercentile( const double percentile ) const ;
+
+    /**
+     * @brief Removes all values from the histogram.
+     */
+    void
+    Reset() ;
+
+private:
+    /**
+     * @brief Number of bits of a value, below its highest set bit, that
+     *        select the bucket within its power of two range.
+     */
+    static const int SUB_BUCKET_BITS  = 4 ;
+    static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS ;
+
+    /**
+     * @brief Values below SUB_BUCKET_COUNT use one bucket each. There is
+     *        one range of SUB_BUCKET_COUNT buckets for every possible
+     *        highest set bit above that.
+     */
+    static const int NUM_OF_BUCKETS =
+        SUB_BUCKET_COUNT * ( 64 - SUB_BUCKET_BITS ) ;
+
+    /**
+     * @brief Returns the index of the bucket counting value.
+     */
+    static
+    int
+    GetBucketIndex( const unsigned long long value ) ;
+
+    /**
+     * @brief Returns the largest value counted by the bucket.
+     */
+    static
+    unsigned long long
+    GetBucketUpperBound( const int bucketIndex ) ;
+
+    /**
+     * @brief Copying is not allowed. This method is never defined.
+     */
+    LatencyHistogram( const LatencyHistogram& otherLatencyHistogram ) ;
+
+    /**
+     * @brief Copying is not allowed. This method is never defined.
+     */
+    LatencyHistogram& operator=( const LatencyHistogram& otherLatencyHistogram ) ;
+
+    /**
+     * @brief Number of values counted by each bucket.
+     */
+    std::atomic<unsigned long long> mBuckets[NUM_OF_BUCKETS] ;
+
+    /**
+     * @brief Total number of values recorded.
+     */
+    std::atomic<unsigned long long> mNumOfSamples ;
+} ;
+
+inline
+LatencyHistogram::LatencyHistogram() :
+    mNumOfSamples(0)
+{
+    this->Reset() ;
+}
+
+inline
+void
+LatencyHistogram::Record( const long long value )
+{
+    //
+    // There is only one writer, so the counters do not need atomic
+    // read-modify-write operations.
+    //
+    std::atomic<unsigned long long>& bucket =
+        mBuckets[ GetBucketIndex( value > 0 ? value : 0 ) ] ;
+    bucket.store( bucket.load( std::memory_order_relaxed ) + 1,
+                  std::memory_order_relaxed ) ;
+    mNumOfSamples.store( mNumOfSamples.load( std::memory_order_relaxed ) + 1,
+                         std::memory_order_relaxed ) ;
+}
+
+inline
+unsigned long long
+LatencyHistogram::GetNumOfSamples() const
+{
+    return mNumOfSamples.load( std::memory_order_relaxed ) ;
+}
+
+inline
+long long
+LatencyHistogram::GetPercentile( const double percentile ) const
+{
+    //
+    // Sum up the buckets instead of using mNumOfSamples so that the
+    // result is consistent with the buckets that are scanned.
+    //
+    unsigned long long num_of_samples = 0 ;
+    for( int i=0; i<NUM_OF_BUCKETS; ++i )
+    {
+        num_of_samples += mBuckets[i].load( std::memory_order_relaxed ) ;
+    }
+    if ( 0 == num_of_samples )
+    {
+        return 0 ;
+    }
+    const double fraction = ( percentile < 0.0 ? 0.0 :
+                              ( percentile > 100.0 ? 1.0 : percentile / 100.0 ) ) ;
+    unsigned long long rank =
+        static_cast<unsigned long long>( fraction * num_of_samples + 0.5 ) ;
+    if ( 0 == rank )
+    {
+        rank = 1 ;
+    }
+    unsigned long long num_of_samples_below = 0 ;
+    for( int i=0; i<NUM_OF_BUCKETS; ++i )
+    {
+        num_of_samples_below += mBuckets[i].load( std::memory_order_relaxed ) ;
+        if ( num_of_samples_below >= rank )
+        {
+            return static_cast<long long>( GetBucketUpperBound( i ) ) ;
+        }
+    }
+    return static_cast<long long>( GetBucketUpperBound( NUM_OF_BUCKETS - 1 ) ) ;
+}
+
+inline
+void
+LatencyHistogram::Reset()
+{
+    for( int i=0; i<NUM_OF_BUCKETS; ++i )
+    {
+        mBuckets[i].store( 0, std::memory_order_relaxed ) ;
+    }
+    mNumOfSamples.store( 0, std::memory_order_relaxed ) ;
+}
+
+inline
+int
+LatencyHistogram::GetBucketIndex( const unsigned long long value )
+{
+    if ( value < static_cast<unsigned long long>( SUB_BUCKET_COUNT ) )
+    {
+        return static_cast<int>( value ) ;
+    }
+    //
+    // The highest set bit selects the range and the following
+    // SUB_BUCKET_BITS bits select the bucket within the range.
+    //
+    const int highest_bit = 63 - __builtin_clzll( value ) ;
+    const int shift       = highest_bit - SUB_BUCKET_BITS ;
+    const int sub_bucket  = static_cast<int>( ( value >> shift ) & ( SUB_BUCKET_COUNT - 1 ) ) ;
+    return ( shift + 1 ) * SUB_BUCKET_COUNT + sub_bucket ;
+}
+
+inline
+unsigned long long
+LatencyHistogram::GetBucketUpperBound( const int bucketIndex )
+{
+    if ( bucketIndex < SUB_BUCKET_COUNT )
+    {
+        return bucketIndex ;
+    }
+    const int shift      = bucketIndex / SUB_BUCKET_COUNT - 1 ;
+    const int sub_bucket = bucketIndex % SUB_BUCKET_COUNT ;
+    const unsigned long long lower_bound =
+        static_cast<unsigned long long>( SUB_BUCKET_COUNT + sub_bucket ) << shift ;
+    return lower_bound + ( 1ULL << shift ) - 1 ;
+}
+
+#endif // #ifndef _LatencyHistogram_h_
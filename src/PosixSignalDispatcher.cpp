@@ -19,15 +19,50 @@
  
 #include "PosixSignalDispatcher.h"
 #include "PosixSignalHandler.h"
-#include <sstream>
+#include <atomic>
 #include <map>
 #include <errno.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
 #include <cstring>
 
 
 namespace
 {
+    /*
+     * The table of per file descriptor handlers covers file descriptors
+     * 0 to FD_HANDLER_CHUNK_SIZE * FD_HANDLER_NUM_OF_CHUNKS - 1.
+     */
+    const int FD_HANDLER_CHUNK_SIZE    = 1024 ;
+    const int FD_HANDLER_NUM_OF_CHUNKS = 64 ;
+
+    /*
+     * Returns true if the specified signal is a real-time signal.
+     */
+    bool
+    IsRealTimeSignal( const int posixSignalNumber )
+    {
+        return ( ( posixSignalNumber >= SIGRTMIN ) &&
+                 ( posixSignalNumber <= SIGRTMAX ) ) ;
+    }
+
+    /*
+     * Locks a mutex for the lifetime of the instance.
+     */
+    class DispatcherLock
+    {
+    public:
+        explicit DispatcherLock( pthread_mutex_t& mutex ) ;
+        ~DispatcherLock() ;
+    private:
+        DispatcherLock( const DispatcherLock& otherDispatcherLock ) ;
+        DispatcherLock& operator=( const DispatcherLock& otherDispatcherLock ) ;
+        pthread_mutex_t& mMutex ;
+    } ;
+
     /**
      * Implementation class for the PosixSignalDispatcher.
      */
@@ -59,6 +94,40 @@ namespace
                        const PosixSignalHandler& signalHandler )
         throw( PosixSignalDispatcher::CannotDetachHandler,
                std::logic_error ) ;
+
+        /*
+         * Implementation of the PosixSignalDispatcher::AttachHandler()
+         * overload for a single file descriptor.
+         */
+        void
+        AttachHandler( const int           posixSignalNumber,
+                       const int           fileDescriptor,
+                       PosixSignalHandler& signalHandler )
+        throw( PosixSignalDispatcher::CannotAttachHandler ) ;
+
+        /*
+         * Implementation of the PosixSignalDispatcher::DetachHandler()
+         * overload for a single file descriptor.
+         */
+        void
+        DetachHandler( const int                 posixSignalNumber,
+                       const int                 fileDescriptor,
+                       const PosixSignalHandler& signalHandler )
+        throw( PosixSignalDispatcher::CannotDetachHandler,
+               std::logic_error ) ;
+
+        /*
+         * Implementation of PosixSignalDispatcher::EnableDispatcherThread()
+         */
+        void
+        EnableDispatcherThread( const int posixSignalNumber )
+        throw( std::runtime_error ) ;
+
+        /*
+         * Implementation of PosixSignalDispatcher::IsDispatcherThreadEnabled()
+         */
+        bool
+        IsDispatcherThreadEnabled( const int posixSignalNumber ) ;
     private:
         /*
          * List of signal handlers that are currently associated
@@ -74,6 +143,64 @@ namespace
         typedef std::map<int, struct sigaction> OriginalSigactionList ;
         static OriginalSigactionList mOriginalSigactionList ;
 
+        /*
+         * Number of handlers using each signal. The dispatcher is
+         * installed for a signal while this is not zero.
+         */
+        typedef std::map<int, unsigned> SignalUseCountList ;
+        static SignalUseCountList mSignalUseCountList ;
+
+        /*
+         * Handlers attached to single file descriptors, indexed by the
+         * file descriptor. The table is read by the signal handler, so
+         * it consists of chunks that are allocated when needed and
+         * never freed. This way the signal handler never sees memory
+         * that is being reallocated.
+         */
+        struct FdHandlerChunk
+        {
+            std::atomic<PosixSignalHandler*> mHandlers[ FD_HANDLER_CHUNK_SIZE ] ;
+        } ;
+        static std::atomic<FdHandlerChunk*> mFdHandlerTable[ FD_HANDLER_NUM_OF_CHUNKS ] ;
+
+        /*
+         * The signal used by each file descriptor in mFdHandlerTable.
+         * Only used outside of the signal handler.
+         */
+        typedef std::map<int, int> FdSignalList ;
+        static FdSignalList mFdSignalList ;
+
+        /*
+         * One more than the largest file descriptor that has ever been
+         * used in mFdHandlerTable. Limits the scan done when the
+         * real-time signal queue has overflowed.
+         */
+        static std::atomic<int> mFdHandlerTableSize ;
+
+        /*
+         * Number of signal handler invocations that are currently
+         * calling handlers taken from mFdHandlerTable.
+         * DetachHandler() waits for this to drop to zero so that a
+         * handler is never called after it has been detached.
+         */
+        static std::atomic<int> mNumOfActiveFdHandlerCalls ;
+
+        /*
+         * Serializes the methods that change the handler lists with the
+         * dispatcher thread. The mutex is recursive so that handlers
+         * called by the dispatcher thread can attach and detach
+         * handlers. It is never locked in signal handlers.
+         */
+        pthread_mutex_t mDispatcherMutex ;
+
+        /*
+         * The signals that are read by the dispatcher thread and the
+         * signalfd() used to read them. mSignalFileDescriptor is -1
+         * until the dispatcher thread has been started.
+         */
+        sigset_t mDispatcherThreadSignals ;
+        int mSignalFileDescriptor ;
+
         /*
          * Default constructor.
          */
@@ -84,13 +211,64 @@ namespace
          */
         ~PosixSignalDispatcherImpl() ;
 
+        /*
+         * Install the dispatcher for the specified signal when it is
+         * used for the first time.
+         */
+        void
+        UseSignal( const int posixSignalNumber )
+        throw( PosixSignalDispatcher::CannotAttachHandler ) ;
+
+        /*
+         * Reinstall the original signal handler when the specified
+         * signal is no longer used.
+         */
+        void
+        ReleaseSignal( const int posixSignalNumber )
+        throw( PosixSignalDispatcher::CannotDetachHandler,
+               std::logic_error ) ;
+
+        /*
+         * Return the entry of mFdHandlerTable for the specified file
+         * descriptor or NULL if its chunk has not been allocated.
+         */
+        static
+        std::atomic<PosixSignalHandler*>*
+        GetFdHandlerEntry( const int fileDescriptor ) ;
+
+        /*
+         * Call the handlers attached to a signal. signalCode and
+         * fileDescriptor correspond to the si_code and si_fd fields of
+         * siginfo_t.
+         */
+        static
+        void
+        DispatchSignal( const int signalNumber,
+                        const int signalCode,
+                        const int fileDescriptor ) ;
+
         /*
          * Static function that is used to attach the signal
          * dispatcher to a signal using sigaction().
          */
         static
         void
-        SigactionHandler( int signalNumber ) ;
+        SigactionHandler( int        signalNumber,
+                          siginfo_t* signalInfo,
+                          void*      context ) ;
+
+        /*
+         * Entry point of the dispatcher thread.
+         */
+        static
+        void*
+        DispatcherThread( void* posixSignalDispatcherImpl ) ;
+
+        /*
+         * Read signals from mSignalFileDescriptor and dispatch them.
+         */
+        void
+        DispatcherLoop() ;
     } ;
 
     //
@@ -102,6 +280,21 @@ namespace
     PosixSignalDispatcherImpl::OriginalSigactionList
     PosixSignalDispatcherImpl::mOriginalSigactionList ;
 
+    PosixSignalDispatcherImpl::SignalUseCountList
+    PosixSignalDispatcherImpl::mSignalUseCountList ;
+
+    std::atomic<PosixSignalDispatcherImpl::FdHandlerChunk*>
+    PosixSignalDispatcherImpl::mFdHandlerTable[ FD_HANDLER_NUM_OF_CHUNKS ] ;
+
+    PosixSignalDispatcherImpl::FdSignalList
+    PosixSignalDispatcherImpl::mFdSignalList ;
+
+    std::atomic<int>
+    PosixSignalDispatcherImpl::mFdHandlerTableSize( 0 ) ;
+
+    std::atomic<int>
+    PosixSignalDispatcherImpl::mNumOfActiveFdHandlerCalls( 0 ) ;
+
 }
 
 PosixSignalDispatcher::PosixSignalDispatcher()
@@ -141,18 +334,82 @@ PosixSignalDispatcher::DetachHandler( const int                 posixSignalNumbe
             signalHandler ) ;
 }
 
+void
+PosixSignalDispatcher::AttachHandler( const int           posixSignalNumber,
+                                      const int           fileDescriptor,
+                                      PosixSignalHandler& signalHandler )
+    throw( CannotAttachHandler )
+{
+    PosixSignalDispatcherImpl::Instance().AttachHandler( posixSignalNumber,
+            fileDescriptor,
+            signalHandler ) ;
+    return ;
+}
+
+void
+PosixSignalDispatcher::DetachHandler( const int                 posixSignalNumber,
+                                      const int                 fileDescriptor,
+                                      const PosixSignalHandler& signalHandler )
+    throw( CannotDetachHandler,
+           std::logic_error )
+{
+    PosixSignalDispatcherImpl::Instance().DetachHandler( posixSignalNumber,
+            fileDescriptor,
+            signalHandler ) ;
+}
+
+void
+PosixSignalDispatcher::EnableDispatcherThread( const int posixSignalNumber )
+    throw( std::runtime_error )
+{
+    PosixSignalDispatcherImpl::Instance().EnableDispatcherThread( posixSignalNumber ) ;
+    return ;
+}
+
+bool
+PosixSignalDispatcher::IsDispatcherThreadEnabled( const int posixSignalNumber ) const
+{
+    return PosixSignalDispatcherImpl::Instance().IsDispatcherThreadEnabled( posixSignalNumber ) ;
+}
+
 namespace
 {
     inline
-    PosixSignalDispatcherImpl::PosixSignalDispatcherImpl()
+    DispatcherLock::DispatcherLock( pthread_mutex_t& mutex ) :
+        mMutex( mutex )
+    {
+        pthread_mutex_lock( &mMutex ) ;
+    }
+
+    inline
+    DispatcherLock::~DispatcherLock()
+    {
+        pthread_mutex_unlock( &mMutex ) ;
+    }
+
+    inline
+    PosixSignalDispatcherImpl::PosixSignalDispatcherImpl() :
+        mDispatcherMutex(),
+        mDispatcherThreadSignals(),
+        mSignalFileDescriptor( -1 )
     {
-        /* empty */
+        pthread_mutexattr_t mutex_attributes ;
+        pthread_mutexattr_init( &mutex_attributes ) ;
+        pthread_mutexattr_settype( &mutex_attributes,
+                                   PTHREAD_MUTEX_RECURSIVE ) ;
+        pthread_mutex_init( &mDispatcherMutex,
+                            &mutex_attributes ) ;
+        pthread_mutexattr_destroy( &mutex_attributes ) ;
+        sigemptyset( &mDispatcherThreadSignals ) ;
     }
 
     inline
     PosixSignalDispatcherImpl::~PosixSignalDispatcherImpl()
     {
-        /* empty */
+        /*
+         * The dispatcher thread may still be running at exit, so neither
+         * the mutex nor the signalfd are released.
+         */
     }
 
     inline
@@ -170,33 +427,12 @@ namespace
         PosixSignalHandler& signalHandler )
     throw( PosixSignalDispatcher::CannotAttachHandler )
     {
+        DispatcherLock dispatcher_lock( mDispatcherMutex ) ;
         /*
          * Attach this instance of PosixSignalDispatcher to the specified
          * signal.
          */
-        struct sigaction sigaction_info ;
-        sigaction_info.sa_handler = PosixSignalDispatcherImpl::SigactionHandler ;
-        sigemptyset( &sigaction_info.sa_mask ) ;
-        sigaction_info.sa_flags = 0 ;
-        /*
-         * Install the handler and get a copy of the previous handler.
-         */
-        struct sigaction old_action ;
-        if ( sigaction( posixSignalNumber,
-                        &sigaction_info,
-                        &old_action ) < 0 )
-        {
-            throw PosixSignalDispatcher::CannotAttachHandler( strerror(errno) ) ;
-        }
-        /*
-         * Save a copy of the old handler if it is not PosixSignalDispatcher::SignalHandler.
-         */
-        if ( PosixSignalDispatcherImpl::SigactionHandler != old_action.sa_handler )
-        {
-            mOriginalSigactionList.insert(
-                OriginalSigactionList::value_type( posixSignalNumber,
-                                                   old_action ) ) ;
-        }
+        this->UseSignal( posixSignalNumber ) ;
         /*
          * Add the specified handler to the list of handlers associated with the signal.
          */
@@ -214,6 +450,7 @@ namespace
     throw( PosixSignalDispatcher::CannotDetachHandler,
            std::logic_error )
     {
+        DispatcherLock dispatcher_lock( mDispatcherMutex ) ;
         /*
          * Get the range of values in the SignalHandlerList corresponding
          * to the specified signal number.
@@ -245,52 +482,442 @@ namespace
              * signal number, then we remove the signal dispatcher from handling
              * the signal and install the original signal.
              */
-            if ( 0 == mSignalHandlerList.count( posixSignalNumber ) )
+            this->ReleaseSignal( posixSignalNumber ) ;
+        }
+        return ;
+    }
+
+    inline
+    void
+    PosixSignalDispatcherImpl::AttachHandler(
+        const int           posixSignalNumber,
+        const int           fileDescriptor,
+        PosixSignalHandler& signalHandler )
+    throw( PosixSignalDispatcher::CannotAttachHandler )
+    {
+        DispatcherLock dispatcher_lock( mDispatcherMutex ) ;
+        /*
+         * Standard signals are not queued and may be coalesced, so they
+         * cannot be routed by file descriptor. Every handler attached
+         * to such a signal is called for every signal.
+         */
+        if ( ! IsRealTimeSignal( posixSignalNumber ) )
+        {
+            this->AttachHandler( posixSignalNumber,
+                                 signalHandler ) ;
+            return ;
+        }
+        if ( ( fileDescriptor < 0 ) ||
+             ( fileDescriptor >= FD_HANDLER_CHUNK_SIZE * FD_HANDLER_NUM_OF_CHUNKS ) )
+        {
+            throw PosixSignalDispatcher::CannotAttachHandler( "File descriptor out of range." ) ;
+        }
+        if ( mFdSignalList.end() != mFdSignalList.find( fileDescriptor ) )
+        {
+            throw PosixSignalDispatcher::CannotAttachHandler( "File descriptor already has a signal handler." ) ;
+        }
+        /*
+         * Allocate the chunk of the table containing the file descriptor.
+         */
+        std::atomic<FdHandlerChunk*>& chunk =
+            mFdHandlerTable[ fileDescriptor / FD_HANDLER_CHUNK_SIZE ] ;
+        if ( 0 == chunk.load() )
+        {
+            FdHandlerChunk* new_chunk = new FdHandlerChunk ;
+            for( int i=0; i<FD_HANDLER_CHUNK_SIZE; ++i )
+            {
+                new_chunk->mHandlers[i].store( 0 ) ;
+            }
+            chunk.store( new_chunk ) ;
+        }
+        /*
+         * Publish the handler before the dispatcher is installed for
+         * the signal.
+         */
+        GetFdHandlerEntry( fileDescriptor )->store( &signalHandler ) ;
+        if ( fileDescriptor >= mFdHandlerTableSize.load() )
+        {
+            mFdHandlerTableSize.store( fileDescriptor + 1 ) ;
+        }
+        mFdSignalList[ fileDescriptor ] = posixSignalNumber ;
+        /*
+         * The kernel raises SIGIO if the queue of real-time signals
+         * overflows, so we need to handle it as well.
+         */
+        try
+        {
+            this->UseSignal( posixSignalNumber ) ;
+            try
+            {
+                this->UseSignal( SIGIO ) ;
+            }
+            catch( ... )
+            {
+                this->ReleaseSignal( posixSignalNumber ) ;
+                throw ;
+            }
+        }
+        catch( const PosixSignalDispatcher::CannotAttachHandler& )
+        {
+            /*
+             * UseSignal() built the message from errno where sigaction()
+             * failed. errno is stale by now, so rethrow the original.
+             */
+            GetFdHandlerEntry( fileDescriptor )->store( 0 ) ;
+            mFdSignalList.erase( fileDescriptor ) ;
+            throw ;
+        }
+        catch( ... )
+        {
+            GetFdHandlerEntry( fileDescriptor )->store( 0 ) ;
+            mFdSignalList.erase( fileDescriptor ) ;
+            throw PosixSignalDispatcher::CannotAttachHandler( "Cannot install the signal dispatcher." ) ;
+        }
+        return ;
+    }
+
+    inline
+    void
+    PosixSignalDispatcherImpl::DetachHandler(
+        const int                 posixSignalNumber,
+        const int                 fileDescriptor,
+        const PosixSignalHandler& signalHandler )
+    throw( PosixSignalDispatcher::CannotDetachHandler,
+           std::logic_error )
+    {
+        DispatcherLock dispatcher_lock( mDispatcherMutex ) ;
+        if ( ! IsRealTimeSignal( posixSignalNumber ) )
+        {
+            this->DetachHandler( posixSignalNumber,
+                                 signalHandler ) ;
+            return ;
+        }
+        /*
+         * Do nothing if the handler is not attached to the file
+         * descriptor.
+         */
+        FdSignalList::iterator fd_signal = mFdSignalList.find( fileDescriptor ) ;
+        if ( ( mFdSignalList.end() == fd_signal ) ||
+             ( posixSignalNumber != fd_signal->second ) ||
+             ( &signalHandler != GetFdHandlerEntry( fileDescriptor )->load() ) )
+        {
+            return ;
+        }
+        GetFdHandlerEntry( fileDescriptor )->store( 0 ) ;
+        mFdSignalList.erase( fd_signal ) ;
+        /*
+         * Wait until no signal handler that may still have seen the
+         * old entry is running.
+         */
+        while( mNumOfActiveFdHandlerCalls.load() > 0 )
+        {
+            sched_yield() ;
+        }
+        this->ReleaseSignal( SIGIO ) ;
+        this->ReleaseSignal( posixSignalNumber ) ;
+        return ;
+    }
+
+    inline
+    void
+    PosixSignalDispatcherImpl::UseSignal( const int posixSignalNumber )
+    throw( PosixSignalDispatcher::CannotAttachHandler )
+    {
+        unsigned& use_count = mSignalUseCountList[ posixSignalNumber ] ;
+        if ( use_count > 0 )
+        {
+            ++use_count ;
+            return ;
+        }
+        /*
+         * Attach this instance of PosixSignalDispatcher to the specified
+         * signal. SA_SIGINFO gives us the file descriptor that caused
+         * a real-time signal.
+         */
+        struct sigaction sigaction_info ;
+        sigaction_info.sa_sigaction = PosixSignalDispatcherImpl::SigactionHandler ;
+        sigemptyset( &sigaction_info.sa_mask ) ;
+        sigaction_info.sa_flags = SA_SIGINFO ;
+        /*
+         * Install the handler and get a copy of the previous handler.
+         */
+        struct sigaction old_action ;
+        if ( sigaction( posixSignalNumber,
+                        &sigaction_info,
+                        &old_action ) < 0 )
+        {
+            throw PosixSignalDispatcher::CannotAttachHandler( strerror(errno) ) ;
+        }
+        /*
+         * Save a copy of the old handler if it is not PosixSignalDispatcher::SignalHandler.
+         */
+        if ( ( 0 == ( old_action.sa_flags & SA_SIGINFO ) ) ||
+             ( PosixSignalDispatcherImpl::SigactionHandler != old_action.sa_sigaction ) )
+        {
+            mOriginalSigactionList[ posixSignalNumber ] = old_action ;
+        }
+        use_count = 1 ;
+        return ;
+    }
+
+    inline
+    void
+    PosixSignalDispatcherImpl::ReleaseSignal( const int posixSignalNumber )
+    throw( PosixSignalDispatcher::CannotDetachHandler,
+           std::logic_error )
+    {
+        SignalUseCountList::iterator use_count =
+            mSignalUseCountList.find( posixSignalNumber ) ;
+        if ( ( mSignalUseCountList.end() == use_count ) ||
+             ( 0 == use_count->second ) )
+        {
+            throw std::logic_error( "Signal dispatcher in invalid state." ) ;
+        }
+        if ( --use_count->second > 0 )
+        {
+            return ;
+        }
+        /*
+         * Real-time signals that were queued for a file descriptor before
+         * its handler was detached may still be pending. Their default
+         * action terminates the process, so the dispatcher stays installed
+         * for real-time signals. It ignores signals without a handler.
+         */
+        if ( IsRealTimeSignal( posixSignalNumber ) )
+        {
+            return ;
+        }
+        /*
+         * Retrieve the original sigaction corresponding to the signal.
+         */
+        OriginalSigactionList::iterator original_sigaction =
+            mOriginalSigactionList.find( posixSignalNumber ) ;
+        /*
+         * If the signal dispatcher implementation is correct,
+         * then we should always find the original sigaction.
+         * If we do not find one, we throw an exception.
+         */
+        if ( mOriginalSigactionList.end() == original_sigaction )
+        {
+            throw std::logic_error( "Signal dispatcher in invalid state." ) ;
+        }
+        /*
+         * Install the original handler. Throw an exception if we
+         * encounter any error.
+         */
+        if ( sigaction( posixSignalNumber,
+                        &original_sigaction->second,
+                        NULL ) < 0 )
+        {
+            throw PosixSignalDispatcher::CannotDetachHandler( strerror(errno) ) ;
+        }
+        return ;
+    }
+
+    inline
+    std::atomic<PosixSignalHandler*>*
+    PosixSignalDispatcherImpl::GetFdHandlerEntry( const int fileDescriptor )
+    {
+        FdHandlerChunk* chunk =
+            mFdHandlerTable[ fileDescriptor / FD_HANDLER_CHUNK_SIZE ].load() ;
+        if ( 0 == chunk )
+        {
+            return 0 ;
+        }
+        return &chunk->mHandlers[ fileDescriptor % FD_HANDLER_CHUNK_SIZE ] ;
+    }
+
+
+    inline
+    void
+    PosixSignalDispatcherImpl::EnableDispatcherThread( const int posixSignalNumber )
+    throw( std::runtime_error )
+    {
+        DispatcherLock dispatcher_lock( mDispatcherMutex ) ;
+        sigset_t signal_set ;
+        sigemptyset( &signal_set ) ;
+        if ( sigaddset( &signal_set,
+                        posixSignalNumber ) < 0 )
+        {
+            throw std::runtime_error( strerror(errno) ) ;
+        }
+        /*
+         * Block the signal in the calling thread. Threads created by it
+         * afterwards inherit the signal mask.
+         */
+        sigset_t old_signal_mask ;
+        int error_number = pthread_sigmask( SIG_BLOCK,
+                                            &signal_set,
+                                            &old_signal_mask ) ;
+        if ( 0 != error_number )
+        {
+            throw std::runtime_error( strerror(error_number) ) ;
+        }
+        /*
+         * Add the signal to the signalfd, creating it if necessary.
+         */
+        sigset_t dispatcher_thread_signals = mDispatcherThreadSignals ;
+        sigaddset( &dispatcher_thread_signals,
+                   posixSignalNumber ) ;
+        const int signal_fd = signalfd( mSignalFileDescriptor,
+                                        &dispatcher_thread_signals,
+                                        ( mSignalFileDescriptor < 0 ) ? SFD_CLOEXEC : 0 ) ;
+        if ( signal_fd < 0 )
+        {
+            error_number = errno ;
+            pthread_sigmask( SIG_SETMASK,
+                             &old_signal_mask,
+                             NULL ) ;
+            throw std::runtime_error( strerror(error_number) ) ;
+        }
+        mDispatcherThreadSignals = dispatcher_thread_signals ;
+        if ( mSignalFileDescriptor >= 0 )
+        {
+            return ;
+        }
+        /*
+         * Start the dispatcher thread. It is never stopped.
+         */
+        mSignalFileDescriptor = signal_fd ;
+        pthread_attr_t thread_attributes ;
+        pthread_attr_init( &thread_attributes ) ;
+        pthread_attr_setdetachstate( &thread_attributes,
+                                     PTHREAD_CREATE_DETACHED ) ;
+        pthread_t dispatcher_thread ;
+        error_number = pthread_create( &dispatcher_thread,
+                                       &thread_attributes,
+                                       &PosixSignalDispatcherImpl::DispatcherThread,
+                                       this ) ;
+        pthread_attr_destroy( &thread_attributes ) ;
+        if ( 0 != error_number )
+        {
+            close( mSignalFileDescriptor ) ;
+            mSignalFileDescriptor = -1 ;
+            sigemptyset( &mDispatcherThreadSignals ) ;
+            pthread_sigmask( SIG_SETMASK,
+                             &old_signal_mask,
+                             NULL ) ;
+            throw std::runtime_error( strerror(error_number) ) ;
+        }
+        return ;
+    }
+
+    inline
+    bool
+    PosixSignalDispatcherImpl::IsDispatcherThreadEnabled( const int posixSignalNumber )
+    {
+        DispatcherLock dispatcher_lock( mDispatcherMutex ) ;
+        return ( 1 == sigismember( &mDispatcherThreadSignals,
+                                   posixSignalNumber ) ) ;
+    }
+
+    void*
+    PosixSignalDispatcherImpl::DispatcherThread( void* posixSignalDispatcherImpl )
+    {
+        static_cast<PosixSignalDispatcherImpl*>( posixSignalDispatcherImpl )->DispatcherLoop() ;
+        return 0 ;
+    }
+
+    inline
+    void
+    PosixSignalDispatcherImpl::DispatcherLoop()
+    {
+        /*
+         * Read as many pending signals as possible at once and dispatch
+         * them while holding the dispatcher mutex, so that handlers are
+         * never called after they have been detached.
+         */
+        const size_t MAX_NUM_OF_SIGNALS = 32 ;
+        struct signalfd_siginfo signal_info[ MAX_NUM_OF_SIGNALS ] ;
+        while( true )
+        {
+            const ssize_t num_of_bytes = read( mSignalFileDescriptor,
+                                               signal_info,
+                                               sizeof( signal_info ) ) ;
+            if ( num_of_bytes < 0 )
             {
-                /*
-                 * Retrieve the original sigaction corresponding to the signal.
-                 */
-                OriginalSigactionList::iterator original_sigaction =
-                    mOriginalSigactionList.find( posixSignalNumber ) ;
-                /*
-                 * If the signal dispatcher implementation is correct,
-                 * then we should always find the original sigaction.
-                 * If we do not find one, we throw an exception.
-                 */
-                if ( mOriginalSigactionList.end() == original_sigaction )
+                if ( EINTR == errno )
                 {
-                    throw std::logic_error( "Signal dispatcher in invalid state." ) ;
-                }
-                /*
-                 * Install the original handler. Throw an exception if we
-                 * encounter any error.
-                 */
-                if ( sigaction( posixSignalNumber,
-                                &original_sigaction->second,
-                                NULL ) < 0 )
-                {
-                    throw PosixSignalDispatcher::CannotDetachHandler( strerror(errno) ) ;
+                    continue ;
                 }
+                return ;
+            }
+            DispatcherLock dispatcher_lock( mDispatcherMutex ) ;
+            const size_t num_of_signals =
+                static_cast<size_t>( num_of_bytes ) / sizeof( signal_info[0] ) ;
+            for( size_t i=0; i<num_of_signals; ++i )
+            {
+                DispatchSignal( signal_info[i].ssi_signo,
+                                signal_info[i].ssi_code,
+                                signal_info[i].ssi_fd ) ;
             }
         }
-        return ;
     }
 
+    void
+    PosixSignalDispatcherImpl::SigactionHandler( int        signalNumber,
+                                                 siginfo_t* signalInfo,
+                                                 void*      /* context */ )
+    {
+        /*
+         * Exceptions must not be thrown from a signal handler, so
+         * signals we know nothing about are simply passed on to the
+         * handlers attached to them, if any.
+         */
+        mNumOfActiveFdHandlerCalls.fetch_add( 1 ) ;
+        DispatchSignal( signalNumber,
+                        ( signalInfo ? signalInfo->si_code : 0 ),
+                        ( signalInfo ? signalInfo->si_fd : -1 ) ) ;
+        mNumOfActiveFdHandlerCalls.fetch_sub( 1 ) ;
+        return ;
+    }
 
     void
-    PosixSignalDispatcherImpl::SigactionHandler( int signalNumber )
+    PosixSignalDispatcherImpl::DispatchSignal( const int signalNumber,
+                                               const int signalCode,
+                                               const int fileDescriptor )
     {
         /*
-         * If we got a signal other than SIGIO here then throw an exception. 
-         * This was suggested by Oliver Schwaneberg via the patch at:
-         *
-         * https://sourceforge.net/p/libserial/patches/3/
+         * A real-time signal raised by the kernel for a file descriptor
+         * (see fcntl(F_SETSIG)) carries the file descriptor in si_fd.
+         * Only the handler of that file descriptor needs to be called.
          */
-        if (signalNumber != SIGIO)
+        if ( IsRealTimeSignal( signalNumber ) &&
+             ( signalCode >= POLL_IN ) &&
+             ( signalCode <= POLL_HUP ) &&
+             ( fileDescriptor >= 0 ) &&
+             ( fileDescriptor < mFdHandlerTableSize.load() ) )
         {
-            std::stringstream err_msg ; 
-            err_msg << "Invalid or unexpected signal: " << signalNumber ;
-            throw std::runtime_error(err_msg.str()) ;
+            std::atomic<PosixSignalHandler*>* fd_handler_entry =
+                GetFdHandlerEntry( fileDescriptor ) ;
+            PosixSignalHandler* fd_handler =
+                ( fd_handler_entry ? fd_handler_entry->load() : 0 ) ;
+            if ( 0 != fd_handler )
+            {
+                fd_handler->HandlePosixSignal( signalNumber ) ;
+                return ;
+            }
+        }
+        /*
+         * SIGIO is raised instead of a real-time signal when the queue of
+         * real-time signals overflows. We do not know which file
+         * descriptors are affected, so we call the handlers of all of
+         * them.
+         */
+        if ( SIGIO == signalNumber )
+        {
+            const int table_size = mFdHandlerTableSize.load() ;
+            for( int fd=0; fd<table_size; ++fd )
+            {
+                std::atomic<PosixSignalHandler*>* fd_handler_entry =
+                    GetFdHandlerEntry( fd ) ;
+                PosixSignalHandler* fd_handler =
+                    ( fd_handler_entry ? fd_handler_entry->load() : 0 ) ;
+                if ( 0 != fd_handler )
+                {
+                    fd_handler->HandlePosixSignal( signalNumber ) ;
+                }
+            }
         }
 
         /*
@@ -112,6 +112,88 @@ public:
                         const PosixSignalHandler& signalHandler )
         throw( CannotDetachHandler,
                std::logic_error ) ;
+
+    /**
+     * @brief Attaches a signal handler for the signals that the kernel
+     *        raises for a single file descriptor. The caller is expected
+     *        to select the signal for the file descriptor with
+     *        fcntl(F_SETSIG).
+     *
+     *        If posixSignalNumber is a real-time signal, the dispatcher
+     *        uses the si_fd field of the signal to look up the handler
+     *        of the file descriptor in constant time and only calls that
+     *        handler. Real-time signals are queued, so no notification
+     *        is lost when several file descriptors become ready at the
+     *        same time. When the queue of real-time signals overflows,
+     *        the kernel raises SIGIO instead; the dispatcher then calls
+     *        the handlers of all file descriptors.
+     *
+     *        For any other signal number the handler is attached exactly
+     *        as with AttachHandler( posixSignalNumber, signalHandler )
+     *        because standard signals are not queued and do not reliably
+     *        identify the file descriptor.
+     *
+     *        At most one handler can be attached to a file descriptor.
+     *
+     * @param posixSignalNumber The signal raised for the file descriptor.
+     * @param fileDescriptor The file descriptor.
+     * @param signalHandler The signal handler to be invoked.
+     * @throw CannotAttachHandler This exception is thrown if the method
+     *        cannot attach the handler.
+     */
+    void AttachHandler( const int           posixSignalNumber,
+                        const int           fileDescriptor,
+                        PosixSignalHandler& signalHandler )
+        throw( CannotAttachHandler ) ;
+
+    /**
+     * @brief Detaches a signal handler that was attached to a file
+     *        descriptor using AttachHandler( posixSignalNumber,
+     *        fileDescriptor, signalHandler ).
+     * @throw CannotDetachHandler This exception is thrown if the method cannot
+     *        detach the handler.
+     * @throw std::logic_error This exception is thrown if any standard logic
+     *        error is encountered.
+     */
+    void DetachHandler( const int                 posixSignalNumber,
+                        const int                 fileDescriptor,
+                        const PosixSignalHandler& signalHandler )
+        throw( CannotDetachHandler,
+               std::logic_error ) ;
+
+    /**
+     * @brief Calls the signal handlers attached to the specified signal
+     *        on a dedicated dispatcher thread instead of in signal
+     *        context. The signal is blocked in the calling thread and
+     *        read with signalfd() by the dispatcher thread, which is
+     *        started on the first call. Handlers called by the
+     *        dispatcher thread may take locks and do blocking work, and
+     *        the signal no longer interrupts application threads.
+     *
+     *        Signal masks are per thread, so this method should be called
+     *        from the main thread before any other thread is created.
+     *        Threads that do not block the signal still receive it and
+     *        call the handlers in signal context as before. The mode
+     *        cannot be turned off again.
+     *
+     *        A SerialPort using a real-time signal (see
+     *        SerialPort::SetInputSignal()) also needs SIGIO to be handled
+     *        by the dispatcher thread, because SIGIO is raised when the
+     *        queue of real-time signals overflows.
+     *
+     * @param posixSignalNumber The signal to be handled by the dispatcher
+     *        thread.
+     * @throw std::runtime_error This exception is thrown if the signal is
+     *        invalid or the dispatcher thread cannot be started.
+     */
+    void EnableDispatcherThread( const int posixSignalNumber )
+        throw( std::runtime_error ) ;
+
+    /**
+     * @brief Returns true if the handlers of the specified signal are
+     *        called on the dispatcher thread.
+     */
+    bool IsDispatcherThreadEnabled( const int posixSignalNumber ) const ;
 private:
     /**
      * @brief This is a singleton class and the only instances of this class
@@ -0,0 +1,499 @@
+/******************************************************************************
+ *   @file RingBuffer.h                                                       *
+ *   @copyright                                                               *
+ *                                                                            *
+ *   This program is free software; you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published by     *
+ *   the Free Software Foundation; either version 2 of the License, or        *
+ *   (at your option) any later version.                                      *
+ *                                                                            *
+ *   This program is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *   GNU General Public License for more details.                             *
+ *                                                                            *
+ *   You should have received a copy of the GNU General Public License        *
+ *   along with this program; if not, write to the                            *
+ *   Free Software Foundation, Inc.,                                          *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.                *
+ *****************************************************************************/
+
+#ifndef _RingBuffer_h_
+#define _RingBuffer_h_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <sys/uio.h>
+
+/**
+ * @brief Fixed-capacity, single-producer/single-consumer byte queue.
+ *
+ *        All storage is allocated by the constructor. Afterwards the
+ *        producer side (Push()) neither locks nor allocates, which makes
+ *        it safe to use from a signal handler. The consumer side may be
+ *        used concurrently with the producer but callers must make sure
+ *        that at most one thread acts as the consumer at any time.
+ *
+ *        The read and write positions are free running counters. Their
+ *        difference is the number of bytes stored in the buffer and they
+ *        are mapped onto the storage by masking with (capacity - 1). The
+ *        capacity is therefore always a power of two.
+ *
+ *        The producer may also drop the oldest data with Discard() to
+ *        make room for new data. Read() copes with this by copying the
+ *        data before it releases it and starting over if the producer
+ *        discarded data in the meantime. The other consumer methods must
+ *        not be used while the producer may call Discard().
+ */
+class RingBuffer
+{
+public:
+    /**
+     * @brief The largest capacity of a ring buffer, i.e. the largest
+     *        power of two that a size_t can hold.
+     */
+    static const size_t MAX_CAPACITY = ~( ~static_cast<size_t>( 0 ) >> 1 ) ;
+
+    /**
+     * @brief Creates a ring buffer that can hold at least the specified
+     *        number of bytes. The capacity is rounded up to the next
+     *        power of two.
+     * @throw std::length_error This exception is thrown if minCapacity
+     *        exceeds MAX_CAPACITY.
+     * @throw std::bad_alloc This exception is thrown if the storage
+     *        cannot be allocated.
+     */
+    explicit RingBuffer( const size_t minCapacity ) ;
+
+    /**
+     * @brief Frees the storage of the ring buffer.
+     */
+    ~RingBuffer() ;
+
+    /**
+     * @brief Returns the maximum number of bytes the buffer can hold.
+     */
+    size_t
+    Capacity() const ;
+
+    /**
+     * @brief Returns the number of bytes currently stored in the buffer.
+     *        The value may be stale by the time it is used if the other
+     *        side is active.
+     */
+    size_t
+    Size() const ;
+
+    /**
+     * @brief Returns true iff the buffer holds no data.
+     */
+    bool
+    IsEmpty() const ;
+
+    /**
+     * @brief Returns the total number of bytes added to the buffer since
+     *        it was created or cleared.
+     */
+    size_t
+    GetWritePosition() const ;
+
+    /**
+     * @brief Returns the total number of bytes removed from the buffer,
+     *        including discarded bytes, since it was created or cleared.
+     */
+    size_t
+    GetReadPosition() const ;
+
+    /**
+     * @brief Discards all data in the buffer. Must not be called while
+     *        either the producer or the consumer is active.
+     */
+    void
+    Clear() ;
+
+    /**
+     * @brief Discards all data in the buffer and changes its capacity to
+     *        at least minCapacity bytes, rounded up to the next power of
+     *        two. Must not be called while either the producer or the
+     *        consumer is active.
+     * @throw std::length_error This exception is thrown if minCapacity
+     *        exceeds MAX_CAPACITY. The buffer is left unchanged.
+     * @throw std::bad_alloc This exception is thrown if the storage
+     *        cannot be allocated. The buffer is left unchanged.
+     */
+    void
+    SetCapacity( const size_t minCapacity ) ;
+
+    /**
+     * @brief Producer side. Appends one byte to the buffer.
+     * @return Returns false if the buffer is full.
+     */
+    bool
+    Push( const unsigned char dataByte ) ;
+
+    /**
+     * @brief Producer side. Describes the free space of the buffer as up
+     *        to two contiguous regions that can be passed to readv(). The
+     *        second region is only used when the free space wraps around
+     *        the end of the storage; otherwise its length is zero. Data
+     *        placed in the regions becomes visible to the consumer after
+     *        a call to CommitWrite().
+     * @return Returns the total number of bytes described by the regions.
+     */
+    size_t
+    GetWriteRegions( struct iovec regions[2] ) ;
+
+    /**
+     * @brief Producer side. Publishes the first numOfBytes bytes of the
+     *        regions returned by the last call to GetWriteRegions().
+     */
+    void
+    CommitWrite( const size_t numOfBytes ) ;
+
+    /**
+     * @brief Producer side. Appends up to maxNumOfBytes bytes from
+     *        dataBuffer to the buffer using at most two memcpy() calls.
+     * @return Returns the number of bytes copied. This is less than
+     *         maxNumOfBytes if the buffer is full.
+     */
+    size_t
+    Write( const unsigned char* dataBuffer,
+           const size_t         maxNumOfBytes ) ;
+
+    /**
+     * @brief Producer side. Removes up to maxNumOfBytes of the oldest
+     *        bytes from the buffer to make room for new data.
+     * @return Returns the number of bytes removed. This is less than
+     *         maxNumOfBytes if the buffer holds less data.
+     */
+    size_t
+    Discard( const size_t maxNumOfBytes ) ;
+
+    /**
+     * @brief Consumer side. Describes the data in the buffer, oldest byte
+     *        first, as up to two contiguous regions. The second region is
+     *        only used when the data wraps around the end of the storage;
+     *        otherwise its length is zero. The data stays in the buffer
+     *        until it is removed with Pop(), Read() or Consume().
+     * @return Returns the total number of bytes described by the regions.
+     */
+    size_t
+    GetReadRegions( struct iovec regions[2] ) const ;
+
+    /**
+     * @brief Consumer side. Removes the oldest byte from the buffer.
+     * @return Returns false if the buffer is empty.
+     */
+    bool
+    Pop( unsigned char& dataByte ) ;
+
+    /**
+     * @brief Consumer side. Removes up to maxNumOfBytes of the oldest
+     *        bytes from the buffer and copies them to dataBuffer using at
+     *        most two memcpy() calls. May be used while the producer calls
+     *        Discard().
+     * @param readPosition If not null, receives the position (see
+     *        GetReadPosition()) of the first byte copied.
+     * @return Returns the number of bytes copied.
+     */
+    size_t
+    Read( unsigned char* dataBuffer,
+          const size_t   maxNumOfBytes,
+          size_t*        readPosition = 0 ) ;
+
+    /**
+     * @brief Consumer side. Removes the oldest numOfBytes bytes from the
+     *        buffer without copying them, e.g. after they have been
+     *        processed in place through GetReadRegions(). numOfBytes must
+     *        not exceed Size().
+     */
+    void
+    Consume( const size_t numOfBytes ) ;
+
+private:
+    /**
+     * @brief Copying is not allowed. This method is never defined.
+     */
+    RingBuffer( const RingBuffer& otherRingBuffer ) ;
+
+    /**
+     * @brief Copying is not allowed. This method is never defined.
+     */
+    RingBuffer& operator=( const RingBuffer& otherRingBuffer ) ;
+
+    /**
+     * @brief Storage for the buffered data.
+     */
+    unsigned char* mBuffer ;
+
+    /**
+     * @brief Capacity of mBuffer. Always a power of two.
+     */
+    size_t mCapacity ;
+
+    /**
+     * @brief Position of the next byte to be written. Only modified by
+     *        the producer.
+     */
+    std::atomic<size_t> mWritePosition ;
+
+    /**
+     * @brief Position of the next byte to be read. Only modified by
+     *        the consumer, except by Discard().
+     */
+    std::atomic<size_t> mReadPosition ;
+} ;
+
+inline
+RingBuffer::RingBuffer( const size_t minCapacity ) :
+    mBuffer(0),
+    mCapacity(1),
+    mWritePosition(0),
+    mReadPosition(0)
+{
+    this->SetCapacity( minCapacity ) ;
+}
+
+inline
+RingBuffer::~RingBuffer()
+{
+    delete [] mBuffer ;
+}
+
+inline
+size_t
+RingBuffer::Capacity() const
+{
+    return mCapacity ;
+}
+
+inline
+size_t
+RingBuffer::Size() const
+{
+    //
+    // Read the consumer position first so that the difference can never
+    // exceed the capacity.
+    //
+    const size_t read_position = mReadPosition.load( std::memory_order_acquire ) ;
+    return mWritePosition.load( std::memory_order_acquire ) - read_position ;
+}
+
+inline
+bool
+RingBuffer::IsEmpty() const
+{
+    return ( 0 == this->Size() ) ;
+}
+
+inline
+size_t
+RingBuffer::GetWritePosition() const
+{
+    return mWritePosition.load( std::memory_order_acquire ) ;
+}
+
+inline
+size_t
+RingBuffer::GetReadPosition() const
+{
+    return mReadPosition.load( std::memory_order_acquire ) ;
+}
+
+inline
+void
+RingBuffer::Clear()
+{
+    mWritePosition.store( 0, std::memory_order_relaxed ) ;
+    mReadPosition.store( 0, std::memory_order_release ) ;
+}
+
+inline
+void
+RingBuffer::SetCapacity( const size_t minCapacity )
+{
+    //
+    // Doubling the capacity beyond MAX_CAPACITY would wrap to zero.
+    //
+    if ( minCapacity > MAX_CAPACITY )
+    {
+        throw std::length_error( "RingBuffer capacity too large." ) ;
+    }
+    size_t capacity = 1 ;
+    while ( capacity < minCapacity )
+    {
+        capacity <<= 1 ;
+    }
+    unsigned char* const buffer = new unsigned char[capacity] ;
+    delete [] mBuffer ;
+    mBuffer   = buffer ;
+    mCapacity = capacity ;
+    this->Clear() ;
+}
+
+inline
+bool
+RingBuffer::Push( const unsigned char dataByte )
+{
+    const size_t write_position = mWritePosition.load( std::memory_order_relaxed ) ;
+    if ( write_position - mReadPosition.load( std::memory_order_acquire ) >= mCapacity )
+    {
+        return false ;
+    }
+    mBuffer[ write_position & ( mCapacity - 1 ) ] = dataByte ;
+    //
+    // Publish the byte only after it has been stored.
+    //
+    mWritePosition.store( write_position + 1, std::memory_order_release ) ;
+    return true ;
+}
+
+inline
+size_t
+RingBuffer::GetWriteRegions( struct iovec regions[2] )
+{
+    const size_t write_position = mWritePosition.load( std::memory_order_relaxed ) ;
+    const size_t free_space     = mCapacity -
+        ( write_position - mReadPosition.load( std::memory_order_acquire ) ) ;
+    const size_t offset         = write_position & ( mCapacity - 1 ) ;
+    const size_t first_length   = std::min( free_space, mCapacity - offset ) ;
+    regions[0].iov_base = mBuffer + offset ;
+    regions[0].iov_len  = first_length ;
+    regions[1].iov_base = mBuffer ;
+    regions[1].iov_len  = free_space - first_length ;
+    return free_space ;
+}
+
+inline
+void
+RingBuffer::CommitWrite( const size_t numOfBytes )
+{
+    mWritePosition.store( mWritePosition.load( std::memory_order_relaxed ) + numOfBytes,
+                          std::memory_order_release ) ;
+}
+
+inline
+size_t
+RingBuffer::Write( const unsigned char* dataBuffer,
+                   const size_t         maxNumOfBytes )
+{
+    struct iovec free_regions[2] ;
+    const size_t num_of_bytes = std::min( maxNumOfBytes,
+                                          this->GetWriteRegions( free_regions ) ) ;
+    const size_t first_length = std::min( num_of_bytes,
+                                          free_regions[0].iov_len ) ;
+    std::memcpy( free_regions[0].iov_base,
+                 dataBuffer,
+                 first_length ) ;
+    std::memcpy( free_regions[1].iov_base,
+                 dataBuffer + first_length,
+                 num_of_bytes - first_length ) ;
+    this->CommitWrite( num_of_bytes ) ;
+    return num_of_bytes ;
+}
+
+inline
+size_t
+RingBuffer::Discard( const size_t maxNumOfBytes )
+{
+    //
+    // The consumer may release data at the same time, so only move the
+    // read position if it has not changed in the meantime.
+    //
+    const size_t write_position = mWritePosition.load( std::memory_order_relaxed ) ;
+    size_t read_position = mReadPosition.load( std::memory_order_acquire ) ;
+    size_t num_of_bytes ;
+    do
+    {
+        num_of_bytes = std::min( maxNumOfBytes,
+                                 write_position - read_position ) ;
+    }
+    while( ! mReadPosition.compare_exchange_weak( read_position,
+                                                  read_position + num_of_bytes,
+                                                  std::memory_order_acq_rel ) ) ;
+    return num_of_bytes ;
+}
+
+inline
+size_t
+RingBuffer::GetReadRegions( struct iovec regions[2] ) const
+{
+    const size_t read_position = mReadPosition.load( std::memory_order_relaxed ) ;
+    const size_t num_of_bytes  =
+        mWritePosition.load( std::memory_order_acquire ) - read_position ;
+    const size_t offset        = read_position & ( mCapacity - 1 ) ;
+    const size_t first_length  = std::min( num_of_bytes, mCapacity - offset ) ;
+    regions[0].iov_base = mBuffer + offset ;
+    regions[0].iov_len  = first_length ;
+    regions[1].iov_base = mBuffer ;
+    regions[1].iov_len  = num_of_bytes - first_length ;
+    return num_of_bytes ;
+}
+
+inline
+bool
+RingBuffer::Pop( unsigned char& dataByte )
+{
+    const size_t read_position = mReadPosition.load( std::memory_order_relaxed ) ;
+    if ( mWritePosition.load( std::memory_order_acquire ) == read_position )
+    {
+        return false ;
+    }
+    dataByte = mBuffer[ read_position & ( mCapacity - 1 ) ] ;
+    //
+    // Release the slot only after the byte has been copied out.
+    //
+    mReadPosition.store( read_position + 1, std::memory_order_release ) ;
+    return true ;
+}
+
+inline
+size_t
+RingBuffer::Read( unsigned char* dataBuffer,
+                  const size_t   maxNumOfBytes,
+                  size_t*        readPosition )
+{
+    while( true )
+    {
+        size_t read_position = mReadPosition.load( std::memory_order_acquire ) ;
+        const size_t num_of_bytes  =
+            std::min( maxNumOfBytes,
+                      mWritePosition.load( std::memory_order_acquire ) - read_position ) ;
+        const size_t offset        = read_position & ( mCapacity - 1 ) ;
+        const size_t first_length  = std::min( num_of_bytes, mCapacity - offset ) ;
+        std::memcpy( dataBuffer,
+                     mBuffer + offset,
+                     first_length ) ;
+        std::memcpy( dataBuffer + first_length,
+                     mBuffer,
+                     num_of_bytes - first_length ) ;
+        //
+        // Release the data only if the producer has not discarded any of
+        // it while it was being copied. Otherwise the copy may contain
+        // newer data and has to be repeated.
+        //
+        if ( mReadPosition.compare_exchange_strong( read_position,
+                                                    read_position + num_of_bytes,
+                                                    std::memory_order_acq_rel ) )
+        {
+            if ( 0 != readPosition )
+            {
+                *readPosition = read_position ;
+            }
+            return num_of_bytes ;
+        }
+    }
+}
+
+inline
+void
+RingBuffer::Consume( const size_t numOfBytes )
+{
+    mReadPosition.store( mReadPosition.load( std::memory_order_relaxed ) + numOfBytes,
+                         std::memory_order_release ) ;
+}
+
+#endif // #ifndef _RingBuffer_h_
@@ -22,20 +22,29 @@
 #include "SerialPort.h"
 #include "PosixSignalDispatcher.h"
 #include "PosixSignalHandler.h"
-#include <queue>
+#include "LatencyHistogram.h"
+#include "RingBuffer.h"
+#include "SerialReactor.h"
+#include "SerialReactorHandler.h"
+#include <atomic>
 // #include <map>
-// #include <cerrno>
+#include <cerrno>
 // #include <cassert>
 // #include <termios.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
-#include <sys/time.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
+#include <time.h>
 // #include <strings.h>
 #include <cstring>
 // #include <cstdlib>
 #include <iostream>
+#include <new>
 
 namespace
 {
@@ -43,27 +52,189 @@ namespace
     // Various error messages used in this file while throwing
     // exceptions.
     //
-    const std::string ERR_MSG_PORT_NOT_OPEN        = "Serial port not open." ;
-    const std::string ERR_MSG_PORT_ALREADY_OPEN    = "Serial port already open." ;
-    const std::string ERR_MSG_UNSUPPORTED_BAUD     = "Unsupported baud rate." ;
-    const std::string ERR_MSG_UNKNOWN_BAUD         = "Unknown baud rate." ;
-    const std::string ERR_MSG_INVALID_PARITY       = "Invalid parity setting." ;
-    const std::string ERR_MSG_INVALID_STOP_BITS    = "Invalid number of stop bits." ;
-    const std::string ERR_MSG_INVALID_FLOW_CONTROL = "Invalid flow control." ;
+    const std::string ERR_MSG_PORT_NOT_OPEN         = "Serial port not open." ;
+    const std::string ERR_MSG_PORT_ALREADY_OPEN     = "Serial port already open." ;
+    const std::string ERR_MSG_UNSUPPORTED_BAUD      = "Unsupported baud rate." ;
+    const std::string ERR_MSG_UNKNOWN_BAUD          = "Unknown baud rate." ;
+    const std::string ERR_MSG_INVALID_PARITY        = "Invalid parity setting." ;
+    const std::string ERR_MSG_INVALID_STOP_BITS     = "Invalid number of stop bits." ;
+    const std::string ERR_MSG_INVALID_FLOW_CONTROL  = "Invalid flow control." ;
+    const std::string ERR_MSG_EMPTY_LINE_TERMINATOR = "Empty line terminator." ;
+    const std::string ERR_MSG_ASYNC_WRITE_ENABLED   = "Asynchronous writes already enabled." ;
+    const std::string ERR_MSG_ASYNC_WRITE_DISABLED  = "Asynchronous writes not enabled." ;
+    const std::string ERR_MSG_INVALID_QUEUE_SIZE    = "Invalid asynchronous write buffer size." ;
+    const std::string ERR_MSG_ASYNC_WRITE_ALLOC     = "Cannot allocate the asynchronous write queue." ;
+    const std::string ERR_MSG_INVALID_INPUT_SIGNAL  = "Input signal must be SIGIO or a real-time signal." ;
+    const std::string ERR_MSG_INVALID_BUFFER_SIZE   = "Invalid input buffer capacity." ;
+    const std::string ERR_MSG_INPUT_BUFFER_ALLOC    = "Cannot allocate an input buffer of this capacity." ;
+    const std::string ERR_MSG_REACTOR_ATTACHED      = "Serial port already attached to a reactor." ;
+    const std::string ERR_MSG_REACTOR_NOT_ATTACHED  = "Serial port not attached to this reactor." ;
+    const std::string ERR_MSG_INVALID_MIN_READABLE  = "Minimum number of bytes exceeds the input buffer capacity." ;
+    const std::string ERR_MSG_NOT_ACQUIRED          = "No input data acquired by this thread." ;
+    const std::string ERR_MSG_ALREADY_ACQUIRED      = "Input data already acquired by this thread." ;
+    const std::string ERR_MSG_INVALID_COMMIT        = "Number of bytes committed exceeds the number of bytes acquired." ;
+
+    //
+    // Default number of bytes that can be held in the input buffer of
+    // a serial port.
+    //
+    const size_t INPUT_BUFFER_SIZE = 64 * 1024 ;
+
+    //
+    // Size of the buffer that data is read into when the input buffer
+    // is full and a drop policy is in effect.
+    //
+    const size_t INPUT_OVERFLOW_BUFFER_SIZE = 4096 ;
+
+    //
+    // Maximum number of chunks of received data whose arrival time is
+    // kept. The arrival time of chunks arriving while this many are
+    // waiting to be read is not kept.
+    //
+    const size_t MAX_NUM_OF_INPUT_TIMESTAMPS = 4096 ;
+
+    //
+    // Deadline value used for operations that wait indefinitely.
+    //
+    const long long NO_DEADLINE = -1 ;
+
+    //
+    // Interval in milliseconds at which the asynchronous writer thread
+    // checks whether it has been asked to stop while it is waiting for
+    // the serial port to accept more data.
+    //
+    const unsigned int ASYNC_WRITER_POLL_INTERVAL = 100 ;
+
+    /*
+     * Return the current time of the monotonic clock in nanoseconds.
+     * Unlike the time of day, this clock is not affected by changes to
+     * the system time and is therefore suitable for timeouts.
+     */
+    long long
+    GetMonotonicTime() ;
+
+    /*
+     * Return the absolute deadline (in terms of GetMonotonicTime())
+     * that lies msTimeout milliseconds in the future. If msTimeout is
+     * zero, NO_DEADLINE is returned.
+     */
+    long long
+    GetDeadline( const unsigned int msTimeout ) ;
+
+    /*
+     * Return the timeout argument for poll() that makes it return no
+     * later than the specified deadline. The time left is rounded up to
+     * whole milliseconds. Return -1 if deadline is NO_DEADLINE and 0 if
+     * the deadline has passed.
+     */
+    int
+    GetPollTimeout( const long long deadline ) ;
+
+    /*
+     * Search the first numOfBytes bytes described by regions (as
+     * returned by RingBuffer::GetReadRegions()) for the end of a line.
+     * lineStart contains the part of the line that has already been
+     * removed from the buffer so that a terminator split across the two
+     * can be found. memchr() is used to find candidates for the last
+     * character of the terminator.
+     *
+     * Return the number of bytes from the regions up to and including
+     * the line terminator, or 0 if the line terminator was not found.
+     */
+    size_t
+    FindLineEnd( const struct iovec regions[2],
+                 const size_t       numOfBytes,
+                 const std::string& lineStart,
+                 const std::string& lineTerminator ) ;
+
+    /*
+     * Modify the specified termios structure to use the specified
+     * setting. These functions do not apply the settings to a serial
+     * port; the caller passes the modified structure to tcsetattr().
+     */
+    void
+    ApplyBaudRate( termios&                   portSettings,
+                   const SerialPort::BaudRate baudRate )
+        throw( SerialPort::UnsupportedBaudRate ) ;
+
+    void
+    ApplyCharSize( termios&                        portSettings,
+                   const SerialPort::CharacterSize charSize ) ;
+
+    void
+    ApplyParity( termios&                 portSettings,
+                 const SerialPort::Parity parityType )
+        throw( std::invalid_argument ) ;
+
+    void
+    ApplyNumOfStopBits( termios&                   portSettings,
+                        const SerialPort::StopBits numOfStopBits )
+        throw( std::invalid_argument ) ;
+
+    void
+    ApplyFlowControl( termios&                      portSettings,
+                      const SerialPort::FlowControl flowControl )
+        throw( std::invalid_argument ) ;
+
+    void
+    ApplyPortSettings( termios&                        portSettings,
+                       const SerialPort::PortSettings& newSettings )
+        throw( SerialPort::UnsupportedBaudRate,
+               std::invalid_argument ) ;
+
+    /*
+     * Extract the individual settings from the specified termios
+     * structure.
+     */
+    SerialPort::BaudRate
+    ExtractBaudRate( const termios& portSettings ) ;
+
+    SerialPort::CharacterSize
+    ExtractCharSize( const termios& portSettings ) ;
+
+    SerialPort::Parity
+    ExtractParity( const termios& portSettings ) ;
+
+    SerialPort::StopBits
+    ExtractNumOfStopBits( const termios& portSettings ) ;
+
+    SerialPort::FlowControl
+    ExtractFlowControl( const termios& portSettings ) ;
+
+    /*
+     * Add value to a statistics counter. The counters are only read for
+     * diagnostic purposes, so no ordering is required. AddToCounter()
+     * avoids the cost of an atomic read-modify-write operation and may
+     * only be used for counters that are never updated by two threads
+     * at the same time. IncrementSharedCounter() may be used from any
+     * thread.
+     */
+    void
+    AddToCounter( std::atomic<unsigned long long>& counter,
+                  const unsigned long long         value = 1 ) ;
+
+    void
+    IncrementSharedCounter( std::atomic<unsigned long long>& counter ) ;
 
     /*
-     * Return the difference between the two specified timeval values.
-     * This method subtracts secondOperand from firstOperand and returns
-     * the result as a timeval. The time represented by firstOperand must
-     * be later than the time represented by secondOperand. Otherwise,
-     * the result of this operator may be undefined.
+     * Locks the specified mutex for the lifetime of the object. This
+     * makes sure that the mutex is released if an exception is thrown
+     * while it is held.
      */
-    const struct timeval
-    operator-( const struct timeval& firstOperand,
-               const struct timeval& secondOperand ) ;
+    class MutexLock
+    {
+    public:
+        explicit MutexLock( pthread_mutex_t& mutex ) ;
+        ~MutexLock() ;
+    private:
+        MutexLock( const MutexLock& otherMutexLock ) ;
+        MutexLock& operator=( const MutexLock& otherMutexLock ) ;
+        pthread_mutex_t& mMutex ;
+    } ;
 }
 
-class SerialPort::SerialPortImpl : public PosixSignalHandler
+class SerialPort::SerialPortImpl : public PosixSignalHandler,
+                                   public SerialReactorHandler
 {
 public:
     /**
@@ -77,11 +248,13 @@ public:
     ~SerialPortImpl() ;
 
     /**
-     * Open the serial port.
+     * Open the serial port and apply the specified settings.
      */
-    void Open()
+    void Open( const SerialPort::PortSettings& portSettings )
         throw( SerialPort::OpenFailed,
-               SerialPort::AlreadyOpen ) ;
+               SerialPort::AlreadyOpen,
+               SerialPort::UnsupportedBaudRate,
+               std::invalid_argument ) ;
 
     /**
      * Check if the serial port is currently open.
@@ -89,6 +262,67 @@ public:
     bool
     IsOpen() const ;
 
+    /**
+     * Select the signal used to detect incoming data.
+     */
+    void
+    SetInputSignal( const int signalNumber )
+        throw( SerialPort::AlreadyOpen,
+               std::invalid_argument ) ;
+
+    int
+    GetInputSignal() const ;
+
+    void
+    SetInputBufferCapacity( const size_t capacity )
+        throw( SerialPort::AlreadyOpen,
+               std::invalid_argument ) ;
+
+    size_t
+    GetInputBufferCapacity() const ;
+
+    void
+    SetInputOverflowPolicy( const SerialPort::InputOverflowPolicy overflowPolicy ) ;
+
+    SerialPort::InputOverflowPolicy
+    GetInputOverflowPolicy() const ;
+
+    unsigned long long
+    GetNumOfDroppedInputBytes() const ;
+
+    unsigned long long
+    GetNumOfInputBackpressureEvents() const ;
+
+    size_t
+    GetInputBufferHighWaterMark() const ;
+
+    void
+    ResetInputBufferCounters() ;
+
+    SerialPort::Statistics
+    GetStatistics() const ;
+
+    void
+    ResetStatistics() ;
+
+    void
+    EnableInputLatencyHistogram() ;
+
+    void
+    DisableInputLatencyHistogram() ;
+
+    bool
+    IsInputLatencyHistogramEnabled() const ;
+
+    unsigned long long
+    GetNumOfInputLatencySamples() const ;
+
+    long long
+    GetInputLatencyPercentile( const double percentile ) const ;
+
+    void
+    ResetInputLatencyHistogram() ;
+
     /**
      * Close the serial port.
      */
@@ -159,6 +393,24 @@ public:
     GetFlowControl() const
         throw( SerialPort::NotOpen ) ;
 
+    void
+    SetPortSettings( const SerialPort::PortSettings& portSettings,
+                     const bool                      drain )
+        throw( SerialPort::NotOpen,
+               SerialPort::UnsupportedBaudRate,
+               std::invalid_argument,
+               std::runtime_error ) ;
+
+    SerialPort::PortSettings
+    GetPortSettings() const
+        throw( SerialPort::NotOpen,
+               std::runtime_error ) ;
+
+    void
+    RefreshPortSettings()
+        throw( SerialPort::NotOpen,
+               std::runtime_error ) ;
+
     bool
     IsDataAvailable() const
         throw( SerialPort::NotOpen,
@@ -170,19 +422,57 @@ public:
                SerialPort::ReadTimeout,
                std::runtime_error ) ;
 
+    /**
+     * If arrivalTimes is not null, the arrival times of the data read
+     * are appended to it.
+     */
+    void
+    Read( SerialPort::DataBuffer&   dataBuffer,
+          const unsigned int        numOfBytes,
+          const unsigned int        msTimeout,
+          SerialPort::ArrivalTimes* arrivalTimes = 0 )
+        throw( SerialPort::NotOpen,
+               SerialPort::ReadTimeout,
+               std::runtime_error  ) ;
+
+    size_t
+    Read( unsigned char*            dataBuffer,
+          const size_t              numOfBytes,
+          const unsigned int        msTimeout,
+          SerialPort::ArrivalTimes* arrivalTimes = 0 )
+        throw( SerialPort::NotOpen,
+               std::runtime_error ) ;
+
     void
-    Read( SerialPort::DataBuffer& dataBuffer,
+    Peek( SerialPort::DataBuffer& dataBuffer,
           const unsigned int      numOfBytes,
           const unsigned int      msTimeout )
         throw( SerialPort::NotOpen,
                SerialPort::ReadTimeout,
-               std::runtime_error  ) ;
+               std::invalid_argument,
+               std::runtime_error ) ;
+
+    size_t
+    AcquireReadable( SerialPort::ReadableRegion regions[2],
+                     const size_t               minNumOfBytes,
+                     const unsigned int         msTimeout )
+        throw( SerialPort::NotOpen,
+               SerialPort::ReadTimeout,
+               std::invalid_argument,
+               std::logic_error,
+               std::runtime_error ) ;
+
+    void
+    CommitReadable( const size_t numOfBytes )
+        throw( std::logic_error ) ;
 
-    const std::string
-    ReadLine( const unsigned int msTimeout = 0,
-              const char         lineTerminator = '\n' )
+    std::string
+    ReadLine( const unsigned int msTimeout,
+              const std::string& lineTerminator,
+              const size_t       maxLength )
         throw( SerialPort::NotOpen,
                SerialPort::ReadTimeout,
+               std::invalid_argument,
                std::runtime_error ) ;
 
     void
@@ -191,16 +481,46 @@ public:
                std::runtime_error ) ;
 
     void
-    Write(const SerialPort::DataBuffer& dataBuffer)
+    Write( const SerialPort::DataBuffer& dataBuffer,
+           const unsigned int            msTimeout )
         throw( SerialPort::NotOpen,
+               SerialPort::WriteTimeout,
                std::runtime_error ) ;
 
     void
+    Write( const std::string& dataString,
+           const unsigned int msTimeout )
+        throw( SerialPort::NotOpen,
+               SerialPort::WriteTimeout,
+               std::runtime_error ) ;
+
+    size_t
     Write( const unsigned char* dataBuffer,
-           const unsigned int   bufferSize )
+           const size_t         bufferSize,
+           const unsigned int   msTimeout )
+        throw( SerialPort::NotOpen,
+               std::runtime_error ) ;
+
+    void
+    EnableAsyncWrite( SerialPort::WriteCompletionHandler* completionHandler,
+                      const size_t                        bufferSize,
+                      const size_t                        maxNumOfRequests )
         throw( SerialPort::NotOpen,
+               std::logic_error,
                std::runtime_error ) ;
 
+    void
+    DisableAsyncWrite() ;
+
+    unsigned long
+    WriteAsync( const unsigned char* dataBuffer,
+                const size_t         numOfBytes )
+        throw( SerialPort::NotOpen,
+               std::logic_error ) ;
+
+    bool
+    WaitForAsyncWrites( const unsigned int msTimeout ) ;
+
     void
     SetDtr( const bool dtrState )
         throw( SerialPort::NotOpen,
@@ -237,6 +557,27 @@ public:
      */
     void
     HandlePosixSignal(int signalNumber) ;
+
+    void
+    AttachReactor( SerialReactor& serialReactor )
+        throw( SerialPort::NotOpen,
+               std::logic_error,
+               std::runtime_error ) ;
+
+    void
+    DetachReactor( SerialReactor& serialReactor )
+        throw( std::logic_error,
+               std::runtime_error ) ;
+
+    /*
+     * These methods must be defined by all subclasses of
+     * SerialReactorHandler.
+     */
+    void
+    HandleInputReady() ;
+
+    void
+    HandleReactorShutdown() ;
 private:
     /**
      * Name of the serial port. On POSIX systems this is the name of
@@ -261,584 +602,2094 @@ private:
      */
     termios mOldPortSettings ;
 
+    /**
+     * Copy of the settings currently applied to the serial port. It is
+     * updated with tcgetattr() whenever the settings are changed so
+     * that the Get*() methods do not need to query the driver.
+     * Protected by mPortSettingsMutex.
+     */
+    termios mPortSettings ;
+
+    /*
+     * Mutex used to serialize access to mPortSettings.
+     */
+    mutable pthread_mutex_t mPortSettingsMutex ;
+
     /**
      * Circular buffer used to store the received data. This is done
      * asynchronously and helps prevent overflow of the corresponding 
      * tty's input buffer.
-     * 
-     * :TODO: The size of this buffer is allowed to increase indefinitely. If 
-     * data keeps arriving at the serial port and is never read then this 
-     * buffer will continue occupying more and more memory. We need to put a 
-     * cap on the size of this buffer. It might even be worth providing a 
-     * method to set the size of this buffer.  
+     *
+     * The buffer has a fixed capacity and is filled by FillInputBuffer()
+     * without taking any locks or allocating memory, so it can safely be
+     * filled from the SIGIO handler. When the buffer is full, the
+     * remaining data is left in the tty's input buffer and is picked up
+     * once a reader has made room.
      */
-    std::queue<unsigned char> mInputBuffer ;
+    RingBuffer mInputBuffer ;
 
     /*
-     * In order to be thread save, a second queue is implemented to store
-     * byte which are received while the queue is locked by the
-     * ReadByte method. The content must be transfered to mInputBuffer
-     * before further bytes are stored into it.
+     * Mutex used to serialize readers of mInputBuffer. Only one
+     * thread may remove data from the ring buffer at a time. A reader
+     * releases this mutex while it waits for data. The producer side
+     * never takes this mutex.
      */
-    std::queue<unsigned char> mShadowInputBuffer ;
+    mutable pthread_mutex_t mQueueMutex ;
 
     /*
-     * Mutex to control threaded access to mInputBuffer
+     * Readers that wait for data take turns to poll mWakeupPipe, which
+     * the producer can write to even from a signal handler. The reader
+     * that polls sets mIsReaderPolling; the others wait on
+     * mInputDataCondition, which is broadcast whenever poll() returns.
+     * Both are protected by mQueueMutex.
      */
-    pthread_mutex_t mQueueMutex;
+    pthread_cond_t mInputDataCondition ;
+    bool mIsReaderPolling ;
 
     /*
-     * Indicates if unread bytes are available within the queue
+     * Mutex used to serialize writers so that the data passed to one
+     * call to Write() is not interleaved with the data of another
+     * even if it has to be written in several parts.
      */
-    volatile bool mIsQueueDataAvailable;
+    pthread_mutex_t mWriteMutex ;
 
-    /**
-     * Set the specified modem control line to the specified value. 
-     *
-     * @param modemLine One of the following four values: TIOCM_DTR,
-     * TIOCM_RTS, TIOCM_CTS, or TIOCM_DSR.
-     *
-     * @param lineState State of the modem line after successful
-     * call to this method.
+    /*
+     * Pipe used to wake up readers that are waiting for data. The
+     * producer writes a byte to mWakeupPipe[1] after it has added data
+     * to mInputBuffer and readers wait for mWakeupPipe[0] to become
+     * readable. Writing to a pipe is async-signal-safe, so this also
+     * works if the producer is the SIGIO handler. Both ends are
+     * non-blocking.
      */
-    void
-    SetModemControlLine( const int modemLine,
-                         const bool lineState )
-        throw( SerialPort::NotOpen,
-               std::runtime_error ) ;
+    int mWakeupPipe[2] ;
 
-    /**
-     * Get the current state of the specified modem control line.
-     * 
-     * @param modemLine One of the following four values: TIOCM_DTR,
-     * TIOCM_RTS, TIOCM_CTS, or TIOCM_DSR.
-     *
-     * @return True if the specified line is currently set and false
-     * otherwise.
+    /*
+     * True while a thread is executing FillInputBuffer(). This makes
+     * sure that the ring buffer only ever has one producer even if
+     * SIGIO is delivered to several threads at the same time or a
+     * reader refills the buffer while the signal handler runs.
      */
-    bool
-    GetModemControlLine( const int modemLine ) const
-        throw( SerialPort::NotOpen,
-               std::runtime_error ) ;        
-} ;
+    std::atomic<bool> mIsFillingInputBuffer ;
 
-SerialPort::SerialPort( const std::string& serialPortName ) :
-    mSerialPortImpl(new SerialPortImpl(serialPortName) )
-{
-    /* empty */
-}
+    /*
+     * Set by FillInputBuffer() when it could not run because another
+     * thread was already filling the buffer. The thread that is
+     * filling the buffer checks this flag before it returns and
+     * repeats the fill so that no data is left behind.
+     */
+    std::atomic<bool> mIsFillPending ;
 
-SerialPort::~SerialPort()
-    throw()
-{
     /*
-     * Close the serial port if it is open.
+     * Set by FillInputBuffer() when data had to be left in the tty's
+     * input buffer because mInputBuffer was full. Readers refill the
+     * buffer after removing data from it when this flag is set.
      */
-    if ( this->IsOpen() )
-    {
-        this->Close() ;
-    }
+    std::atomic<bool> mHasPendingKernelData ;
+
     /*
-     * Free the memory allocated to the implementation instance.
+     * True while a reader accesses the data of mInputBuffer in place
+     * between AcquireInputBuffer() and ReleaseInputBuffer(), e.g. from
+     * AcquireReadable() to CommitReadable(). The reader holds
+     * mQueueMutex for the whole time. FillInputBuffer() must not
+     * discard data from mInputBuffer while this flag is set.
      */
-    if ( mSerialPortImpl )
-    {
-        delete mSerialPortImpl ;
-    }
-    return ;
-}
+    std::atomic<bool> mIsInputBufferAcquired ;
 
-void
-SerialPort::Open( const BaudRate      baudRate,
-                  const CharacterSize charSize,
-                  const Parity        parityType,
-                  const StopBits      stopBits,
-                  const FlowControl   flowControl )
-    throw( OpenFailed,
-           AlreadyOpen,
-           UnsupportedBaudRate,
-           std::invalid_argument )
-{
-    //
-    // Open the serial port.
-    mSerialPortImpl->Open() ;
-    //
-    // Set the various parameters of the serial port if it is open.
-    //
-    this->SetBaudRate(baudRate) ;
-    this->SetCharSize(charSize) ;
-    this->SetParity(parityType) ;
-    this->SetNumOfStopBits(stopBits) ;
-    this->SetFlowControl(flowControl) ;
+    /*
+     * True from AcquireReadable() to CommitReadable(). mReadableOwner
+     * is the thread that called AcquireReadable() and therefore holds
+     * mQueueMutex; it is set before the flag. mNumOfAcquiredBytes is
+     * the number of bytes returned by AcquireReadable().
+     */
+    std::atomic<bool> mIsReadableAcquired ;
+    std::atomic<pthread_t> mReadableOwner ;
+    size_t mNumOfAcquiredBytes ;
 
-    //
-    // All done.
-    //
-    return ;
-}
+    /*
+     * What FillInputBuffer() does when mInputBuffer is full.
+     */
+    std::atomic<int> mInputOverflowPolicy ;
 
-bool
-SerialPort::IsOpen() const
-{
-    return mSerialPortImpl->IsOpen() ;
-}
+    /*
+     * Data that arrives while mInputBuffer is full is read into this
+     * buffer if it is going to be dropped. Only used by the thread
+     * executing FillInputBuffer().
+     */
+    std::vector<unsigned char> mInputOverflowBuffer ;
 
-void
-SerialPort::Close()
-    throw(NotOpen)
-{
-    mSerialPortImpl->Close() ;
-    return ;
-}
+    /*
+     * Counters of the input buffer. They are only updated by the
+     * thread executing FillInputBuffer().
+     */
+    std::atomic<unsigned long long> mNumOfDroppedInputBytes ;
+    std::atomic<unsigned long long> mNumOfInputBackpressureEvents ;
+    std::atomic<size_t> mInputBufferHighWaterMark ;
 
-void
-SerialPort::SetBaudRate( const BaudRate baudRate )
-    throw( UnsupportedBaudRate,
-           NotOpen,
+    /*
+     * Counters returned by GetStatistics(). The counters of the input
+     * side are updated by the thread executing FillInputBuffer(), those
+     * of the output side while mWriteMutex is held and those of the
+     * readers while mQueueMutex is held.
+     */
+    std::atomic<unsigned long long> mNumOfBytesReceived ;
+    std::atomic<unsigned long long> mNumOfBytesTransmitted ;
+    std::atomic<unsigned long long> mNumOfReadCalls ;
+    std::atomic<unsigned long long> mNumOfWriteCalls ;
+    std::atomic<unsigned long long> mNumOfInputSignals ;
+    std::atomic<unsigned long long> mNumOfReactorEvents ;
+    std::atomic<unsigned long long> mNumOfFillContentions ;
+    std::atomic<unsigned long long> mNumOfReaderWakeups ;
+    std::atomic<unsigned long long> mNumOfReadTimeouts ;
+    std::atomic<unsigned long long> mNumOfWriteTimeouts ;
+
+    /*
+     * The arrival time of a chunk of data in mInputBuffer. mEndPosition
+     * is the write position of mInputBuffer after the last byte of the
+     * chunk.
+     */
+    struct InputTimestamp
+    {
+        size_t    mEndPosition ;
+        long long mArrivalTime ;
+    } ;
+
+    /*
+     * Arrival times of the chunks in mInputBuffer, oldest first. Filled
+     * by FillInputBuffer() and emptied by readers. The capacity is a
+     * multiple of the size of an InputTimestamp, so an InputTimestamp is
+     * never split across the end of the buffer.
+     */
+    RingBuffer mInputTimestamps ;
+
+    /*
+     * mInputLatencyHistogram is created once by
+     * EnableInputLatencyHistogram() and kept until the instance is
+     * destroyed, so it can be used without a lock once it has been
+     * loaded. mIsInputLatencyEnabled is set after it has been created.
+     */
+    std::atomic<LatencyHistogram*> mInputLatencyHistogram ;
+    std::atomic<bool> mIsInputLatencyEnabled ;
+
+    /*
+     * A write queued by WriteAsync(). The data of the requests is stored
+     * in mAsyncWriteBuffer in the order of the requests.
+     */
+    struct AsyncWriteRequest
+    {
+        unsigned long mTicket ;
+        size_t        mNumOfBytes ;
+    } ;
+
+    /*
+     * Mutex that protects the state of asynchronous writes below and
+     * the producer side of mAsyncWriteBuffer. The writer thread
+     * consumes data from mAsyncWriteBuffer without holding it.
+     */
+    pthread_mutex_t mAsyncWriteMutex ;
+
+    /*
+     * Condition variable that is signaled whenever a request is queued
+     * or completed and when the writer thread is asked to stop. It uses
+     * the monotonic clock for timed waits.
+     */
+    pthread_cond_t mAsyncWriteCondition ;
+
+    /*
+     * The thread that writes the data queued by WriteAsync().
+     */
+    pthread_t mAsyncWriterThread ;
+
+    /*
+     * True while WriteAsync() accepts new requests.
+     */
+    bool mIsAsyncWriteEnabled ;
+
+    /*
+     * True while mAsyncWriterThread is running.
+     */
+    bool mIsAsyncWriterRunning ;
+
+    /*
+     * Set to ask the writer thread to discard all queued requests and
+     * exit. It is read by the writer thread without holding
+     * mAsyncWriteMutex while it is writing.
+     */
+    std::atomic<bool> mIsAsyncWriterStopping ;
+
+    /*
+     * Handler notified of completed asynchronous writes. May be 0.
+     */
+    SerialPort::WriteCompletionHandler* mWriteCompletionHandler ;
+
+    /*
+     * Data of the queued asynchronous writes. Allocated by
+     * EnableAsyncWrite().
+     */
+    RingBuffer* mAsyncWriteBuffer ;
+
+    /*
+     * Circular queue of asynchronous write requests. The oldest
+     * request is at index mFirstAsyncWriteRequest. Allocated by
+     * EnableAsyncWrite().
+     */
+    std::vector<AsyncWriteRequest> mAsyncWriteRequests ;
+    size_t mFirstAsyncWriteRequest ;
+    size_t mNumOfAsyncWriteRequests ;
+
+    /*
+     * Ticket assigned to the next asynchronous write. Never zero.
+     */
+    unsigned long mNextAsyncWriteTicket ;
+
+    /*
+     * The reactor the serial port is attached to or NULL if SIGIO is
+     * used to detect incoming data. Protected by mReactorMutex.
+     */
+    SerialReactor* mSerialReactor ;
+
+    /*
+     * Mutex protecting mSerialReactor. The reactor may call
+     * HandleReactorShutdown() while another thread closes the port or
+     * detaches it. It is never locked by HandleInputReady(), so the
+     * reactor may wait for that method while this mutex is held.
+     */
+    pthread_mutex_t mReactorMutex ;
+
+    /*
+     * The signal raised by the kernel when data arrives at the port.
+     */
+    int mInputSignal ;
+
+    /**
+     * Let the kernel raise mInputSignal when data arrives at the serial
+     * port and attach this instance to the signal dispatcher.
+     */
+    void
+    EnableSignalDrivenInput()
+        throw( std::runtime_error ) ;
+
+    /**
+     * Undo EnableSignalDrivenInput().
+     */
+    void
+    DisableSignalDrivenInput()
+        throw( std::runtime_error ) ;
+
+    /**
+     * Turn signal driven input back on and unregister from
+     * mSerialReactor, which must not be NULL. The caller must hold
+     * mReactorMutex.
+     */
+    void
+    SwitchFromReactorToSignal()
+        throw( std::runtime_error ) ;
+
+    /**
+     * Write data to the serial port until all of it has been written,
+     * the specified deadline has passed or an error occurs. The caller
+     * must hold mWriteMutex.
+     *
+     * @param numOfBytesWritten Set to the number of bytes written.
+     *
+     * @return 0 if all data was written, ETIMEDOUT if the deadline has
+     * passed, or the errno value of the error otherwise.
+     */
+    int
+    WriteData( const unsigned char* dataBuffer,
+               const size_t         bufferSize,
+               const long long      deadline,
+               size_t&              numOfBytesWritten ) ;
+
+    /**
+     * Entry point of mAsyncWriterThread. serialPortImpl points to the
+     * SerialPortImpl instance that started the thread.
+     */
+    static void*
+    AsyncWriterThread( void* serialPortImpl ) ;
+
+    /**
+     * Write the requests queued by WriteAsync() until the writer thread
+     * is asked to stop.
+     */
+    void
+    AsyncWriterLoop() ;
+
+    /**
+     * Stop the writer thread, discarding any queued requests, and free
+     * the memory used for asynchronous writes.
+     */
+    void
+    StopAsyncWriter() ;
+
+    /**
+     * Move the data that is currently available at the serial port
+     * into mInputBuffer. This is called from the SIGIO handler and by
+     * readers that have made room in a full input buffer.
+     */
+    void
+    FillInputBuffer() ;
+
+    /**
+     * Called by FillInputBuffer() when mInputBuffer is full. Applies
+     * mInputOverflowPolicy and returns true if FillInputBuffer() should
+     * continue to read from the serial port.
+     */
+    bool
+    HandleInputOverflow() ;
+
+    /**
+     * Remember that the next numOfBytes bytes added to mInputBuffer
+     * arrived at arrivalTime. Must be called by the producer of
+     * mInputBuffer before the data is added to it.
+     */
+    void
+    AddInputTimestamp( const size_t    numOfBytes,
+                       const long long arrivalTime ) ;
+
+    /**
+     * Append the arrival times of the numOfBytes bytes of mInputBuffer
+     * starting at readPosition to arrivalTimes. arrivalOffset is the
+     * offset of the first of these bytes in the caller's data. The
+     * caller must hold mQueueMutex.
+     */
+    void
+    AppendArrivalTimes( const size_t              readPosition,
+                        const size_t              numOfBytes,
+                        const size_t              arrivalOffset,
+                        SerialPort::ArrivalTimes& arrivalTimes ) const ;
+
+    /**
+     * Forget the arrival times of the chunks whose last byte has been
+     * removed from mInputBuffer and record their latency if the input
+     * latency is measured. The caller must hold mQueueMutex.
+     */
+    void
+    RemoveInputTimestamps() ;
+
+    /**
+     * Remove up to maxNumOfBytes bytes from mInputBuffer and copy them
+     * to dataBuffer. Data that had to be left in the tty because the
+     * input buffer was full is moved into the room made by this call.
+     * If arrivalTimes is not null, the arrival times of the bytes are
+     * appended to it with arrivalOffset added to their offsets. The
+     * caller must hold mQueueMutex.
+     *
+     * @return The number of bytes copied to dataBuffer.
+     */
+    size_t
+    ReadInputBuffer( unsigned char*            dataBuffer,
+                     const size_t              maxNumOfBytes,
+                     SerialPort::ArrivalTimes* arrivalTimes  = 0,
+                     const size_t              arrivalOffset = 0 ) ;
+
+    /**
+     * Keep FillInputBuffer() from discarding data from mInputBuffer so
+     * that the caller can access the data in place, and describe the
+     * data as up to two regions. The caller must hold mQueueMutex and
+     * call ReleaseInputBuffer() when it is done with the data.
+     *
+     * @return The total number of bytes described by the regions.
+     */
+    size_t
+    AcquireInputBuffer( struct iovec regions[2] ) ;
+
+    /**
+     * Undo AcquireInputBuffer(). Data that had to be left in the tty in
+     * the meantime is moved into the input buffer. The caller must hold
+     * mQueueMutex.
+     */
+    void
+    ReleaseInputBuffer() ;
+
+    /**
+     * Return true if the calling thread has acquired data with
+     * AcquireReadable() and not committed it yet.
+     */
+    bool
+    IsReadableAcquiredByThisThread() const ;
+
+    /**
+     * Wait until mInputBuffer contains at least minNumOfBytes bytes or
+     * the specified deadline (see GetDeadline()) has passed. The caller
+     * must hold mQueueMutex, which is released while waiting, so other
+     * readers may remove data in the meantime.
+     *
+     * @return True if the data is available and false if the deadline
+     * has passed.
+     */
+    bool
+    WaitForInputData( const long long deadline,
+                      const size_t    minNumOfBytes = 1 )
+        throw( std::runtime_error ) ;
+
+    /**
+     * Wait on mInputDataCondition until it is broadcast or the
+     * specified deadline has passed. The caller must hold mQueueMutex.
+     *
+     * @return False if the deadline has passed.
+     */
+    bool
+    WaitForInputDataCondition( const long long deadline ) ;
+
+    /**
+     * Apply the specified settings to the serial port and update
+     * mPortSettings with the settings actually used by the driver. The
+     * cache is updated even if tcsetattr() fails because the driver may
+     * have applied some of the settings. The caller must hold
+     * mPortSettingsMutex.
+     *
+     * @return 0 on success, otherwise the errno value of the failure.
+     */
+    int
+    WritePortSettings( const termios& portSettings,
+                       const int      optionalActions ) ;
+
+    /**
+     * Wait until the serial port can accept more data or the specified
+     * deadline (see GetDeadline()) has passed. The caller must hold
+     * mWriteMutex.
+     *
+     * @return 0 if the port is writable (or has an error condition
+     * that the next write() will report), ETIMEDOUT if the deadline has
+     * passed, or the errno value of a failed poll() otherwise.
+     */
+    int
+    WaitForOutputSpace( const long long deadline ) ;
+
+    /**
+     * Set the specified modem control line to the specified value. 
+     *
+     * @param modemLine One of the following four values: TIOCM_DTR,
+     * TIOCM_RTS, TIOCM_CTS, or TIOCM_DSR.
+     *
+     * @param lineState State of the modem line after successful
+     * call to this method.
+     */
+    void
+    SetModemControlLine( const int modemLine,
+                         const bool lineState )
+        throw( SerialPort::NotOpen,
+               std::runtime_error ) ;
+
+    /**
+     * Get the current state of the specified modem control line.
+     * 
+     * @param modemLine One of the following four values: TIOCM_DTR,
+     * TIOCM_RTS, TIOCM_CTS, or TIOCM_DSR.
+     *
+     * @return True if the specified line is currently set and false
+     * otherwise.
+     */
+    bool
+    GetModemControlLine( const int modemLine ) const
+        throw( SerialPort::NotOpen,
+               std::runtime_error ) ;        
+
+    /**
+     * Prevents copying of objects of this class by declaring the copy
+     * constructor and the assignment operator private. These methods
+     * are never defined.
+     */
+    SerialPortImpl( const SerialPortImpl& otherSerialPortImpl ) ;
+    SerialPortImpl& operator=( const SerialPortImpl& otherSerialPortImpl ) ;
+} ;
+
+SerialPort::SerialPort( const std::string& serialPortName ) :
+    mSerialPortImpl(new SerialPortImpl(serialPortName) )
+{
+    /* empty */
+}
+
+SerialPort::~SerialPort()
+    throw()
+{
+    /*
+     * Close the serial port if it is open.
+     */
+    if ( this->IsOpen() )
+    {
+        this->Close() ;
+    }
+    /*
+     * Free the memory allocated to the implementation instance.
+     */
+    if ( mSerialPortImpl )
+    {
+        delete mSerialPortImpl ;
+    }
+    return ;
+}
+
+void
+SerialPort::Open( const BaudRate      baudRate,
+                  const CharacterSize charSize,
+                  const Parity        parityType,
+                  const StopBits      stopBits,
+                  const FlowControl   flowControl )
+    throw( OpenFailed,
+           AlreadyOpen,
+           UnsupportedBaudRate,
            std::invalid_argument )
 {
-    mSerialPortImpl->SetBaudRate( baudRate ) ;
+    this->Open( PortSettings( baudRate,
+                              charSize,
+                              parityType,
+                              stopBits,
+                              flowControl ) ) ;
+    return ;
+}
+
+void
+SerialPort::Open( const PortSettings& portSettings )
+    throw( OpenFailed,
+           AlreadyOpen,
+           UnsupportedBaudRate,
+           std::invalid_argument )
+{
+    mSerialPortImpl->Open( portSettings ) ;
+    return ;
+}
+
+bool
+SerialPort::IsOpen() const
+{
+    return mSerialPortImpl->IsOpen() ;
+}
+
+void
+SerialPort::SetInputSignal( const int signalNumber )
+    throw( AlreadyOpen,
+           std::invalid_argument )
+{
+    mSerialPortImpl->SetInputSignal( signalNumber ) ;
+    return ;
+}
+
+int
+SerialPort::GetInputSignal() const
+{
+    return mSerialPortImpl->GetInputSignal() ;
+}
+
+void
+SerialPort::SetInputBufferCapacity( const size_t capacity )
+    throw( AlreadyOpen,
+           std::invalid_argument )
+{
+    mSerialPortImpl->SetInputBufferCapacity( capacity ) ;
+    return ;
+}
+
+size_t
+SerialPort::GetInputBufferCapacity() const
+{
+    return mSerialPortImpl->GetInputBufferCapacity() ;
+}
+
+void
+SerialPort::SetInputOverflowPolicy( const InputOverflowPolicy overflowPolicy )
+{
+    mSerialPortImpl->SetInputOverflowPolicy( overflowPolicy ) ;
     return ;
 }
 
-SerialPort::BaudRate
-SerialPort::GetBaudRate() const
-    throw( NotOpen,
-           std::runtime_error )
-{
-    return mSerialPortImpl->GetBaudRate() ;
-}
+SerialPort::InputOverflowPolicy
+SerialPort::GetInputOverflowPolicy() const
+{
+    return mSerialPortImpl->GetInputOverflowPolicy() ;
+}
+
+unsigned long long
+SerialPort::GetNumOfDroppedInputBytes() const
+{
+    return mSerialPortImpl->GetNumOfDroppedInputBytes() ;
+}
+
+unsigned long long
+SerialPort::GetNumOfInputBackpressureEvents() const
+{
+    return mSerialPortImpl->GetNumOfInputBackpressureEvents() ;
+}
+
+size_t
+SerialPort::GetInputBufferHighWaterMark() const
+{
+    return mSerialPortImpl->GetInputBufferHighWaterMark() ;
+}
+
+void
+SerialPort::ResetInputBufferCounters()
+{
+    mSerialPortImpl->ResetInputBufferCounters() ;
+    return ;
+}
+
+SerialPort::Statistics
+SerialPort::GetStatistics() const
+{
+    return mSerialPortImpl->GetStatistics() ;
+}
+
+void
+SerialPort::ResetStatistics()
+{
+    mSerialPortImpl->ResetStatistics() ;
+    return ;
+}
+
+void
+SerialPort::EnableInputLatencyHistogram()
+{
+    mSerialPortImpl->EnableInputLatencyHistogram() ;
+    return ;
+}
+
+void
+SerialPort::DisableInputLatencyHistogram()
+{
+    mSerialPortImpl->DisableInputLatencyHistogram() ;
+    return ;
+}
+
+bool
+SerialPort::IsInputLatencyHistogramEnabled() const
+{
+    return mSerialPortImpl->IsInputLatencyHistogramEnabled() ;
+}
+
+unsigned long long
+SerialPort::GetNumOfInputLatencySamples() const
+{
+    return mSerialPortImpl->GetNumOfInputLatencySamples() ;
+}
+
+long long
+SerialPort::GetInputLatencyPercentile( const double percentile ) const
+{
+    return mSerialPortImpl->GetInputLatencyPercentile( percentile ) ;
+}
+
+void
+SerialPort::ResetInputLatencyHistogram()
+{
+    mSerialPortImpl->ResetInputLatencyHistogram() ;
+    return ;
+}
+
+void
+SerialPort::Close()
+    throw(NotOpen)
+{
+    mSerialPortImpl->Close() ;
+    return ;
+}
+
+void
+SerialPort::SetBaudRate( const BaudRate baudRate )
+    throw( UnsupportedBaudRate,
+           NotOpen,
+           std::invalid_argument )
+{
+    mSerialPortImpl->SetBaudRate( baudRate ) ;
+    return ;
+}
+
+SerialPort::BaudRate
+SerialPort::GetBaudRate() const
+    throw( NotOpen,
+           std::runtime_error )
+{
+    return mSerialPortImpl->GetBaudRate() ;
+}
+
+
+void
+SerialPort::SetCharSize( const CharacterSize charSize )
+    throw( NotOpen,
+           std::invalid_argument )
+{
+    mSerialPortImpl->SetCharSize(charSize) ;
+}
+
+SerialPort::CharacterSize
+SerialPort::GetCharSize() const
+    throw(NotOpen)
+{
+    return mSerialPortImpl->GetCharSize() ;
+}
+
+void
+SerialPort::SetParity( const Parity parityType )
+    throw( NotOpen,
+           std::invalid_argument )
+{
+    mSerialPortImpl->SetParity( parityType ) ;
+    return ;
+}
+
+SerialPort::Parity
+SerialPort::GetParity() const
+    throw(NotOpen)
+{
+    return mSerialPortImpl->GetParity() ;
+}
+
+void
+SerialPort::SetNumOfStopBits( const StopBits numOfStopBits )
+    throw( NotOpen,
+           std::invalid_argument )
+{
+    mSerialPortImpl->SetNumOfStopBits(numOfStopBits) ;
+    return ;
+}
+
+SerialPort::StopBits
+SerialPort::GetNumOfStopBits() const
+    throw(NotOpen)
+{
+    return mSerialPortImpl->GetNumOfStopBits() ;
+}
+
+
+void
+SerialPort::SetFlowControl( const FlowControl   flowControl )
+    throw( NotOpen,
+           std::invalid_argument )
+{
+    mSerialPortImpl->SetFlowControl( flowControl ) ;
+    return ;
+}
+
+SerialPort::FlowControl
+SerialPort::GetFlowControl() const
+    throw( NotOpen )
+{
+    return mSerialPortImpl->GetFlowControl() ;
+}
+
+void
+SerialPort::SetPortSettings( const PortSettings& portSettings,
+                             const bool          drain )
+    throw( NotOpen,
+           UnsupportedBaudRate,
+           std::invalid_argument,
+           std::runtime_error )
+{
+    mSerialPortImpl->SetPortSettings( portSettings,
+                                      drain ) ;
+    return ;
+}
+
+SerialPort::PortSettings
+SerialPort::GetPortSettings() const
+    throw( NotOpen,
+           std::runtime_error )
+{
+    return mSerialPortImpl->GetPortSettings() ;
+}
+
+void
+SerialPort::RefreshPortSettings()
+    throw( NotOpen,
+           std::runtime_error )
+{
+    mSerialPortImpl->RefreshPortSettings() ;
+    return ;
+}
+
+bool
+SerialPort::IsDataAvailable() const
+    throw(NotOpen)
+{
+    return mSerialPortImpl->IsDataAvailable() ;
+}
+
+unsigned char
+SerialPort::ReadByte( const unsigned int msTimeout )
+    throw( NotOpen,
+           ReadTimeout,
+           std::runtime_error )
+{
+    return mSerialPortImpl->ReadByte(msTimeout) ;
+}
+
+void
+SerialPort::Read( SerialPort::DataBuffer& dataBuffer,
+                  const unsigned int      numOfBytes,
+                  const unsigned int      msTimeout )
+    throw( NotOpen,
+           ReadTimeout,
+           std::runtime_error )
+{
+    return mSerialPortImpl->Read( dataBuffer,
+                                  numOfBytes,
+                                  msTimeout ) ;
+}
+
+
+size_t
+SerialPort::Read( unsigned char*     dataBuffer,
+                  const size_t       numOfBytes,
+                  const unsigned int msTimeout )
+    throw( NotOpen,
+           std::runtime_error )
+{
+    return mSerialPortImpl->Read( dataBuffer,
+                                  numOfBytes,
+                                  msTimeout ) ;
+}
+
+
+void
+SerialPort::ReadWithTimestamps( DataBuffer&        dataBuffer,
+                                ArrivalTimes&      arrivalTimes,
+                                const unsigned int numOfBytes,
+                                const unsigned int msTimeout )
+    throw( NotOpen,
+           ReadTimeout,
+           std::runtime_error )
+{
+    arrivalTimes.clear() ;
+    return mSerialPortImpl->Read( dataBuffer,
+                                  numOfBytes,
+                                  msTimeout,
+                                  &arrivalTimes ) ;
+}
+
+
+void
+SerialPort::Peek( DataBuffer&        dataBuffer,
+                  const unsigned int numOfBytes,
+                  const unsigned int msTimeout )
+    throw( NotOpen,
+           ReadTimeout,
+           std::invalid_argument,
+           std::runtime_error )
+{
+    mSerialPortImpl->Peek( dataBuffer,
+                           numOfBytes,
+                           msTimeout ) ;
+}
+
+
+size_t
+SerialPort::AcquireReadable( ReadableRegion     regions[2],
+                             const size_t       minNumOfBytes,
+                             const unsigned int msTimeout )
+    throw( NotOpen,
+           ReadTimeout,
+           std::invalid_argument,
+           std::logic_error,
+           std::runtime_error )
+{
+    return mSerialPortImpl->AcquireReadable( regions,
+                                             minNumOfBytes,
+                                             msTimeout ) ;
+}
+
+
+void
+SerialPort::CommitReadable( const size_t numOfBytes )
+    throw( std::logic_error )
+{
+    mSerialPortImpl->CommitReadable( numOfBytes ) ;
+}
+
+
+std::string
+SerialPort::ReadLine( const unsigned int msTimeout,
+                      const char         lineTerminator,
+                      const size_t       maxLength )
+    throw( NotOpen,
+           ReadTimeout,
+           std::runtime_error )
+{
+    return mSerialPortImpl->ReadLine( msTimeout,
+                                      std::string( 1, lineTerminator ),
+                                      maxLength ) ;
+}
+
+
+std::string
+SerialPort::ReadLine( const unsigned int msTimeout,
+                      const std::string& lineTerminator,
+                      const size_t       maxLength )
+    throw( NotOpen,
+           ReadTimeout,
+           std::invalid_argument,
+           std::runtime_error )
+{
+    return mSerialPortImpl->ReadLine( msTimeout,
+                                      lineTerminator,
+                                      maxLength ) ;
+}
+
+
+void
+SerialPort::WriteByte( const unsigned char dataByte )
+    throw( SerialPort::NotOpen,
+           std::runtime_error )
+{
+    mSerialPortImpl->WriteByte( dataByte ) ;
+    return ;
+}
+
+
+void
+SerialPort::Write( const DataBuffer&  dataBuffer,
+                   const unsigned int msTimeout )
+    throw( NotOpen,
+           WriteTimeout,
+           std::runtime_error )
+{
+    mSerialPortImpl->Write( dataBuffer,
+                            msTimeout ) ;
+    return ;
+}
+
+void
+SerialPort::Write( const std::string& dataString,
+                   const unsigned int msTimeout )
+    throw( NotOpen,
+           WriteTimeout,
+           std::runtime_error )
+{
+    mSerialPortImpl->Write( dataString,
+                            msTimeout ) ;
+    return ;
+}
+
+size_t
+SerialPort::Write( const void*        dataBuffer,
+                   const size_t       numOfBytes,
+                   const unsigned int msTimeout )
+    throw( NotOpen,
+           std::runtime_error )
+{
+    return mSerialPortImpl->Write( static_cast<const unsigned char*>(dataBuffer),
+                                   numOfBytes,
+                                   msTimeout ) ;
+}
+
+void
+SerialPort::EnableAsyncWrite( WriteCompletionHandler* completionHandler,
+                              const size_t            bufferSize,
+                              const size_t            maxNumOfRequests )
+    throw( NotOpen,
+           std::logic_error,
+           std::runtime_error )
+{
+    mSerialPortImpl->EnableAsyncWrite( completionHandler,
+                                       bufferSize,
+                                       maxNumOfRequests ) ;
+    return ;
+}
+
+void
+SerialPort::DisableAsyncWrite()
+{
+    mSerialPortImpl->DisableAsyncWrite() ;
+    return ;
+}
+
+unsigned long
+SerialPort::WriteAsync( const void*  dataBuffer,
+                        const size_t numOfBytes )
+    throw( NotOpen,
+           std::logic_error )
+{
+    return mSerialPortImpl->WriteAsync( static_cast<const unsigned char*>(dataBuffer),
+                                        numOfBytes ) ;
+}
+
+bool
+SerialPort::WaitForAsyncWrites( const unsigned int msTimeout )
+{
+    return mSerialPortImpl->WaitForAsyncWrites( msTimeout ) ;
+}
+
+void
+SerialPort::SetDtr( const bool dtrState )
+    throw( SerialPort::NotOpen,
+           std::runtime_error ) 
+{
+    mSerialPortImpl->SetDtr( dtrState ) ;
+    return ;
+}
+
+bool
+SerialPort::GetDtr() const 
+    throw( SerialPort::NotOpen,
+           std::runtime_error ) 
+{
+    return mSerialPortImpl->GetDtr() ;
+}
+
+void
+SerialPort::SetRts( const bool rtsState )
+    throw( SerialPort::NotOpen,
+           std::runtime_error ) 
+{
+    mSerialPortImpl->SetRts( rtsState ) ;
+    return ;
+}
+
+bool
+SerialPort::GetRts() const 
+    throw( SerialPort::NotOpen,
+           std::runtime_error ) 
+{
+    return mSerialPortImpl->GetRts() ;
+}
+
+
+bool
+SerialPort::GetCts() const 
+    throw( SerialPort::NotOpen,
+           std::runtime_error ) 
+{
+    return mSerialPortImpl->GetCts() ;
+}
+
+bool
+SerialPort::GetDsr() const 
+    throw( SerialPort::NotOpen,
+           std::runtime_error ) 
+{
+    return mSerialPortImpl->GetDsr() ;
+}
+
+void
+SerialPort::AttachReactor( SerialReactor& serialReactor )
+    throw( NotOpen,
+           std::logic_error,
+           std::runtime_error )
+{
+    mSerialPortImpl->AttachReactor( serialReactor ) ;
+    return ;
+}
+
+void
+SerialPort::DetachReactor( SerialReactor& serialReactor )
+    throw( std::logic_error,
+           std::runtime_error )
+{
+    mSerialPortImpl->DetachReactor( serialReactor ) ;
+    return ;
+}
+
+/* ------------------------------------------------------------ */
+inline
+SerialPort::SerialPortImpl::SerialPortImpl( const std::string& serialPortName ) :
+    mSerialPortName(serialPortName),
+    mIsOpen(false),
+    mFileDescriptor(-1),
+    mOldPortSettings(),
+    mPortSettings(),
+    mPortSettingsMutex(),
+    mInputBuffer(INPUT_BUFFER_SIZE),
+    mQueueMutex(),
+    mInputDataCondition(),
+    mIsReaderPolling(false),
+    mWriteMutex(),
+    mWakeupPipe(),
+    mIsFillingInputBuffer(false),
+    mIsFillPending(false),
+    mHasPendingKernelData(false),
+    mIsInputBufferAcquired(false),
+    mIsReadableAcquired(false),
+    mReadableOwner(pthread_t()),
+    mNumOfAcquiredBytes(0),
+    mInputOverflowPolicy(SerialPort::INPUT_OVERFLOW_DEFAULT),
+    mInputOverflowBuffer(INPUT_OVERFLOW_BUFFER_SIZE),
+    mNumOfDroppedInputBytes(0),
+    mNumOfInputBackpressureEvents(0),
+    mInputBufferHighWaterMark(0),
+    mNumOfBytesReceived(0),
+    mNumOfBytesTransmitted(0),
+    mNumOfReadCalls(0),
+    mNumOfWriteCalls(0),
+    mNumOfInputSignals(0),
+    mNumOfReactorEvents(0),
+    mNumOfFillContentions(0),
+    mNumOfReaderWakeups(0),
+    mNumOfReadTimeouts(0),
+    mNumOfWriteTimeouts(0),
+    mInputTimestamps(MAX_NUM_OF_INPUT_TIMESTAMPS * sizeof( InputTimestamp )),
+    mInputLatencyHistogram(0),
+    mIsInputLatencyEnabled(false),
+    mAsyncWriteMutex(),
+    mAsyncWriteCondition(),
+    mAsyncWriterThread(),
+    mIsAsyncWriteEnabled(false),
+    mIsAsyncWriterRunning(false),
+    mIsAsyncWriterStopping(false),
+    mWriteCompletionHandler(0),
+    mAsyncWriteBuffer(0),
+    mAsyncWriteRequests(),
+    mFirstAsyncWriteRequest(0),
+    mNumOfAsyncWriteRequests(0),
+    mNextAsyncWriteTicket(1),
+    mSerialReactor(0),
+    mReactorMutex(),
+    mInputSignal(SIGIO)
+{
+	//Initializing the mutex
+	if ( (pthread_mutex_init(&mQueueMutex, NULL) != 0) ||
+         (pthread_mutex_init(&mWriteMutex, NULL) != 0) ||
+         (pthread_mutex_init(&mPortSettingsMutex, NULL) != 0) ||
+         (pthread_mutex_init(&mAsyncWriteMutex, NULL) != 0) ||
+         (pthread_mutex_init(&mReactorMutex, NULL) != 0) )
+    {
+		std::cerr << "SerialPort.cpp: Could not initialize mutex!" << std::endl;
+	}
+    //
+    // Timed waits for input data and asynchronous writes use the
+    // monotonic clock.
+    //
+    pthread_condattr_t condition_attributes ;
+    if ( ( pthread_condattr_init( &condition_attributes ) != 0 ) ||
+         ( pthread_condattr_setclock( &condition_attributes,
+                                      CLOCK_MONOTONIC ) != 0 ) ||
+         ( pthread_cond_init( &mInputDataCondition,
+                              &condition_attributes ) != 0 ) ||
+         ( pthread_cond_init( &mAsyncWriteCondition,
+                              &condition_attributes ) != 0 ) )
+    {
+        std::cerr << "SerialPort.cpp: Could not initialize condition variable!" << std::endl;
+    }
+    pthread_condattr_destroy( &condition_attributes ) ;
+    mWakeupPipe[0] = -1 ;
+    mWakeupPipe[1] = -1 ;
+}
+
+inline
+SerialPort::SerialPortImpl::~SerialPortImpl()
+{
+    //
+    // Close the serial port if it is open.
+    //
+    if ( this->IsOpen() )
+    {
+        this->Close() ;
+    }
+    delete mInputLatencyHistogram ;
+    return ;
+}
+
+inline
+void
+SerialPort::SerialPortImpl::Open( const SerialPort::PortSettings& portSettings )
+    throw( SerialPort::OpenFailed,
+           SerialPort::AlreadyOpen,
+           SerialPort::UnsupportedBaudRate,
+           std::invalid_argument )
+{
+    /*
+     * Throw an exception if the port is already open.
+     */
+    if ( this->IsOpen() )
+    {
+        throw SerialPort::AlreadyOpen( ERR_MSG_PORT_ALREADY_OPEN ) ;
+    }
+    //
+    // Assemble the new port settings before opening the port so that
+    // invalid settings are rejected without touching the port.
+    //
+    termios port_settings ;
+    bzero( &port_settings,
+           sizeof( port_settings ) ) ;
+
+    //
+    // Enable the receiver (CREAD) and ignore modem control lines
+    // (CLOCAL).
+    //
+    port_settings.c_cflag |= CREAD | CLOCAL ;
+
+    //
+    // Set the VMIN and VTIME parameters to zero by default. VMIN is
+    // the minimum number of characters for non-canonical read and
+    // VTIME is the timeout in deciseconds for non-canonical
+    // read. Setting both of these parameters to zero implies that a
+    // read will return immediately only giving the currently
+    // available characters.
+    //
+    port_settings.c_cc[ VMIN  ] = 0 ;
+    port_settings.c_cc[ VTIME ] = 0 ;
+
+    //
+    // Add the settings requested by the caller.
+    //
+    ApplyPortSettings( port_settings,
+                       portSettings ) ;
+    /*
+     * Try to open the serial port and throw an exception if we are
+     * not able to open it.
+     */
+    mFileDescriptor = open( mSerialPortName.c_str(),
+                            O_RDWR | O_NOCTTY | O_NONBLOCK ) ;
+    if ( mFileDescriptor < 0 )
+    {
+        throw SerialPort::OpenFailed( strerror(errno) )  ;
+    }
+
+    //
+    // Undo everything done so far if one of the following steps fails.
+    // mIsOpen is still false then, so neither Close() nor the
+    // destructor would release the port, the pipe or the signal
+    // handler.
+    //
+    bool is_signal_driven_input_enabled = false ;
+    bool is_old_port_settings_saved     = false ;
+    try
+    {
+        //
+        // Discard any data left over from a previous session before the
+        // signal handler starts filling the input buffer.
+        //
+        mInputBuffer.Clear() ;
+        mHasPendingKernelData = false ;
+        this->ResetStatistics() ;
+        mInputTimestamps.Clear() ;
+        this->ResetInputLatencyHistogram() ;
+
+        //
+        // Create the pipe used to wake up readers when data arrives.
+        //
+        if ( pipe( mWakeupPipe ) < 0 )
+        {
+            throw SerialPort::OpenFailed( strerror(errno) ) ;
+        }
+        for( int i=0; i<2; ++i )
+        {
+            if ( ( fcntl( mWakeupPipe[i],
+                          F_SETFL,
+                          O_NONBLOCK ) < 0 ) ||
+                 ( fcntl( mWakeupPipe[i],
+                          F_SETFD,
+                          FD_CLOEXEC ) < 0 ) )
+            {
+                throw SerialPort::OpenFailed( strerror(errno) ) ;
+            }
+        }
+
+        /*
+         * Direct all SIGIO and SIGURG signals for the port to the current
+         * process.
+         */
+        if ( fcntl( mFileDescriptor,
+                    F_SETOWN,
+                    getpid() ) < 0 )
+        {
+            throw SerialPort::OpenFailed( strerror(errno) ) ;
+        }
+
+        /*
+         * Enable asynchronous I/O with the serial port. The port is kept in
+         * non-blocking mode so that writes never block while the output
+         * buffer is full; Write() waits for the port with poll() instead.
+         */
+        try
+        {
+            this->EnableSignalDrivenInput() ;
+            is_signal_driven_input_enabled = true ;
+        }
+        catch( std::runtime_error& error )
+        {
+            throw SerialPort::OpenFailed( error.what() ) ;
+        }
+
+        /*
+         * Save the current settings of the serial port so they can be
+         * restored when the serial port is closed.
+         */
+        if ( tcgetattr( mFileDescriptor,
+                        &mOldPortSettings ) < 0 )
+        {
+            throw SerialPort::OpenFailed( strerror(errno) ) ;
+        }
+        is_old_port_settings_saved = true ;
 
+        /*
+         * Flush the input buffer associated with the port.
+         */
+        if ( tcflush( mFileDescriptor,
+                      TCIFLUSH ) < 0 )
+        {
+            throw SerialPort::OpenFailed( strerror(errno) ) ;
+        }
+        /*
+         * Write all of the new settings to the port at once.
+         */
+        MutexLock port_settings_lock( mPortSettingsMutex ) ;
+        const int error_number = this->WritePortSettings( port_settings,
+                                                          TCSANOW ) ;
+        if ( 0 != error_number )
+        {
+            throw SerialPort::OpenFailed( strerror(error_number) ) ;
+        }
+    }
+    catch( ... )
+    {
+        if ( is_signal_driven_input_enabled )
+        {
+            try
+            {
+                this->DisableSignalDrivenInput() ;
+            }
+            catch( std::runtime_error& )
+            {
+                //
+                // The port is closed below anyway.
+                //
+            }
+        }
+        if ( is_old_port_settings_saved )
+        {
+            tcsetattr( mFileDescriptor,
+                       TCSANOW,
+                       &mOldPortSettings ) ;
+        }
+        close(mFileDescriptor) ;
+        mFileDescriptor = -1 ;
+        for( int i=0; i<2; ++i )
+        {
+            if ( mWakeupPipe[i] >= 0 )
+            {
+                close(mWakeupPipe[i]) ;
+                mWakeupPipe[i] = -1 ;
+            }
+        }
+        throw ;
+    }
 
-void
-SerialPort::SetCharSize( const CharacterSize charSize )
-    throw( NotOpen,
-           std::invalid_argument )
-{
-    mSerialPortImpl->SetCharSize(charSize) ;
+    /*
+     * The serial port is open at this point.
+     */
+    mIsOpen = true ;
+    return ;
 }
 
-SerialPort::CharacterSize
-SerialPort::GetCharSize() const
-    throw(NotOpen)
+inline
+bool
+SerialPort::SerialPortImpl::IsOpen() const
 {
-    return mSerialPortImpl->GetCharSize() ;
+    return mIsOpen ;
 }
 
+inline
 void
-SerialPort::SetParity( const Parity parityType )
-    throw( NotOpen,
+SerialPort::SerialPortImpl::SetInputSignal( const int signalNumber )
+    throw( SerialPort::AlreadyOpen,
            std::invalid_argument )
 {
-    mSerialPortImpl->SetParity( parityType ) ;
+    if ( this->IsOpen() )
+    {
+        throw SerialPort::AlreadyOpen( ERR_MSG_PORT_ALREADY_OPEN ) ;
+    }
+    if ( ( SIGIO != signalNumber ) &&
+         ( ( signalNumber < SIGRTMIN ) ||
+           ( signalNumber > SIGRTMAX ) ) )
+    {
+        throw std::invalid_argument( ERR_MSG_INVALID_INPUT_SIGNAL ) ;
+    }
+    mInputSignal = signalNumber ;
     return ;
 }
 
-SerialPort::Parity
-SerialPort::GetParity() const
-    throw(NotOpen)
+inline
+int
+SerialPort::SerialPortImpl::GetInputSignal() const
 {
-    return mSerialPortImpl->GetParity() ;
+    return mInputSignal ;
 }
 
+inline
 void
-SerialPort::SetNumOfStopBits( const StopBits numOfStopBits )
-    throw( NotOpen,
+SerialPort::SerialPortImpl::SetInputBufferCapacity( const size_t capacity )
+    throw( SerialPort::AlreadyOpen,
            std::invalid_argument )
 {
-    mSerialPortImpl->SetNumOfStopBits(numOfStopBits) ;
+    //
+    // The input buffer is only reallocated while the serial port is
+    // closed because the signal handler fills it without locking.
+    //
+    if ( this->IsOpen() )
+    {
+        throw SerialPort::AlreadyOpen( ERR_MSG_PORT_ALREADY_OPEN ) ;
+    }
+    if ( ( 0 == capacity ) ||
+         ( capacity > RingBuffer::MAX_CAPACITY ) )
+    {
+        throw std::invalid_argument( ERR_MSG_INVALID_BUFFER_SIZE ) ;
+    }
+    //
+    // The old buffer is kept if the new one cannot be allocated.
+    //
+    try
+    {
+        mInputBuffer.SetCapacity( capacity ) ;
+    }
+    catch( const std::bad_alloc& )
+    {
+        throw std::invalid_argument( ERR_MSG_INPUT_BUFFER_ALLOC ) ;
+    }
     return ;
 }
 
-SerialPort::StopBits
-SerialPort::GetNumOfStopBits() const
-    throw(NotOpen)
+inline
+size_t
+SerialPort::SerialPortImpl::GetInputBufferCapacity() const
 {
-    return mSerialPortImpl->GetNumOfStopBits() ;
+    return mInputBuffer.Capacity() ;
 }
 
-
+inline
 void
-SerialPort::SetFlowControl( const FlowControl   flowControl )
-    throw( NotOpen,
-           std::invalid_argument )
+SerialPort::SerialPortImpl::SetInputOverflowPolicy(
+    const SerialPort::InputOverflowPolicy overflowPolicy )
 {
-    mSerialPortImpl->SetFlowControl( flowControl ) ;
+    mInputOverflowPolicy = overflowPolicy ;
+    //
+    // Data left in the tty by the previous policy is handled by the new
+    // one.
+    //
+    if ( mIsOpen &&
+         ( SerialPort::INPUT_OVERFLOW_BACKPRESSURE != overflowPolicy ) &&
+         mHasPendingKernelData.exchange( false ) )
+    {
+        this->FillInputBuffer() ;
+    }
     return ;
 }
 
-SerialPort::FlowControl
-SerialPort::GetFlowControl() const
-    throw( NotOpen )
-{
-    return mSerialPortImpl->GetFlowControl() ;
-}
-
-bool
-SerialPort::IsDataAvailable() const
-    throw(NotOpen)
+inline
+SerialPort::InputOverflowPolicy
+SerialPort::SerialPortImpl::GetInputOverflowPolicy() const
 {
-    return mSerialPortImpl->IsDataAvailable() ;
+    return static_cast<SerialPort::InputOverflowPolicy>( mInputOverflowPolicy.load() ) ;
 }
 
-unsigned char
-SerialPort::ReadByte( const unsigned int msTimeout )
-    throw( NotOpen,
-           ReadTimeout,
-           std::runtime_error )
+inline
+unsigned long long
+SerialPort::SerialPortImpl::GetNumOfDroppedInputBytes() const
 {
-    return mSerialPortImpl->ReadByte(msTimeout) ;
+    return mNumOfDroppedInputBytes ;
 }
 
-void
-SerialPort::Read( SerialPort::DataBuffer& dataBuffer,
-                  const unsigned int      numOfBytes,
-                  const unsigned int      msTimeout )
-    throw( NotOpen,
-           ReadTimeout,
-           std::runtime_error )
+inline
+unsigned long long
+SerialPort::SerialPortImpl::GetNumOfInputBackpressureEvents() const
 {
-    return mSerialPortImpl->Read( dataBuffer,
-                                  numOfBytes,
-                                  msTimeout ) ;
+    return mNumOfInputBackpressureEvents ;
 }
 
-
-const std::string
-SerialPort::ReadLine( const unsigned int msTimeout,
-                      const char         lineTerminator )
-    throw( NotOpen,
-           ReadTimeout,
-           std::runtime_error )
+inline
+size_t
+SerialPort::SerialPortImpl::GetInputBufferHighWaterMark() const
 {
-    return mSerialPortImpl->ReadLine( msTimeout,
-                                      lineTerminator ) ;
+    return mInputBufferHighWaterMark ;
 }
 
-
+inline
 void
-SerialPort::WriteByte( const unsigned char dataByte )
-    throw( SerialPort::NotOpen,
-           std::runtime_error )
+SerialPort::SerialPortImpl::ResetInputBufferCounters()
 {
-    mSerialPortImpl->WriteByte( dataByte ) ;
+    mNumOfDroppedInputBytes       = 0 ;
+    mNumOfInputBackpressureEvents = 0 ;
+    mInputBufferHighWaterMark     = mInputBuffer.Size() ;
     return ;
 }
 
+inline
+SerialPort::Statistics
+SerialPort::SerialPortImpl::GetStatistics() const
+{
+    SerialPort::Statistics statistics ;
+    statistics.numOfBytesReceived           = mNumOfBytesReceived.load( std::memory_order_relaxed ) ;
+    statistics.numOfBytesTransmitted        = mNumOfBytesTransmitted.load( std::memory_order_relaxed ) ;
+    statistics.numOfReadCalls               = mNumOfReadCalls.load( std::memory_order_relaxed ) ;
+    statistics.numOfWriteCalls              = mNumOfWriteCalls.load( std::memory_order_relaxed ) ;
+    statistics.numOfInputSignals            = mNumOfInputSignals.load( std::memory_order_relaxed ) ;
+    statistics.numOfReactorEvents           = mNumOfReactorEvents.load( std::memory_order_relaxed ) ;
+    statistics.numOfFillContentions         = mNumOfFillContentions.load( std::memory_order_relaxed ) ;
+    statistics.numOfReaderWakeups           = mNumOfReaderWakeups.load( std::memory_order_relaxed ) ;
+    statistics.numOfReadTimeouts            = mNumOfReadTimeouts.load( std::memory_order_relaxed ) ;
+    statistics.numOfWriteTimeouts           = mNumOfWriteTimeouts.load( std::memory_order_relaxed ) ;
+    statistics.numOfDroppedInputBytes       = mNumOfDroppedInputBytes.load( std::memory_order_relaxed ) ;
+    statistics.numOfInputBackpressureEvents = mNumOfInputBackpressureEvents.load( std::memory_order_relaxed ) ;
+    statistics.inputBufferHighWaterMark     = mInputBufferHighWaterMark.load( std::memory_order_relaxed ) ;
+    return statistics ;
+}
 
+inline
 void
-SerialPort::Write(const DataBuffer& dataBuffer)
-    throw( NotOpen,
-           std::runtime_error )
+SerialPort::SerialPortImpl::ResetStatistics()
 {
-    mSerialPortImpl->Write( dataBuffer ) ;
+    mNumOfBytesReceived    = 0 ;
+    mNumOfBytesTransmitted = 0 ;
+    mNumOfReadCalls        = 0 ;
+    mNumOfWriteCalls       = 0 ;
+    mNumOfInputSignals     = 0 ;
+    mNumOfReactorEvents    = 0 ;
+    mNumOfFillContentions  = 0 ;
+    mNumOfReaderWakeups    = 0 ;
+    mNumOfReadTimeouts     = 0 ;
+    mNumOfWriteTimeouts    = 0 ;
+    this->ResetInputBufferCounters() ;
     return ;
 }
 
+inline
 void
-SerialPort::Write(const std::string& dataString)
-    throw( NotOpen,
-           std::runtime_error )
+SerialPort::SerialPortImpl::EnableInputLatencyHistogram()
 {
-    mSerialPortImpl->Write( reinterpret_cast<const unsigned char*>(dataString.c_str()),
-                            dataString.length() ) ;
+    //
+    // Several threads may enable the histogram at the same time. Only
+    // the first one installs its histogram.
+    //
+    if ( 0 == mInputLatencyHistogram )
+    {
+        LatencyHistogram* const new_histogram = new LatencyHistogram ;
+        LatencyHistogram* no_histogram = 0 ;
+        if ( ! mInputLatencyHistogram.compare_exchange_strong( no_histogram,
+                                                               new_histogram ) )
+        {
+            delete new_histogram ;
+        }
+    }
+    mIsInputLatencyEnabled = true ;
     return ;
 }
 
+inline
 void
-SerialPort::SetDtr( const bool dtrState )
-    throw( SerialPort::NotOpen,
-           std::runtime_error ) 
+SerialPort::SerialPortImpl::DisableInputLatencyHistogram()
 {
-    mSerialPortImpl->SetDtr( dtrState ) ;
+    mIsInputLatencyEnabled = false ;
     return ;
 }
 
+inline
 bool
-SerialPort::GetDtr() const 
-    throw( SerialPort::NotOpen,
-           std::runtime_error ) 
+SerialPort::SerialPortImpl::IsInputLatencyHistogramEnabled() const
 {
-    return mSerialPortImpl->GetDtr() ;
+    return mIsInputLatencyEnabled ;
+}
+
+inline
+unsigned long long
+SerialPort::SerialPortImpl::GetNumOfInputLatencySamples() const
+{
+    const LatencyHistogram* const input_latency_histogram =
+        mInputLatencyHistogram ;
+    if ( 0 == input_latency_histogram )
+    {
+        return 0 ;
+    }
+    return input_latency_histogram->GetNumOfSamples() ;
 }
 
+inline
+long long
+SerialPort::SerialPortImpl::GetInputLatencyPercentile( const double percentile ) const
+{
+    const LatencyHistogram* const input_latency_histogram =
+        mInputLatencyHistogram ;
+    if ( 0 == input_latency_histogram )
+    {
+        return 0 ;
+    }
+    return input_latency_histogram->GetPercentile( percentile ) ;
+}
+
+inline
 void
-SerialPort::SetRts( const bool rtsState )
-    throw( SerialPort::NotOpen,
-           std::runtime_error ) 
+SerialPort::SerialPortImpl::ResetInputLatencyHistogram()
 {
-    mSerialPortImpl->SetRts( rtsState ) ;
+    LatencyHistogram* const input_latency_histogram =
+        mInputLatencyHistogram ;
+    if ( 0 != input_latency_histogram )
+    {
+        input_latency_histogram->Reset() ;
+    }
     return ;
 }
 
-bool
-SerialPort::GetRts() const 
-    throw( SerialPort::NotOpen,
-           std::runtime_error ) 
+inline
+void
+SerialPort::SerialPortImpl::Close()
+    throw( SerialPort::NotOpen )
 {
-    return mSerialPortImpl->GetRts() ;
+    //
+    // Throw an exception if the serial port is not open.
+    //
+    if ( ! this->IsOpen() )
+    {
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+    }
+    //
+    //
+    // Discard pending asynchronous writes.
+    //
+    this->StopAsyncWriter() ;
+    //
+    // Stop watching the port for incoming data.
+    //
+    {
+        MutexLock reactor_lock( mReactorMutex ) ;
+        if ( 0 != mSerialReactor )
+        {
+            mSerialReactor->UnregisterHandler( *this ) ;
+            mSerialReactor = 0 ;
+        }
+        else
+        {
+            try
+            {
+                this->DisableSignalDrivenInput() ;
+            }
+            catch( std::runtime_error& )
+            {
+                //
+                // The port is closed below anyway.
+                //
+            }
+        }
+    }
+    //
+    // Restore the old settings of the port.
+    //
+    tcsetattr( mFileDescriptor,
+               TCSANOW,
+               &mOldPortSettings ) ;
+    //
+    // Close the serial port file descriptor and the wakeup pipe.
+    //
+    close(mFileDescriptor) ;
+    close(mWakeupPipe[0]) ;
+    close(mWakeupPipe[1]) ;
+    mWakeupPipe[0] = -1 ;
+    mWakeupPipe[1] = -1 ;
+    //
+    // The port is not open anymore.
+    //
+    mIsOpen = false ;
+    //
+    return ;
 }
 
-
-bool
-SerialPort::GetCts() const 
+inline
+void
+SerialPort::SerialPortImpl::SetBaudRate( const SerialPort::BaudRate baudRate )
     throw( SerialPort::NotOpen,
-           std::runtime_error ) 
+           SerialPort::UnsupportedBaudRate,
+           std::invalid_argument,
+           std::runtime_error )
 {
-    return mSerialPortImpl->GetCts() ;
+    //
+    // Throw an exception if the serial port is not open.
+    //
+    if ( ! this->IsOpen() )
+    {
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+    }
+    //
+    // Start from the cached settings of the serial port.
+    //
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    termios port_settings = mPortSettings ;
+    //
+    // Set the baud rate for both input and output.
+    //
+    ApplyBaudRate( port_settings,
+                   baudRate ) ;
+    //
+    // Set the new attributes of the serial port.
+    //
+    const int error_number = this->WritePortSettings( port_settings,
+                                                      TCSANOW ) ;
+    if ( 0 != error_number )
+    {
+        throw SerialPort::UnsupportedBaudRate( strerror(error_number) ) ;
+    }
+    return ;
 }
 
-bool
-SerialPort::GetDsr() const 
+inline
+SerialPort::BaudRate
+SerialPort::SerialPortImpl::GetBaudRate() const
     throw( SerialPort::NotOpen,
-           std::runtime_error ) 
+           std::runtime_error )
 {
-    return mSerialPortImpl->GetDsr() ;
+    //
+    // Make sure that the serial port is open.
+    //
+    if ( ! this->IsOpen() )
+    {
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+    }
+    //
+    // Use the cached settings; they are updated whenever the settings
+    // of the serial port are changed.
+    //
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    //
+    // Obtain the input baud rate from the current settings.
+    //
+    return ExtractBaudRate( mPortSettings ) ;
 }
 
-/* ------------------------------------------------------------ */
 inline
-SerialPort::SerialPortImpl::SerialPortImpl( const std::string& serialPortName ) :
-    mSerialPortName(serialPortName),
-    mIsOpen(false),
-    mFileDescriptor(-1),
-    mOldPortSettings(),
-    mInputBuffer(),
-    mShadowInputBuffer(), 
-    mQueueMutex(),
-    mIsQueueDataAvailable(false)
+void
+SerialPort::SerialPortImpl::SetCharSize( const SerialPort::CharacterSize charSize )
+    throw( SerialPort::NotOpen,
+           std::invalid_argument,
+           std::runtime_error )
 {
-	//Initializing the mutex
-	if (pthread_mutex_init(&mQueueMutex, NULL) != 0)
+    //
+    // Make sure that the serial port is open.
+    //
+    if ( ! this->IsOpen() )
     {
-		std::cerr << "SerialPort.cpp: Could not initialize mutex!" << std::endl;
-	}
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+    }
+    //
+    // Start from the cached settings of the serial port.
+    //
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    termios port_settings = mPortSettings ;
+    //
+    // Set the character size.
+    //
+    ApplyCharSize( port_settings,
+                   charSize ) ;
+    //
+    // Apply the modified settings.
+    //
+    const int error_number = this->WritePortSettings( port_settings,
+                                                      TCSANOW ) ;
+    if ( 0 != error_number )
+    {
+        throw std::invalid_argument( strerror(error_number) ) ;
+    }
+    return ;
 }
 
 inline
-SerialPort::SerialPortImpl::~SerialPortImpl()
+SerialPort::CharacterSize
+SerialPort::SerialPortImpl::GetCharSize() const
+    throw( SerialPort::NotOpen,
+           std::runtime_error )
 {
     //
-    // Close the serial port if it is open.
+    // Make sure that the serial port is open.
     //
-    if ( this->IsOpen() )
+    if ( ! this->IsOpen() )
     {
-        this->Close() ;
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
-    return ;
+    //
+    // Use the cached settings; they are updated whenever the settings
+    // of the serial port are changed.
+    //
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    //
+    // Read the character size from the setttings.
+    //
+    return ExtractCharSize( mPortSettings ) ;
 }
 
 inline
 void
-SerialPort::SerialPortImpl::Open()
-    throw( SerialPort::OpenFailed,
-           SerialPort::AlreadyOpen )
+SerialPort::SerialPortImpl::SetParity( const SerialPort::Parity parityType )
+    throw( SerialPort::NotOpen,
+           std::invalid_argument,
+           std::runtime_error )
 {
-    /*
-     * Throw an exception if the port is already open.
-     */
-    if ( this->IsOpen() )
+    //
+    // Make sure that the serial port is open.
+    //
+    if ( ! this->IsOpen() )
     {
-        throw SerialPort::AlreadyOpen( ERR_MSG_PORT_ALREADY_OPEN ) ;
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
-    /*
-     * Try to open the serial port and throw an exception if we are
-     * not able to open it.
-     *
-     * :FIXME: Exception thrown by this method after opening the
-     * serial port might leave the port open even though mIsOpen
-     * is false. We need to close the port before throwing an
-     * exception or close it next time this method is called before
-     * calling open() again.
-     */
-    mFileDescriptor = open( mSerialPortName.c_str(),
-                            O_RDWR | O_NOCTTY | O_NONBLOCK ) ;
-    if ( mFileDescriptor < 0 )
+    //
+    // Start from the cached settings of the serial port.
+    //
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    termios port_settings = mPortSettings ;
+    //
+    // Set the parity type depending on the specified parameter.
+    //
+    ApplyParity( port_settings,
+                 parityType ) ;
+    //
+    // Apply the modified port settings.
+    //
+    const int error_number = this->WritePortSettings( port_settings,
+                                                      TCSANOW ) ;
+    if ( 0 != error_number )
     {
-        throw SerialPort::OpenFailed( strerror(errno) )  ;
+        throw std::invalid_argument( strerror(error_number) ) ;
     }
+    return ;
+}
 
-
-    PosixSignalDispatcher& signal_dispatcher = PosixSignalDispatcher::Instance() ;
-    signal_dispatcher.AttachHandler( SIGIO,
-                                     *this ) ;
-
-    /*
-     * Direct all SIGIO and SIGURG signals for the port to the current
-     * process.
-     */
-    if ( fcntl( mFileDescriptor,
-                F_SETOWN,
-                getpid() ) < 0 )
+inline
+SerialPort::Parity
+SerialPort::SerialPortImpl::GetParity() const
+    throw(SerialPort::NotOpen)
+{
+    //
+    // Make sure that the serial port is open.
+    //
+    if ( ! this->IsOpen() )
     {
-        throw SerialPort::OpenFailed( strerror(errno) ) ;
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
+    //
+    // Use the cached settings; they are updated whenever the settings
+    // of the serial port are changed.
+    //
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    //
+    // Get the parity type from the current settings.
+    //
+    return ExtractParity( mPortSettings ) ;
+}
 
-    /*
-     * Enable asynchronous I/O with the serial port.
-     */
-    if ( fcntl( mFileDescriptor,
-                F_SETFL,
-                FASYNC ) < 0 )
+inline
+void
+SerialPort::SerialPortImpl::SetNumOfStopBits( const SerialPort::StopBits numOfStopBits )
+    throw( SerialPort::NotOpen,
+           std::invalid_argument )
+{
+    //
+    // Make sure that the serial port is open.
+    //
+    if ( ! this->IsOpen() )
     {
-        throw SerialPort::OpenFailed( strerror(errno) ) ;
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
-
-    /*
-     * Save the current settings of the serial port so they can be
-     * restored when the serial port is closed.
-     */
-    if ( tcgetattr( mFileDescriptor,
-                    &mOldPortSettings ) < 0 )
+    //
+    // Start from the cached settings of the serial port.
+    //
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    termios port_settings = mPortSettings ;
+    //
+    // Set the number of stop bits.
+    //
+    ApplyNumOfStopBits( port_settings,
+                        numOfStopBits ) ;
+    //
+    // Apply the modified settings.
+    //
+    const int error_number = this->WritePortSettings( port_settings,
+                                                      TCSANOW ) ;
+    if ( 0 != error_number )
     {
-        throw SerialPort::OpenFailed( strerror(errno) ) ;
+        throw std::invalid_argument( strerror(error_number) ) ;
     }
+    return ;
+}
 
+inline
+SerialPort::StopBits
+SerialPort::SerialPortImpl::GetNumOfStopBits() const
+    throw(SerialPort::NotOpen)
+{
     //
-    // Start assembling the new port settings.
+    // Make sure that the serial port is open.
     //
-    termios port_settings ;
-    bzero( &port_settings,
-           sizeof( port_settings ) ) ;
-
+    if ( ! this->IsOpen() )
+    {
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+    }
     //
-    // Enable the receiver (CREAD) and ignore modem control lines
-    // (CLOCAL).
+    // Use the cached settings; they are updated whenever the settings
+    // of the serial port are changed.
     //
-    port_settings.c_cflag |= CREAD | CLOCAL ;
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    //
+    // Get the number of stop bits from the current settings.
+    //
+    return ExtractNumOfStopBits( mPortSettings ) ;
+}
 
+inline
+void
+SerialPort::SerialPortImpl::SetFlowControl( const SerialPort::FlowControl   flowControl )
+    throw( SerialPort::NotOpen,
+           std::invalid_argument )
+{
     //
-    // Set the VMIN and VTIME parameters to zero by default. VMIN is
-    // the minimum number of characters for non-canonical read and
-    // VTIME is the timeout in deciseconds for non-canonical
-    // read. Setting both of these parameters to zero implies that a
-    // read will return immediately only giving the currently
-    // available characters.
+    // Make sure that the serial port is open.
     //
-    port_settings.c_cc[ VMIN  ] = 0 ;
-    port_settings.c_cc[ VTIME ] = 0 ;
-    /*
-     * Flush the input buffer associated with the port.
-     */
-    if ( tcflush( mFileDescriptor,
-                  TCIFLUSH ) < 0 )
+    if ( ! this->IsOpen() )
     {
-        throw SerialPort::OpenFailed( strerror(errno) ) ;
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
-    /*
-     * Write the new settings to the port.
-     */
-    if ( tcsetattr( mFileDescriptor,
-                    TCSANOW,
-                    &port_settings ) < 0 )
+    //
+    // Start from the cached settings of the serial port.
+    //
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    termios port_settings = mPortSettings ;
+    //
+    // Set the flow control.
+    //
+    ApplyFlowControl( port_settings,
+                      flowControl ) ;
+    //
+    // Apply the modified settings.
+    //
+    const int error_number = this->WritePortSettings( port_settings,
+                                                      TCSANOW ) ;
+    if ( 0 != error_number )
     {
-        throw SerialPort::OpenFailed( strerror(errno) ) ;
+        throw std::invalid_argument( strerror(error_number) ) ;
     }
-
-    /*
-     * The serial port is open at this point.
-     */
-    mIsOpen = true ;
-
-    //Reset flag
-    mIsQueueDataAvailable = false;
-
     return ;
 }
 
 inline
-bool
-SerialPort::SerialPortImpl::IsOpen() const
+SerialPort::FlowControl
+SerialPort::SerialPortImpl::GetFlowControl() const
+    throw( SerialPort::NotOpen )
 {
-    return mIsOpen ;
+    //
+    // Make sure that the serial port is open.
+    //
+    if ( ! this->IsOpen() )
+    {
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+    }
+    //
+    // Use the cached settings; they are updated whenever the settings
+    // of the serial port are changed.
+    //
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    //
+    // Get the flow control from the current settings.
+    //
+    return ExtractFlowControl( mPortSettings ) ;
 }
 
 inline
 void
-SerialPort::SerialPortImpl::Close()
-    throw( SerialPort::NotOpen )
+SerialPort::SerialPortImpl::SetPortSettings( const SerialPort::PortSettings& portSettings,
+                                             const bool                      drain )
+    throw( SerialPort::NotOpen,
+           SerialPort::UnsupportedBaudRate,
+           std::invalid_argument,
+           std::runtime_error )
 {
     //
-    // Throw an exception if the serial port is not open.
+    // Make sure that the serial port is open.
     //
     if ( ! this->IsOpen() )
     {
         throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
     //
-    PosixSignalDispatcher& signal_dispatcher = PosixSignalDispatcher::Instance() ;
-    signal_dispatcher.DetachHandler( SIGIO,
-                                     *this ) ;
+    // Start from the cached settings of the serial port.
     //
-    // Restore the old settings of the port.
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    termios port_settings = mPortSettings ;
     //
-    tcsetattr( mFileDescriptor,
-               TCSANOW,
-               &mOldPortSettings ) ;
+    // Modify all settings in our copy first and then apply them with a
+    // single call so that the port never uses a partial configuration.
     //
-    // Close the serial port file descriptor.
+    ApplyPortSettings( port_settings,
+                       portSettings ) ;
+    const int error_number = this->WritePortSettings( port_settings,
+                                                      ( drain ? TCSADRAIN : TCSANOW ) ) ;
+    if ( 0 != error_number )
+    {
+        throw std::runtime_error( strerror(error_number) ) ;
+    }
+    return ;
+}
+
+inline
+SerialPort::PortSettings
+SerialPort::SerialPortImpl::GetPortSettings() const
+    throw( SerialPort::NotOpen,
+           std::runtime_error )
+{
     //
-    close(mFileDescriptor) ;
+    // Make sure that the serial port is open.
     //
-    // The port is not open anymore.
+    if ( ! this->IsOpen() )
+    {
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+    }
     //
-    mIsOpen = false ;
+    // Use the cached settings; they are updated whenever the settings
+    // of the serial port are changed.
     //
-    return ;
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
+    return SerialPort::PortSettings( ExtractBaudRate( mPortSettings ),
+                                     ExtractCharSize( mPortSettings ),
+                                     ExtractParity( mPortSettings ),
+                                     ExtractNumOfStopBits( mPortSettings ),
+                                     ExtractFlowControl( mPortSettings ) ) ;
 }
 
 inline
 void
-SerialPort::SerialPortImpl::SetBaudRate( const SerialPort::BaudRate baudRate )
+SerialPort::SerialPortImpl::RefreshPortSettings()
     throw( SerialPort::NotOpen,
-           SerialPort::UnsupportedBaudRate,
-           std::invalid_argument,
            std::runtime_error )
 {
     //
-    // Throw an exception if the serial port is not open.
+    // Make sure that the serial port is open.
     //
     if ( ! this->IsOpen() )
     {
         throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
     //
-    // Get the current settings of the serial port.
+    // Read the settings from the driver, e.g. after they were changed
+    // by another process.
     //
-    termios port_settings ;
+    MutexLock port_settings_lock( mPortSettingsMutex ) ;
     if ( tcgetattr( mFileDescriptor,
-                    &port_settings ) < 0 )
+                    &mPortSettings ) < 0 )
     {
         throw std::runtime_error( strerror(errno) ) ;
     }
-    //
-    // Set the baud rate for both input and output.
-    //
-    if ( ( cfsetispeed( &port_settings,
-                        baudRate ) < 0 ) ||
-         ( cfsetospeed( &port_settings,
-                        baudRate ) < 0 ) )
+    return ;
+}
+
+inline
+int
+SerialPort::SerialPortImpl::WritePortSettings( const termios& portSettings,
+                                               const int      optionalActions )
+{
+    int error_number = 0 ;
+    if ( tcsetattr( mFileDescriptor,
+                    optionalActions,
+                    &portSettings ) < 0 )
     {
-        //
-        // If any of the settings fail, we abandon this method.
-        //
-        throw SerialPort::UnsupportedBaudRate( ERR_MSG_UNSUPPORTED_BAUD ) ;
+        error_number = errno ;
     }
     //
-    // Set the new attributes of the serial port.
+    // Read back the settings because the driver may silently ignore
+    // some of them or only apply part of them on failure.
     //
-    if ( tcsetattr( mFileDescriptor,
-                    TCSANOW,
-                    &port_settings ) < 0 )
+    if ( ( tcgetattr( mFileDescriptor,
+                      &mPortSettings ) < 0 ) &&
+         ( 0 == error_number ) )
     {
-        throw SerialPort::UnsupportedBaudRate( strerror(errno) ) ;
+        error_number = errno ;
     }
-    return ;
+    return error_number ;
 }
 
 inline
-SerialPort::BaudRate
-SerialPort::SerialPortImpl::GetBaudRate() const
+bool
+SerialPort::SerialPortImpl::IsDataAvailable() const
     throw( SerialPort::NotOpen,
            std::runtime_error )
 {
@@ -850,25 +2701,54 @@ SerialPort::SerialPortImpl::GetBaudRate() const
         throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
     //
-    // Read the current serial port settings.
+    // Check if any data is available in the input buffer.
     //
-    termios port_settings ;
-    if ( tcgetattr( mFileDescriptor,
-                    &port_settings ) < 0 )
+    return ( ! mInputBuffer.IsEmpty() ) ;
+}
+
+inline
+unsigned char
+SerialPort::SerialPortImpl::ReadByte(const unsigned int msTimeout)
+    throw( SerialPort::NotOpen,
+           SerialPort::ReadTimeout,
+           std::runtime_error )
+{
+    //
+    // Make sure that the serial port is open.
+    //
+    if ( ! this->IsOpen() )
     {
-        throw std::runtime_error( strerror(errno) ) ;
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
     //
-    // Obtain the input baud rate from the current settings.
+    // Wait for data to be available and remove the first byte from
+    // the input buffer.
     //
-    return SerialPort::BaudRate(cfgetispeed( &port_settings )) ;
+    const long long deadline = GetDeadline( msTimeout ) ;
+    MutexLock queue_lock( mQueueMutex ) ;
+    unsigned char next_char = 0 ;
+    while( 0 == this->ReadInputBuffer( &next_char, 1 ) )
+    {
+        //
+        // If msTimeout milliseconds have elapsed while waiting for
+        // data, then we throw a ReadTimeout exception.
+        //
+        if ( ! this->WaitForInputData( deadline ) )
+        {
+            throw SerialPort::ReadTimeout() ;
+        }
+    }
+    return next_char ;
 }
 
 inline
 void
-SerialPort::SerialPortImpl::SetCharSize( const SerialPort::CharacterSize charSize )
+SerialPort::SerialPortImpl::Read( SerialPort::DataBuffer&   dataBuffer,
+                                  const unsigned int        numOfBytes,
+                                  const unsigned int        msTimeout,
+                                  SerialPort::ArrivalTimes* arrivalTimes )
     throw( SerialPort::NotOpen,
-           std::invalid_argument,
+           SerialPort::ReadTimeout,
            std::runtime_error )
 {
     //
@@ -879,34 +2759,51 @@ SerialPort::SerialPortImpl::SetCharSize( const SerialPort::CharacterSize charSiz
         throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
     //
-    // Get the current settings of the serial port.
+    // Empty the data buffer.
     //
-    termios port_settings ;
-    if ( tcgetattr( mFileDescriptor,
-                    &port_settings ) < 0 )
+    dataBuffer.resize(0) ;
+    //
+    if ( 0 == numOfBytes )
     {
-        throw std::runtime_error( strerror(errno) ) ;
+        //
+        // Read all available data if numOfBytes is zero.
+        //
+        MutexLock queue_lock( mQueueMutex ) ;
+        dataBuffer.resize( mInputBuffer.Size() ) ;
+        if ( ! dataBuffer.empty() )
+        {
+            dataBuffer.resize( this->ReadInputBuffer( &dataBuffer[0],
+                                                      dataBuffer.size(),
+                                                      arrivalTimes ) ) ;
+        }
     }
-    //
-    // Set the character size.
-    //
-    port_settings.c_cflag &= ~CSIZE ;
-    port_settings.c_cflag |= charSize ;
-    //
-    // Apply the modified settings.
-    //
-    if ( tcsetattr( mFileDescriptor,
-                    TCSANOW,
-                    &port_settings ) < 0 )
+    else
     {
-        throw std::invalid_argument( strerror(errno) ) ;
+        //
+        // Make enough space in the buffer to store the incoming data
+        // and read directly into it. Leave the data read so far in
+        // dataBuffer if we time out.
+        //
+        dataBuffer.resize( numOfBytes ) ;
+        const size_t num_of_bytes_read = this->Read( &dataBuffer[0],
+                                                     numOfBytes,
+                                                     msTimeout,
+                                                     arrivalTimes ) ;
+        if ( num_of_bytes_read < numOfBytes )
+        {
+            dataBuffer.resize( num_of_bytes_read ) ;
+            throw SerialPort::ReadTimeout() ;
+        }
     }
     return ;
 }
 
 inline
-SerialPort::CharacterSize
-SerialPort::SerialPortImpl::GetCharSize() const
+size_t
+SerialPort::SerialPortImpl::Read( unsigned char*            dataBuffer,
+                                  const size_t              numOfBytes,
+                                  const unsigned int        msTimeout,
+                                  SerialPort::ArrivalTimes* arrivalTimes )
     throw( SerialPort::NotOpen,
            std::runtime_error )
 {
@@ -918,25 +2815,89 @@ SerialPort::SerialPortImpl::GetCharSize() const
         throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
     //
-    // Get the current port settings.
+    // The timeout applies to the whole request, not to individual
+    // bytes.
     //
-    termios port_settings ;
-    if ( tcgetattr( mFileDescriptor,
-                    &port_settings ) < 0 )
+    const long long deadline = GetDeadline( msTimeout ) ;
+    MutexLock queue_lock( mQueueMutex ) ;
+    size_t num_of_bytes_read = 0 ;
+    while( true )
     {
-        throw std::runtime_error( strerror(errno) ) ;
+        //
+        // Copy as much of the requested data as is available.
+        //
+        num_of_bytes_read += this->ReadInputBuffer( dataBuffer + num_of_bytes_read,
+                                                    numOfBytes - num_of_bytes_read,
+                                                    arrivalTimes,
+                                                    num_of_bytes_read ) ;
+        if ( ( num_of_bytes_read == numOfBytes ) ||
+             ( ! this->WaitForInputData( deadline ) ) )
+        {
+            return num_of_bytes_read ;
+        }
     }
+}
+
+inline
+void
+SerialPort::SerialPortImpl::Peek( SerialPort::DataBuffer& dataBuffer,
+                                  const unsigned int      numOfBytes,
+                                  const unsigned int      msTimeout )
+    throw( SerialPort::NotOpen,
+           SerialPort::ReadTimeout,
+           std::invalid_argument,
+           std::runtime_error )
+{
     //
-    // Read the character size from the setttings.
+    // Make sure that the serial port is open.
     //
-    return SerialPort::CharacterSize( port_settings.c_cflag & CSIZE ) ;
+    if ( ! this->IsOpen() )
+    {
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+    }
+    if ( numOfBytes > mInputBuffer.Capacity() )
+    {
+        throw std::invalid_argument( ERR_MSG_INVALID_MIN_READABLE ) ;
+    }
+    const long long deadline = GetDeadline( msTimeout ) ;
+    MutexLock queue_lock( mQueueMutex ) ;
+    const bool is_data_available = this->WaitForInputData( deadline,
+                                                           numOfBytes ) ;
+    //
+    // Copy the data in place. The producer must not discard it while
+    // it is being copied.
+    //
+    struct iovec regions[2] ;
+    const size_t num_of_bytes = std::min( this->AcquireInputBuffer( regions ),
+                                          ( 0 == numOfBytes ? mInputBuffer.Capacity() : numOfBytes ) ) ;
+    const size_t first_length = std::min( num_of_bytes,
+                                          regions[0].iov_len ) ;
+    const unsigned char* const first_region =
+        static_cast<const unsigned char*>( regions[0].iov_base ) ;
+    const unsigned char* const second_region =
+        static_cast<const unsigned char*>( regions[1].iov_base ) ;
+    dataBuffer.assign( first_region,
+                       first_region + first_length ) ;
+    dataBuffer.insert( dataBuffer.end(),
+                       second_region,
+                       second_region + ( num_of_bytes - first_length ) ) ;
+    this->ReleaseInputBuffer() ;
+    if ( ! is_data_available )
+    {
+        throw SerialPort::ReadTimeout() ;
+    }
+    return ;
 }
 
 inline
-void
-SerialPort::SerialPortImpl::SetParity( const SerialPort::Parity parityType )
+size_t
+SerialPort::SerialPortImpl::AcquireReadable( SerialPort::ReadableRegion regions[2],
+                                             const size_t               minNumOfBytes,
+                                             const unsigned int         msTimeout )
     throw( SerialPort::NotOpen,
+           SerialPort::ReadTimeout,
            std::invalid_argument,
+           std::logic_error,
            std::runtime_error )
 {
     //
@@ -946,53 +2907,86 @@ SerialPort::SerialPortImpl::SetParity( const SerialPort::Parity parityType )
     {
         throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
+    if ( minNumOfBytes > mInputBuffer.Capacity() )
+    {
+        throw std::invalid_argument( ERR_MSG_INVALID_MIN_READABLE ) ;
+    }
     //
-    // Get the current port settings.
+    // A second call before CommitReadable() would wait for the mutex
+    // that this thread already holds.
     //
-    termios port_settings ;
-    if ( tcgetattr( mFileDescriptor,
-                    &port_settings ) < 0 )
+    if ( this->IsReadableAcquiredByThisThread() )
     {
-        throw std::runtime_error( strerror(errno) ) ;
+        throw std::logic_error( ERR_MSG_ALREADY_ACQUIRED ) ;
     }
     //
-    // Set the parity type depending on the specified parameter.
+    // mQueueMutex stays locked until CommitReadable() is called, so it
+    // cannot be managed by a MutexLock.
     //
-    switch( parityType )
-    {
-    case SerialPort::PARITY_EVEN:
-        port_settings.c_cflag |= PARENB ;
-        port_settings.c_cflag &= ~PARODD ;
-        port_settings.c_iflag |= INPCK ;
-        break ;
-    case SerialPort::PARITY_ODD:
-        port_settings.c_cflag |= ( PARENB | PARODD ) ;
-        port_settings.c_iflag |= INPCK ;
-        break ;
-    case SerialPort::PARITY_NONE:
-        port_settings.c_cflag &= ~(PARENB) ;
-        port_settings.c_iflag |= IGNPAR ;
-        break ;
-    default:
-        throw std::invalid_argument( ERR_MSG_INVALID_PARITY ) ;
-        break ;
+    const long long deadline = GetDeadline( msTimeout ) ;
+    pthread_mutex_lock( &mQueueMutex ) ;
+    bool is_data_available ;
+    try
+    {
+        is_data_available = this->WaitForInputData( deadline,
+                                                    minNumOfBytes ) ;
+    }
+    catch( ... )
+    {
+        pthread_mutex_unlock( &mQueueMutex ) ;
+        throw ;
+    }
+    if ( ! is_data_available )
+    {
+        pthread_mutex_unlock( &mQueueMutex ) ;
+        throw SerialPort::ReadTimeout() ;
+    }
+    struct iovec data_regions[2] ;
+    mNumOfAcquiredBytes = this->AcquireInputBuffer( data_regions ) ;
+    mReadableOwner      = pthread_self() ;
+    mIsReadableAcquired = true ;
+    for( int i=0; i<2; ++i )
+    {
+        regions[i].data = static_cast<const unsigned char*>( data_regions[i].iov_base ) ;
+        regions[i].size = data_regions[i].iov_len ;
     }
+    return mNumOfAcquiredBytes ;
+}
+
+inline
+void
+SerialPort::SerialPortImpl::CommitReadable( const size_t numOfBytes )
+    throw( std::logic_error )
+{
     //
-    // Apply the modified port settings.
+    // Only the thread that holds mQueueMutex may unlock it.
     //
-    if ( tcsetattr( mFileDescriptor,
-                    TCSANOW,
-                    &port_settings ) < 0 )
+    if ( ! this->IsReadableAcquiredByThisThread() )
+    {
+        throw std::logic_error( ERR_MSG_NOT_ACQUIRED ) ;
+    }
+    if ( numOfBytes > mNumOfAcquiredBytes )
     {
-        throw std::invalid_argument( strerror(errno) ) ;
+        throw std::invalid_argument( ERR_MSG_INVALID_COMMIT ) ;
     }
+    mInputBuffer.Consume( numOfBytes ) ;
+    this->RemoveInputTimestamps() ;
+    mNumOfAcquiredBytes = 0 ;
+    mIsReadableAcquired = false ;
+    this->ReleaseInputBuffer() ;
+    pthread_mutex_unlock( &mQueueMutex ) ;
     return ;
 }
 
 inline
-SerialPort::Parity
-SerialPort::SerialPortImpl::GetParity() const
-    throw(SerialPort::NotOpen)
+std::string
+SerialPort::SerialPortImpl::ReadLine( const unsigned int msTimeout,
+                                      const std::string& lineTerminator,
+                                      const size_t       maxLength )
+    throw( SerialPort::NotOpen,
+           SerialPort::ReadTimeout,
+           std::invalid_argument,
+           std::runtime_error )
 {
     //
     // Make sure that the serial port is open.
@@ -1001,43 +2995,91 @@ SerialPort::SerialPortImpl::GetParity() const
     {
         throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
-    //
-    // Get the current port settings.
-    //
-    termios port_settings ;
-    if ( tcgetattr( mFileDescriptor,
-                    &port_settings ) < 0 )
+    if ( lineTerminator.empty() )
     {
-        throw std::runtime_error( strerror(errno) ) ;
+        throw std::invalid_argument( ERR_MSG_EMPTY_LINE_TERMINATOR ) ;
     }
     //
-    // Get the parity type from the current settings.
-    //
-    if ( port_settings.c_cflag & PARENB )
+    std::string result ;
+    const long long deadline = GetDeadline( msTimeout ) ;
+    MutexLock queue_lock( mQueueMutex ) ;
+    while( true )
     {
         //
-        // Parity is enabled. Lets check if it is odd or even.
+        // Look for the end of the line in the buffered data without
+        // removing it from the input buffer so that data following the
+        // line terminator stays there. The producer must not discard
+        // the data between the search and the copy.
         //
-        if ( port_settings.c_cflag & PARODD )
+        struct iovec regions[2] ;
+        size_t num_of_bytes = this->AcquireInputBuffer( regions ) ;
+        if ( maxLength > 0 )
         {
-            return SerialPort::PARITY_ODD ;
+            num_of_bytes = std::min( num_of_bytes,
+                                     maxLength - result.size() ) ;
         }
-        else
+        const size_t line_length = FindLineEnd( regions,
+                                                num_of_bytes,
+                                                result,
+                                                lineTerminator ) ;
+        if ( line_length > 0 )
+        {
+            num_of_bytes = line_length ;
+        }
+        //
+        // Move the data up to the end of the line, or all of the data
+        // if the line is not complete yet, to the result in one step.
+        //
+        const size_t result_size = result.size() ;
+        result.resize( result_size + num_of_bytes ) ;
+        result.resize( result_size +
+                       this->ReadInputBuffer( reinterpret_cast<unsigned char*>( &result[result_size] ),
+                                              num_of_bytes ) ) ;
+        this->ReleaseInputBuffer() ;
+        if ( ( line_length > 0 ) ||
+             ( ( maxLength > 0 ) && ( result.size() >= maxLength ) ) )
+        {
+            return result ;
+        }
+        //
+        // Wait for the rest of the line.
+        //
+        if ( ! this->WaitForInputData( deadline ) )
         {
-            return SerialPort::PARITY_EVEN ;
+            throw SerialPort::ReadTimeout() ;
         }
     }
+}
+
+inline
+void
+SerialPort::SerialPortImpl::WriteByte( const unsigned char dataByte )
+    throw( SerialPort::NotOpen,
+           std::runtime_error )
+{
+    //
+    // Make sure that the serial port is open.
+    //
+    if ( ! this->IsOpen() )
+    {
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+    }
     //
-    // Parity is disabled.
+    // Write the byte to the serial port.
     //
-    return SerialPort::PARITY_NONE ;
+    this->Write( &dataByte,
+                 1,
+                 0 ) ;
+    return ;
 }
 
 inline
 void
-SerialPort::SerialPortImpl::SetNumOfStopBits( const SerialPort::StopBits numOfStopBits )
+SerialPort::SerialPortImpl::Write( const SerialPort::DataBuffer& dataBuffer,
+                                   const unsigned int            msTimeout )
     throw( SerialPort::NotOpen,
-           std::invalid_argument )
+           SerialPort::WriteTimeout,
+           std::runtime_error )
 {
     //
     // Make sure that the serial port is open.
@@ -1047,45 +3089,87 @@ SerialPort::SerialPortImpl::SetNumOfStopBits( const SerialPort::StopBits numOfSt
         throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
     //
-    // Get the current port settings.
+    // Nothing needs to be done if there is no data in the buffer.
     //
-    termios port_settings ;
-    if ( tcgetattr( mFileDescriptor,
-                    &port_settings ) < 0 )
+    if ( 0 == dataBuffer.size() )
     {
-        throw std::runtime_error( strerror(errno) ) ;
+        return ;
     }
     //
-    // Set the number of stop bits.
+    // Write the contents of dataBuffer directly. The elements of a
+    // vector are stored contiguously, so no temporary copy is needed.
     //
-    switch( numOfStopBits )
+    if ( this->Write( &dataBuffer[0],
+                      dataBuffer.size(),
+                      msTimeout ) < dataBuffer.size() )
+    {
+        throw SerialPort::WriteTimeout() ;
+    }
+    return ;
+}
+
+inline
+void
+SerialPort::SerialPortImpl::Write( const std::string& dataString,
+                                   const unsigned int msTimeout )
+    throw( SerialPort::NotOpen,
+           SerialPort::WriteTimeout,
+           std::runtime_error )
+{
+    if ( this->Write( reinterpret_cast<const unsigned char*>(dataString.data()),
+                      dataString.length(),
+                      msTimeout ) < dataString.length() )
     {
-    case SerialPort::STOP_BITS_1:
-        port_settings.c_cflag &= ~(CSTOPB) ;
-        break ;
-    case SerialPort::STOP_BITS_2:
-        port_settings.c_cflag |= CSTOPB ;
-        break ;
-    default:
-        throw std::invalid_argument( ERR_MSG_INVALID_STOP_BITS ) ;
-        break ;
+        throw SerialPort::WriteTimeout() ;
     }
+    return ;
+}
+
+inline
+size_t
+SerialPort::SerialPortImpl::Write( const unsigned char* dataBuffer,
+                                   const size_t         bufferSize,
+                                   const unsigned int   msTimeout )
+    throw( SerialPort::NotOpen,
+           std::runtime_error )
+{
     //
-    // Apply the modified settings.
+    // Make sure that the serial port is open.
     //
-    if ( tcsetattr( mFileDescriptor,
-                    TCSANOW,
-                    &port_settings ) < 0 )
+    if ( ! this->IsOpen() )
     {
-        throw std::invalid_argument( strerror(errno) ) ;
+        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
-    return ;
+    //
+    // Only one thread may write at a time so that the data of
+    // concurrent calls is not interleaved.
+    //
+    const long long deadline = GetDeadline( msTimeout ) ;
+    MutexLock write_lock( mWriteMutex ) ;
+    size_t num_of_bytes_written = 0 ;
+    const int error_number = this->WriteData( dataBuffer,
+                                              bufferSize,
+                                              deadline,
+                                              num_of_bytes_written ) ;
+    if ( ETIMEDOUT == error_number )
+    {
+        AddToCounter( mNumOfWriteTimeouts ) ;
+    }
+    else if ( 0 != error_number )
+    {
+        throw std::runtime_error( strerror(error_number) ) ;
+    }
+    return num_of_bytes_written ;
 }
 
 inline
-SerialPort::StopBits
-SerialPort::SerialPortImpl::GetNumOfStopBits() const
-    throw(SerialPort::NotOpen)
+void
+SerialPort::SerialPortImpl::EnableAsyncWrite( SerialPort::WriteCompletionHandler* completionHandler,
+                                              const size_t                        bufferSize,
+                                              const size_t                        maxNumOfRequests )
+    throw( SerialPort::NotOpen,
+           std::logic_error,
+           std::runtime_error )
 {
     //
     // Make sure that the serial port is open.
@@ -1095,30 +3179,80 @@ SerialPort::SerialPortImpl::GetNumOfStopBits() const
         throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
     //
-    // Get the current port settings.
+    MutexLock async_lock( mAsyncWriteMutex ) ;
+    if ( mIsAsyncWriterRunning )
+    {
+        throw std::logic_error( ERR_MSG_ASYNC_WRITE_ENABLED ) ;
+    }
+    if ( ( 0 == bufferSize ) ||
+         ( bufferSize > RingBuffer::MAX_CAPACITY ) )
+    {
+        throw std::invalid_argument( ERR_MSG_INVALID_QUEUE_SIZE ) ;
+    }
+    //
+    // Allocate all memory used by the queue up front so that
+    // WriteAsync() never allocates.
     //
-    termios port_settings ;
-    if ( tcgetattr( mFileDescriptor,
-                    &port_settings ) < 0 )
+    try
     {
-        throw std::runtime_error( strerror(errno) ) ;
+        mAsyncWriteBuffer = new RingBuffer( bufferSize ) ;
+        mAsyncWriteRequests.assign( std::max( maxNumOfRequests,
+                                              static_cast<size_t>(1) ),
+                                    AsyncWriteRequest() ) ;
+    }
+    catch( const std::bad_alloc& )
+    {
+        delete mAsyncWriteBuffer ;
+        mAsyncWriteBuffer = 0 ;
+        mAsyncWriteRequests.clear() ;
+        throw std::runtime_error( ERR_MSG_ASYNC_WRITE_ALLOC ) ;
     }
+    mWriteCompletionHandler  = completionHandler ;
+    mFirstAsyncWriteRequest  = 0 ;
+    mNumOfAsyncWriteRequests = 0 ;
+    mIsAsyncWriterStopping   = false ;
+    //
+    // Start the writer thread.
+    //
+    const int create_result = pthread_create( &mAsyncWriterThread,
+                                              NULL,
+                                              &SerialPortImpl::AsyncWriterThread,
+                                              this ) ;
+    if ( 0 != create_result )
+    {
+        delete mAsyncWriteBuffer ;
+        mAsyncWriteBuffer = 0 ;
+        mAsyncWriteRequests.clear() ;
+        throw std::runtime_error( strerror(create_result) ) ;
+    }
+    mIsAsyncWriterRunning = true ;
+    mIsAsyncWriteEnabled  = true ;
+    return ;
+}
+
+inline
+void
+SerialPort::SerialPortImpl::DisableAsyncWrite()
+{
     //
-    // If CSTOPB is set then we are using two stop bits, otherwise we
-    // are using 1 stop bit.
+    // Stop accepting new requests, wait for the queued ones to be
+    // written and then stop the writer thread.
     //
-    if ( port_settings.c_cflag & CSTOPB )
     {
-        return SerialPort::STOP_BITS_2 ;
+        MutexLock async_lock( mAsyncWriteMutex ) ;
+        mIsAsyncWriteEnabled = false ;
     }
-    return SerialPort::STOP_BITS_1 ;
+    this->WaitForAsyncWrites( 0 ) ;
+    this->StopAsyncWriter() ;
+    return ;
 }
 
 inline
-void
-SerialPort::SerialPortImpl::SetFlowControl( const SerialPort::FlowControl   flowControl )
+unsigned long
+SerialPort::SerialPortImpl::WriteAsync( const unsigned char* dataBuffer,
+                                        const size_t         numOfBytes )
     throw( SerialPort::NotOpen,
-           std::invalid_argument )
+           std::logic_error )
 {
     //
     // Make sure that the serial port is open.
@@ -1128,104 +3262,160 @@ SerialPort::SerialPortImpl::SetFlowControl( const SerialPort::FlowControl   flow
         throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
     //
-    // Get the current port settings.
-    //
-    termios port_settings ;
-    if ( tcgetattr( mFileDescriptor,
-                    &port_settings ) < 0 )
+    MutexLock async_lock( mAsyncWriteMutex ) ;
+    if ( ! mIsAsyncWriteEnabled )
     {
-        throw std::runtime_error( strerror(errno) ) ;
+        throw std::logic_error( ERR_MSG_ASYNC_WRITE_DISABLED ) ;
     }
     //
-    // Set the flow control.
+    // Refuse the request if either the request queue or the data
+    // buffer does not have enough room for it.
     //
-    switch( flowControl )
+    if ( ( mNumOfAsyncWriteRequests == mAsyncWriteRequests.size() ) ||
+         ( numOfBytes > mAsyncWriteBuffer->Capacity() - mAsyncWriteBuffer->Size() ) )
     {
-    case SerialPort::FLOW_CONTROL_HARD:
-        port_settings.c_cflag |= CRTSCTS ;
-        break ;
-    case SerialPort::FLOW_CONTROL_NONE:
-        port_settings.c_cflag &= ~(CRTSCTS) ;
-        break ;
-    default:
-        throw std::invalid_argument( ERR_MSG_INVALID_FLOW_CONTROL ) ;
-        break ;
+        return 0 ;
     }
+    mAsyncWriteBuffer->Write( dataBuffer,
+                              numOfBytes ) ;
     //
-    // Apply the modified settings.
+    AsyncWriteRequest& request =
+        mAsyncWriteRequests[ ( mFirstAsyncWriteRequest + mNumOfAsyncWriteRequests ) %
+                             mAsyncWriteRequests.size() ] ;
+    request.mTicket     = mNextAsyncWriteTicket ;
+    request.mNumOfBytes = numOfBytes ;
+    ++mNumOfAsyncWriteRequests ;
     //
-    if ( tcsetattr( mFileDescriptor,
-                    TCSANOW,
-                    &port_settings ) < 0 )
+    // Tickets are never zero as zero indicates a full queue.
+    //
+    if ( 0 == ++mNextAsyncWriteTicket )
     {
-        throw std::invalid_argument( strerror(errno) ) ;
+        mNextAsyncWriteTicket = 1 ;
     }
-    return ;
+    pthread_cond_broadcast( &mAsyncWriteCondition ) ;
+    return request.mTicket ;
 }
 
 inline
-SerialPort::FlowControl
-SerialPort::SerialPortImpl::GetFlowControl() const
-    throw( SerialPort::NotOpen )
+bool
+SerialPort::SerialPortImpl::WaitForAsyncWrites( const unsigned int msTimeout )
 {
-    //
-    // Make sure that the serial port is open.
-    //
-    if ( ! this->IsOpen() )
-    {
-        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
-    }
-    //
-    // Get the current port settings.
-    //
-    termios port_settings ;
-    if ( tcgetattr( mFileDescriptor,
-                    &port_settings ) < 0 )
-    {
-        throw std::runtime_error( strerror(errno) ) ;
-    }
-    //
-    // If CRTSCTS is set then we are using hardware flow
-    // control. Otherwise, we are not using any flow control.
-    //
-    if ( port_settings.c_cflag & CRTSCTS )
+    const long long deadline = GetDeadline( msTimeout ) ;
+    MutexLock async_lock( mAsyncWriteMutex ) ;
+    while( mNumOfAsyncWriteRequests > 0 )
     {
-        return SerialPort::FLOW_CONTROL_HARD ;
+        if ( NO_DEADLINE == deadline )
+        {
+            pthread_cond_wait( &mAsyncWriteCondition,
+                               &mAsyncWriteMutex ) ;
+            continue ;
+        }
+        const long long NANOSECONDS_PER_SECOND = 1000000000LL ;
+        struct timespec wait_deadline ;
+        wait_deadline.tv_sec  = deadline / NANOSECONDS_PER_SECOND ;
+        wait_deadline.tv_nsec = deadline % NANOSECONDS_PER_SECOND ;
+        if ( ETIMEDOUT == pthread_cond_timedwait( &mAsyncWriteCondition,
+                                                  &mAsyncWriteMutex,
+                                                  &wait_deadline ) )
+        {
+            break ;
+        }
     }
-    return SerialPort::FLOW_CONTROL_NONE ;
+    return ( 0 == mNumOfAsyncWriteRequests ) ;
+}
+
+inline
+void
+SerialPort::SerialPortImpl::SetDtr( const bool dtrState )
+    throw( SerialPort::NotOpen,
+           std::runtime_error )
+{
+    this->SetModemControlLine( TIOCM_DTR, 
+                               dtrState ) ;
+    return ;
 }
 
 inline
 bool
-SerialPort::SerialPortImpl::IsDataAvailable() const
+SerialPort::SerialPortImpl::GetDtr() const
+    throw( SerialPort::NotOpen,
+           std::runtime_error )
+{
+    return this->GetModemControlLine( TIOCM_DTR ) ;
+}    
+
+inline
+void
+SerialPort::SerialPortImpl::SetRts( const bool rtsState )
+    throw( SerialPort::NotOpen,
+           std::runtime_error )
+{
+    this->SetModemControlLine( TIOCM_RTS, 
+                               rtsState ) ;
+    return ;
+}
+
+inline
+bool
+SerialPort::SerialPortImpl::GetRts() const
+    throw( SerialPort::NotOpen,
+           std::runtime_error )
+{
+    return this->GetModemControlLine( TIOCM_RTS ) ;
+}    
+
+
+inline
+bool
+SerialPort::SerialPortImpl::GetCts() const
     throw( SerialPort::NotOpen,
            std::runtime_error )
+{
+    return this->GetModemControlLine( TIOCM_CTS ) ;
+}    
+
+
+inline
+bool
+SerialPort::SerialPortImpl::GetDsr() const
+    throw( SerialPort::NotOpen,
+           std::runtime_error )
+{
+    return this->GetModemControlLine( TIOCM_DSR ) ;
+}    
+
+inline
+void
+SerialPort::SerialPortImpl::HandlePosixSignal( int signalNumber )
 {
     //
-    // Make sure that the serial port is open.
+    // We only want to deal with our input signal here. SIGIO is also
+    // raised instead of a real-time signal when the queue of
+    // real-time signals overflows.
     //
-    if ( ! this->IsOpen() )
+    if ( ( mInputSignal != signalNumber ) &&
+         ( SIGIO != signalNumber ) )
     {
-        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+        return ;
     }
     //
-    // Check if any data is available in the input buffer.
+    // The signal may have interrupted code that is about to inspect
+    // errno, so preserve it.
     //
-    //return ( mInputBuffer.size() > 0 ? true : false ) ;
-    //Here comes an (almost) thread safe alternative
-    return mIsQueueDataAvailable;
+    const int saved_errno = errno ;
+    IncrementSharedCounter( mNumOfInputSignals ) ;
+    this->FillInputBuffer() ;
+    errno = saved_errno ;
+    return ;
 }
 
 inline
-unsigned char
-SerialPort::SerialPortImpl::ReadByte(const unsigned int msTimeout)
+void
+SerialPort::SerialPortImpl::AttachReactor( SerialReactor& serialReactor )
     throw( SerialPort::NotOpen,
-           SerialPort::ReadTimeout,
+           std::logic_error,
            std::runtime_error )
 {
-	pthread_mutex_lock(&mQueueMutex);
-	int queueSize = mInputBuffer.size();
-	pthread_mutex_unlock(&mQueueMutex);
     //
     // Make sure that the serial port is open.
     //
@@ -1233,408 +3423,807 @@ SerialPort::SerialPortImpl::ReadByte(const unsigned int msTimeout)
     {
         throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
     }
-    //
-    // Get the current time. Throw an exception if we are unable
-    // to read the current time.
-    //
-    struct timeval entry_time ;
-    if ( gettimeofday( &entry_time,
-                       NULL ) < 0 )
+    MutexLock reactor_lock( mReactorMutex ) ;
+    if ( 0 != mSerialReactor )
     {
-        throw std::runtime_error( strerror(errno) ) ;
+        throw std::logic_error( ERR_MSG_REACTOR_ATTACHED ) ;
     }
     //
-    // Wait for data to be available.
+    // Let the reactor watch the port before SIGIO is turned off so
+    // that no data goes unnoticed. FillInputBuffer() copes with being
+    // called from both at the same time.
     //
-    const int MICROSECONDS_PER_MS  = 1000 ;
-    const int MILLISECONDS_PER_SEC = 1000 ;
+    serialReactor.RegisterHandler( mFileDescriptor,
+                                   *this ) ;
+    try
+    {
+        this->DisableSignalDrivenInput() ;
+    }
+    catch( ... )
+    {
+        serialReactor.UnregisterHandler( *this ) ;
+        throw ;
+    }
+    mSerialReactor = &serialReactor ;
+    return ;
+}
 
-    while(queueSize == 0 )
+inline
+void
+SerialPort::SerialPortImpl::DetachReactor( SerialReactor& serialReactor )
+    throw( std::logic_error,
+           std::runtime_error )
+{
     {
-        //
-        // Read the current time.
-        //
-        struct timeval curr_time ;
-        if ( gettimeofday( &curr_time,
-                           NULL ) < 0 )
-        {
-            throw std::runtime_error( strerror(errno) ) ;
-        }
-        //
-        // Obtain the elapsed time.
-        //
-        struct timeval elapsed_time = curr_time - entry_time ;
-        //
-        // Increase the elapsed number of milliseconds.
-        //
-        int elapsed_ms = ( elapsed_time.tv_sec  * MILLISECONDS_PER_SEC +
-                           elapsed_time.tv_usec / MICROSECONDS_PER_MS ) ;
-        //
-        // If more than msTimeout milliseconds have elapsed while
-        // waiting for data, then we throw a ReadTimeout exception.
-        //
-        if ( ( msTimeout > 0 ) &&
-             ( elapsed_ms > (int)msTimeout ) )
+        MutexLock reactor_lock( mReactorMutex ) ;
+        if ( &serialReactor != mSerialReactor )
         {
-            throw SerialPort::ReadTimeout() ;
+            throw std::logic_error( ERR_MSG_REACTOR_NOT_ATTACHED ) ;
         }
-        //
-        // Wait for 1ms (1000us) for data to arrive.
-        //
-        usleep( MICROSECONDS_PER_MS ) ;
-        pthread_mutex_lock(&mQueueMutex);
-		queueSize = mInputBuffer.size();
-		pthread_mutex_unlock(&mQueueMutex);
+        this->SwitchFromReactorToSignal() ;
     }
     //
-    // Return the first byte and remove it from the queue.
+    // Pick up any data that arrived while switching.
     //
-    pthread_mutex_lock(&mQueueMutex);
-    unsigned char next_char = mInputBuffer.front() ;
-    mInputBuffer.pop() ;
-
-    //Updating flag if queue is empty by now
-    if ( mInputBuffer.size() == 0)
-    {
-    	mIsQueueDataAvailable = false;
-    }
-    pthread_mutex_unlock(&mQueueMutex);
-
-    return next_char ;
+    this->FillInputBuffer() ;
+    return ;
 }
 
 inline
 void
-SerialPort::SerialPortImpl::Read( SerialPort::DataBuffer& dataBuffer,
-                                  const unsigned int      numOfBytes,
-                                  const unsigned int      msTimeout )
-    throw( SerialPort::NotOpen,
-           SerialPort::ReadTimeout,
-           std::runtime_error )
+SerialPort::SerialPortImpl::SwitchFromReactorToSignal()
+    throw( std::runtime_error )
 {
     //
-    // Make sure that the serial port is open.
-    //
-    if ( ! this->IsOpen() )
-    {
-        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
-    }
+    // Turn SIGIO back on before the reactor stops watching the port.
     //
-    // Empty the data buffer.
+    this->EnableSignalDrivenInput() ;
+    mSerialReactor->UnregisterHandler( *this ) ;
+    mSerialReactor = 0 ;
+    return ;
+}
+
+inline
+void
+SerialPort::SerialPortImpl::EnableSignalDrivenInput()
+    throw( std::runtime_error )
+{
     //
-    dataBuffer.resize(0) ;
+    // Select the signal raised for the port. Zero restores the default
+    // SIGIO. A real-time signal also carries the file descriptor of the
+    // port, which lets the signal dispatcher call only this instance.
     //
-    if ( 0 == numOfBytes )
+    if ( fcntl( mFileDescriptor,
+                F_SETSIG,
+                ( SIGIO == mInputSignal ) ? 0 : mInputSignal ) < 0 )
     {
-        //
-        // Read all available data if numOfBytes is zero.
-        //
-        while( this->IsDataAvailable() )
-        {
-            dataBuffer.push_back( ReadByte(msTimeout) ) ;
-        }
+        throw std::runtime_error( strerror(errno) ) ;
     }
-    else
+    PosixSignalDispatcher& signal_dispatcher = PosixSignalDispatcher::Instance() ;
+    signal_dispatcher.AttachHandler( mInputSignal,
+                                     mFileDescriptor,
+                                     *this ) ;
+    if ( fcntl( mFileDescriptor,
+                F_SETFL,
+                FASYNC | O_NONBLOCK ) < 0 )
     {
-        //
-        // Reserve enough space in the buffer to store the incoming
-        // data.
-        //
-        dataBuffer.reserve( numOfBytes ) ;
-        //
-        for(unsigned int i=0; i<numOfBytes; ++i)
-        {
-            dataBuffer.push_back( ReadByte(msTimeout) ) ;
-        }
+        const int error_number = errno ;
+        signal_dispatcher.DetachHandler( mInputSignal,
+                                         mFileDescriptor,
+                                         *this ) ;
+        throw std::runtime_error( strerror(error_number) ) ;
     }
     return ;
 }
 
 inline
-const std::string
-SerialPort::SerialPortImpl::ReadLine( const unsigned int msTimeout,
-                                      const char         lineTerminator )
-    throw( SerialPort::NotOpen,
-           SerialPort::ReadTimeout,
-           std::runtime_error )
+void
+SerialPort::SerialPortImpl::DisableSignalDrivenInput()
+    throw( std::runtime_error )
 {
-    std::string result ;
-    char next_char = 0 ;
-    do
+    //
+    // Stop the signals before detaching from the dispatcher. Detach even
+    // if that fails so that the dispatcher never calls a destroyed
+    // instance.
+    //
+    const int error_number =
+        ( fcntl( mFileDescriptor, F_SETFL, O_NONBLOCK ) < 0 ) ? errno : 0 ;
+    PosixSignalDispatcher& signal_dispatcher = PosixSignalDispatcher::Instance() ;
+    signal_dispatcher.DetachHandler( mInputSignal,
+                                     mFileDescriptor,
+                                     *this ) ;
+    if ( 0 != error_number )
     {
-        next_char = this->ReadByte( msTimeout ) ;
-        result += next_char ;
+        throw std::runtime_error( strerror(error_number) ) ;
     }
-    while( next_char != lineTerminator ) ;
-    return result ;
+    return ;
 }
 
 inline
 void
-SerialPort::SerialPortImpl::WriteByte( const unsigned char dataByte )
-    throw( SerialPort::NotOpen,
-           std::runtime_error )
+SerialPort::SerialPortImpl::HandleInputReady()
+{
+    IncrementSharedCounter( mNumOfReactorEvents ) ;
+    this->FillInputBuffer() ;
+    return ;
+}
+
+inline
+void
+SerialPort::SerialPortImpl::HandleReactorShutdown()
 {
     //
-    // Make sure that the serial port is open.
+    // The reactor is going away; fall back to SIGIO. If that fails,
+    // at least stop using the reactor so that it can be destroyed.
+    // Do nothing if the port has been closed or detached in the
+    // meantime.
     //
-    if ( ! this->IsOpen() )
     {
-        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+        MutexLock reactor_lock( mReactorMutex ) ;
+        if ( 0 == mSerialReactor )
+        {
+            return ;
+        }
+        try
+        {
+            this->SwitchFromReactorToSignal() ;
+        }
+        catch( std::exception& )
+        {
+            mSerialReactor->UnregisterHandler( *this ) ;
+            mSerialReactor = 0 ;
+            return ;
+        }
     }
     //
-    // Write the byte to the serial port.
+    // Pick up any data that arrived while switching.
     //
-    this->Write( &dataByte,
-                 1 ) ;
+    this->FillInputBuffer() ;
     return ;
 }
 
 inline
 void
-SerialPort::SerialPortImpl::Write(const SerialPort::DataBuffer& dataBuffer)
-    throw( SerialPort::NotOpen,
-           std::runtime_error )
+SerialPort::SerialPortImpl::FillInputBuffer()
 {
-    //
-    // Make sure that the serial port is open.
-    //
-    if ( ! this->IsOpen() )
+    while( true )
     {
-        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+        //
+        // Become the only producer of mInputBuffer. If another thread
+        // is already filling the buffer, ask it to make another pass
+        // and leave. The second attempt makes sure that the request
+        // is not lost if the other thread finished in the meantime.
+        //
+        if ( mIsFillingInputBuffer.exchange( true ) )
+        {
+            IncrementSharedCounter( mNumOfFillContentions ) ;
+            mIsFillPending = true ;
+            if ( mIsFillingInputBuffer.exchange( true ) )
+            {
+                return ;
+            }
+        }
+        mIsFillPending = false ;
+        const size_t initial_size = mInputBuffer.Size() ;
+        //
+        // Read all available data straight into the free space of the
+        // input buffer. The free space is at most two regions (if it
+        // wraps around the end of the buffer), so a single readv() call
+        // usually drains the tty. The port is non-blocking, so the
+        // call returns immediately if there is no data. If the buffer
+        // fills up completely, the input overflow policy decides what
+        // happens to the remaining data.
+        //
+        while( true )
+        {
+            struct iovec free_regions[2] ;
+            const size_t free_space = mInputBuffer.GetWriteRegions( free_regions ) ;
+            if ( 0 == free_space )
+            {
+                if ( ! this->HandleInputOverflow() )
+                {
+                    break ;
+                }
+                continue ;
+            }
+            const ssize_t num_of_bytes_read = readv( mFileDescriptor,
+                                                     free_regions,
+                                                     ( free_regions[1].iov_len > 0 ? 2 : 1 ) ) ;
+            AddToCounter( mNumOfReadCalls ) ;
+            if ( num_of_bytes_read <= 0 )
+            {
+                /*
+                 * No more data or an error. Errors are ignored here.
+                 */
+                break ;
+            }
+            this->AddInputTimestamp( num_of_bytes_read,
+                                     GetMonotonicTime() ) ;
+            mInputBuffer.CommitWrite( num_of_bytes_read ) ;
+            AddToCounter( mNumOfBytesReceived,
+                          num_of_bytes_read ) ;
+            //
+            // A short read means that the tty has been drained.
+            //
+            if ( static_cast<size_t>(num_of_bytes_read) < free_space )
+            {
+                break ;
+            }
+        }
+        //
+        // Wake up any reader that is waiting for data.
+        //
+        const size_t final_size = mInputBuffer.Size() ;
+        if ( final_size > mInputBufferHighWaterMark )
+        {
+            mInputBufferHighWaterMark = final_size ;
+        }
+        if ( final_size != initial_size )
+        {
+            const char wakeup_byte = 0 ;
+            if ( write( mWakeupPipe[1],
+                        &wakeup_byte,
+                        1 ) < 0 )
+            {
+                /*
+                 * The pipe is full, so a wakeup is already pending.
+                 */
+            }
+        }
+        mIsFillingInputBuffer = false ;
+        //
+        // Make another pass if somebody asked for it while we were
+        // busy.
+        //
+        if ( ! mIsFillPending )
+        {
+            break ;
+        }
     }
+    return ;
+}
+
+inline
+bool
+SerialPort::SerialPortImpl::HandleInputOverflow()
+{
     //
-    // Nothing needs to be done if there is no data in the buffer.
+    // Data held by AcquireReadable() must not be discarded. See
+    // AcquireInputBuffer() for why checking the flag here is sufficient.
     //
-    if ( 0 == dataBuffer.size() )
+    int overflow_policy = mInputOverflowPolicy ;
+    if ( ( SerialPort::INPUT_OVERFLOW_DROP_OLDEST == overflow_policy ) &&
+         mIsInputBufferAcquired )
     {
-        return ;
+        overflow_policy = SerialPort::INPUT_OVERFLOW_BACKPRESSURE ;
     }
-    //
-    // Allocate memory for storing the contents of the
-    // dataBuffer. This allows us to write all the data using a single
-    // call to write() instead of writing one byte at a time.
-    //
-    unsigned char* local_buffer = new unsigned char[dataBuffer.size()] ;
-    if ( 0 == local_buffer )
+    if ( ( SerialPort::INPUT_OVERFLOW_DROP_OLDEST != overflow_policy ) &&
+         ( SerialPort::INPUT_OVERFLOW_DROP_NEWEST != overflow_policy ) )
     {
-        throw std::runtime_error( std::string(__FUNCTION__) +
-                                  ": Cannot allocate memory while writing"
-                                  "data to the serial port." ) ;
+        //
+        // Leave the data in the tty until a reader has made room for it.
+        //
+        mHasPendingKernelData = true ;
+        ++mNumOfInputBackpressureEvents ;
+        return false ;
     }
-    //
-    // Copy the data into local_buffer.
-    //
-    std::copy( dataBuffer.begin(),
-               dataBuffer.end(),
-               local_buffer ) ;
-    //
-    // Write data to the serial port.
-    //
-    try
+    const ssize_t num_of_bytes_read = read( mFileDescriptor,
+                                            &mInputOverflowBuffer[0],
+                                            mInputOverflowBuffer.size() ) ;
+    AddToCounter( mNumOfReadCalls ) ;
+    if ( num_of_bytes_read <= 0 )
     {
-        this->Write( local_buffer,
-                     dataBuffer.size() ) ;
+        return false ;
     }
-    catch( ... )
+    AddToCounter( mNumOfBytesReceived,
+                  num_of_bytes_read ) ;
+    size_t num_of_bytes_dropped = num_of_bytes_read ;
+    if ( SerialPort::INPUT_OVERFLOW_DROP_OLDEST == overflow_policy )
     {
+        this->AddInputTimestamp( num_of_bytes_read,
+                                 GetMonotonicTime() ) ;
         //
-        // Free the allocated memory.
+        // Replace the oldest data with the data just read. A reader may
+        // be making room at the same time, in which case less data has
+        // to be discarded.
         //
-        delete [] local_buffer ;
-        throw ;
+        num_of_bytes_dropped = 0 ;
+        size_t num_of_bytes_written = 0 ;
+        while( true )
+        {
+            num_of_bytes_written +=
+                mInputBuffer.Write( &mInputOverflowBuffer[num_of_bytes_written],
+                                    num_of_bytes_read - num_of_bytes_written ) ;
+            if ( static_cast<size_t>(num_of_bytes_read) == num_of_bytes_written )
+            {
+                break ;
+            }
+            num_of_bytes_dropped +=
+                mInputBuffer.Discard( num_of_bytes_read - num_of_bytes_written ) ;
+        }
     }
+    mNumOfDroppedInputBytes += num_of_bytes_dropped ;
     //
-    // Free the allocated memory.
+    // A short read means that the tty has been drained.
     //
-    delete [] local_buffer ;
-    return ;
+    return ( static_cast<size_t>(num_of_bytes_read) == mInputOverflowBuffer.size() ) ;
 }
 
 inline
 void
-SerialPort::SerialPortImpl::Write( const unsigned char* dataBuffer,
-                                   const unsigned int   bufferSize )
-    throw( SerialPort::NotOpen,
-           std::runtime_error )
+SerialPort::SerialPortImpl::AddInputTimestamp( const size_t    numOfBytes,
+                                               const long long arrivalTime )
 {
     //
-    // Make sure that the serial port is open.
+    // If too many chunks are waiting to be read, the arrival time of the
+    // chunk is simply not kept. Its data is then attributed to the next
+    // chunk.
     //
-    if ( ! this->IsOpen() )
+    struct iovec free_regions[2] ;
+    if ( mInputTimestamps.GetWriteRegions( free_regions ) < sizeof( InputTimestamp ) )
     {
-        throw SerialPort::NotOpen( ERR_MSG_PORT_NOT_OPEN ) ;
+        return ;
     }
+    InputTimestamp input_timestamp ;
+    input_timestamp.mEndPosition = mInputBuffer.GetWritePosition() + numOfBytes ;
+    input_timestamp.mArrivalTime = arrivalTime ;
+    mInputTimestamps.Write( reinterpret_cast<const unsigned char*>( &input_timestamp ),
+                            sizeof( input_timestamp ) ) ;
+    return ;
+}
+
+inline
+void
+SerialPort::SerialPortImpl::AppendArrivalTimes( const size_t              readPosition,
+                                                const size_t              numOfBytes,
+                                                const size_t              arrivalOffset,
+                                                SerialPort::ArrivalTimes& arrivalTimes ) const
+{
     //
-    // Write the data to the serial port. Keep retrying if EAGAIN
-    // error is received.
-    //
-    int num_of_bytes_written = -1 ;
-    do
+    // Walk the timestamps from the oldest one and add an entry for each
+    // chunk that overlaps the bytes read. Timestamps of chunks that
+    // ended before readPosition have not been removed yet and are
+    // skipped.
+    //
+    const size_t end_position = readPosition + numOfBytes ;
+    size_t position = readPosition ;
+    long long arrival_time ;
+    struct iovec regions[2] ;
+    mInputTimestamps.GetReadRegions( regions ) ;
+    for( int i=0; ( i<2 ) && ( position < end_position ); ++i )
     {
-        num_of_bytes_written = write( mFileDescriptor,
-                                      dataBuffer,
-                                      bufferSize ) ;
+        const InputTimestamp* const input_timestamps =
+            static_cast<const InputTimestamp*>( regions[i].iov_base ) ;
+        const size_t num_of_input_timestamps = regions[i].iov_len / sizeof( InputTimestamp ) ;
+        for( size_t j=0; ( j<num_of_input_timestamps ) && ( position < end_position ); ++j )
+        {
+            if ( input_timestamps[j].mEndPosition <= position )
+            {
+                continue ;
+            }
+            arrival_time = input_timestamps[j].mArrivalTime ;
+            if ( arrivalTimes.empty() ||
+                 ( arrivalTimes.back().timestamp != arrival_time ) )
+            {
+                SerialPort::ArrivalTime arrival ;
+                arrival.offset    = arrivalOffset + ( position - readPosition ) ;
+                arrival.timestamp = arrival_time ;
+                arrivalTimes.push_back( arrival ) ;
+            }
+            position = std::min( input_timestamps[j].mEndPosition,
+                                 end_position ) ;
+        }
     }
-    while ( ( num_of_bytes_written < 0 ) &&
-            ( EAGAIN == errno ) ) ;
     //
-    if ( num_of_bytes_written < 0 )
+    // The arrival time of the remaining bytes was not kept because too
+    // many chunks were waiting to be read.
+    //
+    if ( position < end_position )
     {
-        throw std::runtime_error( strerror(errno) ) ;
+        SerialPort::ArrivalTime arrival ;
+        arrival.offset    = arrivalOffset + ( position - readPosition ) ;
+        arrival.timestamp = GetMonotonicTime() ;
+        arrivalTimes.push_back( arrival ) ;
     }
-    //
-    // :FIXME: What happens if num_of_bytes_written < bufferSize ?
-    //
     return ;
 }
 
 inline
 void
-SerialPort::SerialPortImpl::SetDtr( const bool dtrState )
-    throw( SerialPort::NotOpen,
-           std::runtime_error )
+SerialPort::SerialPortImpl::RemoveInputTimestamps()
 {
-    this->SetModemControlLine( TIOCM_DTR, 
-                               dtrState ) ;
+    const size_t read_position = mInputBuffer.GetReadPosition() ;
+    const bool is_input_latency_enabled = mIsInputLatencyEnabled ;
+    long long current_time = -1 ;
+    while( true )
+    {
+        struct iovec regions[2] ;
+        if ( mInputTimestamps.GetReadRegions( regions ) < sizeof( InputTimestamp ) )
+        {
+            break ;
+        }
+        InputTimestamp input_timestamp ;
+        std::memcpy( &input_timestamp,
+                     regions[0].iov_base,
+                     sizeof( input_timestamp ) ) ;
+        if ( input_timestamp.mEndPosition > read_position )
+        {
+            break ;
+        }
+        if ( is_input_latency_enabled )
+        {
+            if ( current_time < 0 )
+            {
+                current_time = GetMonotonicTime() ;
+            }
+            mInputLatencyHistogram.load()->Record( current_time - input_timestamp.mArrivalTime ) ;
+        }
+        mInputTimestamps.Consume( sizeof( input_timestamp ) ) ;
+    }
     return ;
 }
 
 inline
-bool
-SerialPort::SerialPortImpl::GetDtr() const
-    throw( SerialPort::NotOpen,
-           std::runtime_error )
+size_t
+SerialPort::SerialPortImpl::ReadInputBuffer( unsigned char*            dataBuffer,
+                                             const size_t              maxNumOfBytes,
+                                             SerialPort::ArrivalTimes* arrivalTimes,
+                                             const size_t              arrivalOffset )
 {
-    return this->GetModemControlLine( TIOCM_DTR ) ;
-}    
+    size_t read_position ;
+    const size_t num_of_bytes_read = mInputBuffer.Read( dataBuffer,
+                                                        maxNumOfBytes,
+                                                        &read_position ) ;
+    if ( ( 0 != arrivalTimes ) &&
+         ( num_of_bytes_read > 0 ) )
+    {
+        this->AppendArrivalTimes( read_position,
+                                  num_of_bytes_read,
+                                  arrivalOffset,
+                                  *arrivalTimes ) ;
+    }
+    this->RemoveInputTimestamps() ;
+    //
+    // If data was left in the tty because the input buffer was full,
+    // move it into the room we just made.
+    //
+    if ( ( num_of_bytes_read > 0 ) &&
+         mHasPendingKernelData.exchange( false ) )
+    {
+        this->FillInputBuffer() ;
+    }
+    return num_of_bytes_read ;
+}
+
+inline
+size_t
+SerialPort::SerialPortImpl::AcquireInputBuffer( struct iovec regions[2] )
+{
+    //
+    // Keep the producer from discarding data from now on. A fill that
+    // started before the flag was set may not have seen it, so wait for
+    // it to finish. Any later fill sees the flag.
+    //
+    mIsInputBufferAcquired = true ;
+    while( mIsFillingInputBuffer )
+    {
+        sched_yield() ;
+    }
+    return mInputBuffer.GetReadRegions( regions ) ;
+}
 
 inline
 void
-SerialPort::SerialPortImpl::SetRts( const bool rtsState )
-    throw( SerialPort::NotOpen,
-           std::runtime_error )
+SerialPort::SerialPortImpl::ReleaseInputBuffer()
 {
-    this->SetModemControlLine( TIOCM_RTS, 
-                               rtsState ) ;
+    mIsInputBufferAcquired = false ;
+    //
+    // If data was left in the tty because the input buffer was full,
+    // move it into the input buffer now. Either room has been made or
+    // the overflow policy may discard data again.
+    //
+    if ( mHasPendingKernelData.exchange( false ) )
+    {
+        this->FillInputBuffer() ;
+    }
     return ;
 }
 
 inline
 bool
-SerialPort::SerialPortImpl::GetRts() const
-    throw( SerialPort::NotOpen,
-           std::runtime_error )
+SerialPort::SerialPortImpl::IsReadableAcquiredByThisThread() const
 {
-    return this->GetModemControlLine( TIOCM_RTS ) ;
-}    
-
+    return ( mIsReadableAcquired &&
+             pthread_equal( mReadableOwner, pthread_self() ) ) ;
+}
 
 inline
 bool
-SerialPort::SerialPortImpl::GetCts() const
-    throw( SerialPort::NotOpen,
-           std::runtime_error )
+SerialPort::SerialPortImpl::WaitForInputData( const long long deadline,
+                                              const size_t    minNumOfBytes )
+    throw( std::runtime_error )
 {
-    return this->GetModemControlLine( TIOCM_CTS ) ;
-}    
-
+    while( mInputBuffer.Size() < minNumOfBytes )
+    {
+        //
+        // Only one reader polls the wakeup pipe. The others wait until
+        // it wakes up and check the input buffer again, or take over
+        // once it is done.
+        //
+        if ( mIsReaderPolling )
+        {
+            if ( ( ! this->WaitForInputDataCondition( deadline ) ) &&
+                 ( mInputBuffer.Size() < minNumOfBytes ) )
+            {
+                AddToCounter( mNumOfReadTimeouts ) ;
+                return false ;
+            }
+            continue ;
+        }
+        //
+        // Consume pending wakeups before checking the input buffer
+        // again. Data added after this check will write a new byte to
+        // the pipe and end the poll() below.
+        //
+        char wakeup_bytes[64] ;
+        while( read( mWakeupPipe[0],
+                     wakeup_bytes,
+                     sizeof(wakeup_bytes) ) > 0 )
+        {
+            /* empty */
+        }
+        if ( mInputBuffer.Size() >= minNumOfBytes )
+        {
+            break ;
+        }
+        const int poll_timeout = GetPollTimeout( deadline ) ;
+        if ( 0 == poll_timeout )
+        {
+            AddToCounter( mNumOfReadTimeouts ) ;
+            return false ;
+        }
+        //
+        // Sleep until the producer signals that data has arrived. Other
+        // readers may use the serial port in the meantime.
+        //
+        struct pollfd wakeup_fd ;
+        wakeup_fd.fd      = mWakeupPipe[0] ;
+        wakeup_fd.events  = POLLIN ;
+        wakeup_fd.revents = 0 ;
+        mIsReaderPolling = true ;
+        pthread_mutex_unlock( &mQueueMutex ) ;
+        const int poll_result = poll( &wakeup_fd,
+                                      1,
+                                      poll_timeout ) ;
+        const int poll_errno = errno ;
+        pthread_mutex_lock( &mQueueMutex ) ;
+        mIsReaderPolling = false ;
+        pthread_cond_broadcast( &mInputDataCondition ) ;
+        if ( poll_result > 0 )
+        {
+            AddToCounter( mNumOfReaderWakeups ) ;
+        }
+        else if ( ( poll_result < 0 ) &&
+                  ( EINTR != poll_errno ) )
+        {
+            throw std::runtime_error( strerror(poll_errno) ) ;
+        }
+    }
+    return true ;
+}
 
 inline
 bool
-SerialPort::SerialPortImpl::GetDsr() const
-    throw( SerialPort::NotOpen,
-           std::runtime_error )
+SerialPort::SerialPortImpl::WaitForInputDataCondition( const long long deadline )
 {
-    return this->GetModemControlLine( TIOCM_DSR ) ;
-}    
+    if ( NO_DEADLINE == deadline )
+    {
+        pthread_cond_wait( &mInputDataCondition,
+                           &mQueueMutex ) ;
+        return true ;
+    }
+    const long long NANOSECONDS_PER_SECOND = 1000000000LL ;
+    struct timespec wait_deadline ;
+    wait_deadline.tv_sec  = deadline / NANOSECONDS_PER_SECOND ;
+    wait_deadline.tv_nsec = deadline % NANOSECONDS_PER_SECOND ;
+    return ( ETIMEDOUT != pthread_cond_timedwait( &mInputDataCondition,
+                                                  &mQueueMutex,
+                                                  &wait_deadline ) ) ;
+}
 
 inline
-void
-SerialPort::SerialPortImpl::HandlePosixSignal( int signalNumber )
+int
+SerialPort::SerialPortImpl::WriteData( const unsigned char* dataBuffer,
+                                       const size_t         bufferSize,
+                                       const long long      deadline,
+                                       size_t&              numOfBytesWritten )
 {
     //
-    // We only want to deal with SIGIO signals here.
+    // Keep writing until all data has been accepted by the operating
+    // system. The port is non-blocking, so write() may accept only
+    // part of the data or fail with EAGAIN when the output buffer of
+    // the tty is full (e.g. while the peer holds off transmission via
+    // flow control). In that case wait for the port to become writable
+    // instead of retrying right away.
     //
-    if ( SIGIO != signalNumber )
+    numOfBytesWritten = 0 ;
+    while( numOfBytesWritten < bufferSize )
     {
-        return ;
+        const ssize_t write_result = write( mFileDescriptor,
+                                            dataBuffer + numOfBytesWritten,
+                                            bufferSize - numOfBytesWritten ) ;
+        AddToCounter( mNumOfWriteCalls ) ;
+        if ( write_result > 0 )
+        {
+            numOfBytesWritten += write_result ;
+            AddToCounter( mNumOfBytesTransmitted,
+                          write_result ) ;
+            continue ;
+        }
+        if ( ( write_result < 0 ) &&
+             ( EINTR == errno ) )
+        {
+            continue ;
+        }
+        if ( ( write_result < 0 ) &&
+             ( EAGAIN != errno ) &&
+             ( EWOULDBLOCK != errno ) )
+        {
+            return errno ;
+        }
+        const int wait_result = this->WaitForOutputSpace( deadline ) ;
+        if ( 0 != wait_result )
+        {
+            return wait_result ;
+        }
     }
-    //
-    // Check if any data is available at the specified file
-    // descriptor.
-    //
-    int num_of_bytes_available = 0 ;
-    if ( ioctl( mFileDescriptor,
-                FIONREAD,
-                &num_of_bytes_available ) < 0 )
+    return 0 ;
+}
+
+inline
+int
+SerialPort::SerialPortImpl::WaitForOutputSpace( const long long deadline )
+{
+    while( true )
     {
-        /*
-         * Ignore any errors and return immediately.
-         */
-        return ;
+        const int poll_timeout = GetPollTimeout( deadline ) ;
+        if ( 0 == poll_timeout )
+        {
+            return ETIMEDOUT ;
+        }
+        struct pollfd port_fd ;
+        port_fd.fd      = mFileDescriptor ;
+        port_fd.events  = POLLOUT ;
+        port_fd.revents = 0 ;
+        const int poll_result = poll( &port_fd,
+                                      1,
+                                      poll_timeout ) ;
+        if ( poll_result > 0 )
+        {
+            return 0 ;
+        }
+        if ( ( poll_result < 0 ) &&
+             ( EINTR != errno ) )
+        {
+            return errno ;
+        }
+    }
+}
+
+inline
+void*
+SerialPort::SerialPortImpl::AsyncWriterThread( void* serialPortImpl )
+{
+    static_cast<SerialPortImpl*>( serialPortImpl )->AsyncWriterLoop() ;
+    return 0 ;
+}
+
+inline
+void
+SerialPort::SerialPortImpl::AsyncWriterLoop()
+{
+    while( true )
+    {
+        //
+        // Wait for the next request.
+        //
+        AsyncWriteRequest request ;
+        {
+            MutexLock async_lock( mAsyncWriteMutex ) ;
+            while( ( 0 == mNumOfAsyncWriteRequests ) &&
+                   ( ! mIsAsyncWriterStopping ) )
+            {
+                pthread_cond_wait( &mAsyncWriteCondition,
+                                   &mAsyncWriteMutex ) ;
+            }
+            if ( 0 == mNumOfAsyncWriteRequests )
+            {
+                return ;
+            }
+            request = mAsyncWriteRequests[ mFirstAsyncWriteRequest ] ;
+        }
+        //
+        // Write the data of the request straight out of the queue.
+        // Hold mWriteMutex for the whole request so that data written
+        // with Write() cannot end up in the middle of it. Wake up
+        // regularly to check whether we have been asked to stop.
+        //
+        size_t num_of_bytes_written = 0 ;
+        int    error_number         = 0 ;
+        {
+            MutexLock write_lock( mWriteMutex ) ;
+            while( num_of_bytes_written < request.mNumOfBytes )
+            {
+                if ( mIsAsyncWriterStopping )
+                {
+                    error_number = ECANCELED ;
+                    break ;
+                }
+                struct iovec regions[2] ;
+                mAsyncWriteBuffer->GetReadRegions( regions ) ;
+                size_t num_of_chunk_bytes_written = 0 ;
+                error_number = this->WriteData( static_cast<const unsigned char*>( regions[0].iov_base ),
+                                                std::min( regions[0].iov_len,
+                                                          request.mNumOfBytes - num_of_bytes_written ),
+                                                GetDeadline( ASYNC_WRITER_POLL_INTERVAL ),
+                                                num_of_chunk_bytes_written ) ;
+                mAsyncWriteBuffer->Consume( num_of_chunk_bytes_written ) ;
+                num_of_bytes_written += num_of_chunk_bytes_written ;
+                if ( ETIMEDOUT == error_number )
+                {
+                    error_number = 0 ;
+                }
+                if ( 0 != error_number )
+                {
+                    break ;
+                }
+            }
+        }
+        //
+        // Discard the rest of a failed request.
+        //
+        mAsyncWriteBuffer->Consume( request.mNumOfBytes - num_of_bytes_written ) ;
+        if ( 0 != mWriteCompletionHandler )
+        {
+            mWriteCompletionHandler->HandleWriteCompletion( request.mTicket,
+                                                            num_of_bytes_written,
+                                                            error_number ) ;
+        }
+        //
+        // Remove the request from the queue only after the handler has
+        // been called so that WaitForAsyncWrites() does not return
+        // before all notifications have been delivered.
+        //
+        MutexLock async_lock( mAsyncWriteMutex ) ;
+        mFirstAsyncWriteRequest = ( mFirstAsyncWriteRequest + 1 ) % mAsyncWriteRequests.size() ;
+        --mNumOfAsyncWriteRequests ;
+        pthread_cond_broadcast( &mAsyncWriteCondition ) ;
     }
+}
 
-    //Try to get the mutex
-    if (pthread_mutex_trylock(&mQueueMutex) == 0)
-    {
-    	// First of all, any pending data within the mShadowInputBuffer
-    	// must be transfered into the regular buffer.
-    	while(!mShadowInputBuffer.empty())
-		{
-    		//Transfering to actual input buffer
-    		mInputBuffer.push(mShadowInputBuffer.front());
-    		//Removing from shadow buffer
-    		mShadowInputBuffer.pop();
-		}
-
-		//
-		// If data is available, read all available data and shove
-		// it into the corresponding input buffer.
-		//
-		for(int i=0; i<num_of_bytes_available; ++i)
-		{
-			unsigned char next_byte ;
-			if ( read( mFileDescriptor,
-					   &next_byte,
-					   1 ) > 0 )
-			{
-				mInputBuffer.push( next_byte );
-			}
-			else
-			{
-				//Updating flag
-				pthread_mutex_unlock(&mQueueMutex);
-				break ;
-			}
-		}
-
-		//Updating flag
-		mIsQueueDataAvailable = true;
-
-		//Release the mutex
-		pthread_mutex_unlock(&mQueueMutex);
-    } else {
-    	//Mutex is locked - using shadowQueue to avoid a deadlock!
-    	//
-		// If data is available, read all available data and shove
-		// it temporarily into the shadow buffer.
-		//
-		for(int i=0; i<num_of_bytes_available; ++i)
-		{
-			unsigned char next_byte ;
-			if ( read( mFileDescriptor,
-					   &next_byte,
-					   1 ) > 0 )
-			{
-				mShadowInputBuffer.push( next_byte );
-			}
-			else
-			{
-				break ;
-			}
-		}
+inline
+void
+SerialPort::SerialPortImpl::StopAsyncWriter()
+{
+    {
+        MutexLock async_lock( mAsyncWriteMutex ) ;
+        if ( ! mIsAsyncWriterRunning )
+        {
+            return ;
+        }
+        mIsAsyncWriteEnabled   = false ;
+        mIsAsyncWriterStopping = true ;
+        pthread_cond_broadcast( &mAsyncWriteCondition ) ;
     }
+    pthread_join( mAsyncWriterThread,
+                  NULL ) ;
+    //
+    MutexLock async_lock( mAsyncWriteMutex ) ;
+    delete mAsyncWriteBuffer ;
+    mAsyncWriteBuffer = 0 ;
+    mAsyncWriteRequests.clear() ;
+    mNumOfAsyncWriteRequests = 0 ;
+    mIsAsyncWriterRunning    = false ;
     return ;
 }
 
@@ -1714,35 +4303,300 @@ SerialPort::SerialPortImpl::GetModemControlLine( const int modemLine ) const
 
 namespace
 {
-    const struct timeval
-    operator-( const struct timeval& firstOperand,
-               const struct timeval& secondOperand )
+    long long
+    GetMonotonicTime()
     {
-        /*
-         * This implementation may result in undefined behavior if the
-         * platform uses unsigned values for storing tv_sec and tv_usec
-         * members of struct timeval.
-         */
+        const long long NANOSECONDS_PER_SECOND = 1000000000LL ;
+        struct timespec current_time ;
+        clock_gettime( CLOCK_MONOTONIC,
+                       &current_time ) ;
+        return ( current_time.tv_sec * NANOSECONDS_PER_SECOND +
+                 current_time.tv_nsec ) ;
+    }
+
+    long long
+    GetDeadline( const unsigned int msTimeout )
+    {
+        const long long NANOSECONDS_PER_MS = 1000000LL ;
+        if ( 0 == msTimeout )
+        {
+            return NO_DEADLINE ;
+        }
+        return ( GetMonotonicTime() + msTimeout * NANOSECONDS_PER_MS ) ;
+    }
+
+    int
+    GetPollTimeout( const long long deadline )
+    {
+        if ( NO_DEADLINE == deadline )
+        {
+            return -1 ;
+        }
+        const long long time_left = deadline - GetMonotonicTime() ;
+        if ( time_left <= 0 )
+        {
+            return 0 ;
+        }
+        return ( time_left + 999999 ) / 1000000 ;
+    }
+
+    size_t
+    FindLineEnd( const struct iovec regions[2],
+                 const size_t       numOfBytes,
+                 const std::string& lineStart,
+                 const std::string& lineTerminator )
+    {
+        const char last_char = lineTerminator[ lineTerminator.size() - 1 ] ;
+        size_t region_offset = 0 ;
+        for( int i = 0 ; i < 2 ; ++i )
+        {
+            const char* region_begin = static_cast<const char*>( regions[i].iov_base ) ;
+            const char* region_end   = region_begin +
+                std::min( regions[i].iov_len, numOfBytes - region_offset ) ;
+            const char* next_char    = region_begin ;
+            while( 0 != ( next_char = static_cast<const char*>(
+                              memchr( next_char,
+                                      last_char,
+                                      region_end - next_char ) ) ) )
+            {
+                //
+                // Compare the rest of the terminator backwards. The
+                // preceding characters may be in the first region or in
+                // lineStart.
+                //
+                const size_t line_end = region_offset + ( next_char - region_begin ) + 1 ;
+                size_t matched = 1 ;
+                while( ( matched < lineTerminator.size() ) &&
+                       ( matched < lineStart.size() + line_end ) )
+                {
+                    const size_t position = lineStart.size() + line_end - matched - 1 ;
+                    char current_char = 0 ;
+                    if ( position < lineStart.size() )
+                    {
+                        current_char = lineStart[position] ;
+                    }
+                    else if ( position - lineStart.size() < regions[0].iov_len )
+                    {
+                        current_char = static_cast<const char*>( regions[0].iov_base )
+                            [ position - lineStart.size() ] ;
+                    }
+                    else
+                    {
+                        current_char = static_cast<const char*>( regions[1].iov_base )
+                            [ position - lineStart.size() - regions[0].iov_len ] ;
+                    }
+                    if ( current_char != lineTerminator[ lineTerminator.size() - matched - 1 ] )
+                    {
+                        break ;
+                    }
+                    ++matched ;
+                }
+                if ( matched == lineTerminator.size() )
+                {
+                    return line_end ;
+                }
+                ++next_char ;
+            }
+            region_offset += ( region_end - region_begin ) ;
+        }
+        return 0 ;
+    }
+
+    void
+    ApplyBaudRate( termios&                   portSettings,
+                   const SerialPort::BaudRate baudRate )
+        throw( SerialPort::UnsupportedBaudRate )
+    {
+        if ( ( cfsetispeed( &portSettings,
+                            baudRate ) < 0 ) ||
+             ( cfsetospeed( &portSettings,
+                            baudRate ) < 0 ) )
+        {
+            throw SerialPort::UnsupportedBaudRate( ERR_MSG_UNSUPPORTED_BAUD ) ;
+        }
+    }
+
+    void
+    ApplyCharSize( termios&                        portSettings,
+                   const SerialPort::CharacterSize charSize )
+    {
+        portSettings.c_cflag &= ~CSIZE ;
+        portSettings.c_cflag |= charSize ;
+    }
+
+    void
+    ApplyParity( termios&                 portSettings,
+                 const SerialPort::Parity parityType )
+        throw( std::invalid_argument )
+    {
+        switch( parityType )
+        {
+        case SerialPort::PARITY_EVEN:
+            portSettings.c_cflag |= PARENB ;
+            portSettings.c_cflag &= ~PARODD ;
+            portSettings.c_iflag |= INPCK ;
+            break ;
+        case SerialPort::PARITY_ODD:
+            portSettings.c_cflag |= ( PARENB | PARODD ) ;
+            portSettings.c_iflag |= INPCK ;
+            break ;
+        case SerialPort::PARITY_NONE:
+            portSettings.c_cflag &= ~(PARENB) ;
+            portSettings.c_iflag |= IGNPAR ;
+            break ;
+        default:
+            throw std::invalid_argument( ERR_MSG_INVALID_PARITY ) ;
+            break ;
+        }
+    }
+
+    void
+    ApplyNumOfStopBits( termios&                   portSettings,
+                        const SerialPort::StopBits numOfStopBits )
+        throw( std::invalid_argument )
+    {
+        switch( numOfStopBits )
+        {
+        case SerialPort::STOP_BITS_1:
+            portSettings.c_cflag &= ~(CSTOPB) ;
+            break ;
+        case SerialPort::STOP_BITS_2:
+            portSettings.c_cflag |= CSTOPB ;
+            break ;
+        default:
+            throw std::invalid_argument( ERR_MSG_INVALID_STOP_BITS ) ;
+            break ;
+        }
+    }
+
+    void
+    ApplyFlowControl( termios&                      portSettings,
+                      const SerialPort::FlowControl flowControl )
+        throw( std::invalid_argument )
+    {
+        switch( flowControl )
+        {
+        case SerialPort::FLOW_CONTROL_HARD:
+            portSettings.c_cflag |= CRTSCTS ;
+            break ;
+        case SerialPort::FLOW_CONTROL_NONE:
+            portSettings.c_cflag &= ~(CRTSCTS) ;
+            break ;
+        default:
+            throw std::invalid_argument( ERR_MSG_INVALID_FLOW_CONTROL ) ;
+            break ;
+        }
+    }
+
+    void
+    ApplyPortSettings( termios&                        portSettings,
+                       const SerialPort::PortSettings& newSettings )
+        throw( SerialPort::UnsupportedBaudRate,
+               std::invalid_argument )
+    {
+        ApplyBaudRate( portSettings,
+                       newSettings.baudRate ) ;
+        ApplyCharSize( portSettings,
+                       newSettings.charSize ) ;
+        ApplyParity( portSettings,
+                     newSettings.parityType ) ;
+        ApplyNumOfStopBits( portSettings,
+                            newSettings.stopBits ) ;
+        ApplyFlowControl( portSettings,
+                          newSettings.flowControl ) ;
+    }
+
+    SerialPort::BaudRate
+    ExtractBaudRate( const termios& portSettings )
+    {
+        //
+        // Obtain the input baud rate from the settings.
+        //
+        return SerialPort::BaudRate( cfgetispeed( &portSettings ) ) ;
+    }
+
+    SerialPort::CharacterSize
+    ExtractCharSize( const termios& portSettings )
+    {
+        return SerialPort::CharacterSize( portSettings.c_cflag & CSIZE ) ;
+    }
+
+    SerialPort::Parity
+    ExtractParity( const termios& portSettings )
+    {
+        if ( portSettings.c_cflag & PARENB )
+        {
+            //
+            // Parity is enabled. Lets check if it is odd or even.
+            //
+            if ( portSettings.c_cflag & PARODD )
+            {
+                return SerialPort::PARITY_ODD ;
+            }
+            else
+            {
+                return SerialPort::PARITY_EVEN ;
+            }
+        }
         //
-        // Number of microseconds in a second.
+        // Parity is disabled.
         //
-        const int MICROSECONDS_PER_SECOND = 1000000 ;
-        struct timeval result ;
+        return SerialPort::PARITY_NONE ;
+    }
+
+    SerialPort::StopBits
+    ExtractNumOfStopBits( const termios& portSettings )
+    {
         //
-        // Take the difference of individual members of the two operands.
+        // If CSTOPB is set then we are using two stop bits, otherwise we
+        // are using 1 stop bit.
         //
-        result.tv_sec  = firstOperand.tv_sec - secondOperand.tv_sec ;
-        result.tv_usec = firstOperand.tv_usec - secondOperand.tv_usec ;
+        if ( portSettings.c_cflag & CSTOPB )
+        {
+            return SerialPort::STOP_BITS_2 ;
+        }
+        return SerialPort::STOP_BITS_1 ;
+    }
+
+    SerialPort::FlowControl
+    ExtractFlowControl( const termios& portSettings )
+    {
         //
-        // If abs(result.tv_usec) is larger than MICROSECONDS_PER_SECOND,
-        // then increment/decrement result.tv_sec accordingly.
+        // If CRTSCTS is set then we are using hardware flow
+        // control. Otherwise, we are not using any flow control.
         //
-        if ( abs( result.tv_usec ) > MICROSECONDS_PER_SECOND )
+        if ( portSettings.c_cflag & CRTSCTS )
         {
-            int num_of_seconds = (result.tv_usec / MICROSECONDS_PER_SECOND ) ;
-            result.tv_sec  += num_of_seconds ;
-            result.tv_usec -= ( MICROSECONDS_PER_SECOND * num_of_seconds ) ;
+            return SerialPort::FLOW_CONTROL_HARD ;
         }
-        return result ;
+        return SerialPort::FLOW_CONTROL_NONE ;
+    }
+
+    MutexLock::MutexLock( pthread_mutex_t& mutex ) :
+        mMutex(mutex)
+    {
+        pthread_mutex_lock( &mMutex ) ;
+    }
+
+    MutexLock::~MutexLock()
+    {
+        pthread_mutex_unlock( &mMutex ) ;
+    }
+
+    inline
+    void
+    AddToCounter( std::atomic<unsigned long long>& counter,
+                  const unsigned long long         value )
+    {
+        counter.store( counter.load( std::memory_order_relaxed ) + value,
+                       std::memory_order_relaxed ) ;
+    }
+
+    inline
+    void
+    IncrementSharedCounter( std::atomic<unsigned long long>& counter )
+    {
+        counter.fetch_add( 1,
+                           std::memory_order_relaxed ) ;
     }
 }
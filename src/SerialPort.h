@@ -28,6 +28,7 @@
 #include <stdexcept>
 #include <termios.h>
 
+class SerialReactor ;
 
 //
 // @todo - This class will be placed in LibSerial namespace in the next 
@@ -47,6 +48,11 @@
  *
  * @FIXME: Provide examples of the above potential problem.
  *
+ * @note Applications using many serial ports can attach them to a
+ * SerialReactor instead. Attached ports do not use SIGIO. Alternatively,
+ * each port can be given a real-time signal with SetInputSignal() so
+ * that a signal only causes the port that received data to be read.
+ *
  * @todo The current implementation does not check if another process
  * has locked the serial port device and does not lock the serial port
  * device after opening it. This has been observed to cause problems
@@ -141,6 +147,17 @@ public:
         FLOW_CONTROL_DEFAULT = FLOW_CONTROL_NONE
     } ;
 
+    /**
+     * @brief What happens to arriving data while the input buffer of the
+     *        serial port is full.
+     */
+    enum InputOverflowPolicy {
+        INPUT_OVERFLOW_BACKPRESSURE, //!< Leave the data in the kernel's tty buffer so that flow control can stop the sender.
+        INPUT_OVERFLOW_DROP_OLDEST,  //!< Discard the oldest buffered data to make room.
+        INPUT_OVERFLOW_DROP_NEWEST,  //!< Discard the arriving data.
+        INPUT_OVERFLOW_DEFAULT = INPUT_OVERFLOW_BACKPRESSURE
+    } ;
+
     class NotOpen : public std::logic_error
     {
     public:
@@ -175,6 +192,112 @@ public:
         ReadTimeout() : runtime_error( "Read timeout" ) { }
     } ;
 
+    class WriteTimeout : public std::runtime_error
+    {
+    public:
+        WriteTimeout() : runtime_error( "Write timeout" ) { }
+    } ;
+
+    /**
+     * @brief Gets a method called when a write started with WriteAsync()
+     *        has completed. A WriteCompletionHandler must be passed to
+     *        EnableAsyncWrite() for it to be called.
+     */
+    class WriteCompletionHandler
+    {
+    public:
+        /**
+         * @brief This method is called by the writer thread of the serial
+         *        port when the write with the specified ticket has
+         *        completed. It must not call any write methods of the
+         *        serial port and should return quickly as no further data
+         *        is written until it returns.
+         * @param ticket The ticket returned by WriteAsync().
+         * @param numOfBytesWritten The number of bytes that were written.
+         * @param errorNumber Zero if all data was written. Otherwise the
+         *        errno value of the failure or ECANCELED if the write was
+         *        discarded because the serial port was closed.
+         */
+        virtual void HandleWriteCompletion( const unsigned long ticket,
+                                            const size_t        numOfBytesWritten,
+                                            const int           errorNumber ) = 0 ;
+
+        /**
+         * @brief Destructor is declared virtual as we expect this class to
+         *        be subclassed. It is also declared pure abstract to make
+         *        this class a pure abstract class.
+         */
+        virtual ~WriteCompletionHandler() = 0 ;
+    } ;
+
+    /**
+     * @brief A complete set of serial port parameters. All of them can be
+     *        applied to the serial port at once using SetPortSettings()
+     *        or Open() so that the port never passes through inconsistent
+     *        intermediate configurations.
+     */
+    struct PortSettings
+    {
+        explicit PortSettings( const BaudRate      baudRate    = BAUD_DEFAULT,
+                               const CharacterSize charSize    = CHAR_SIZE_DEFAULT,
+                               const Parity        parityType  = PARITY_DEFAULT,
+                               const StopBits      stopBits    = STOP_BITS_DEFAULT,
+                               const FlowControl   flowControl = FLOW_CONTROL_DEFAULT ) :
+            baudRate(baudRate),
+            charSize(charSize),
+            parityType(parityType),
+            stopBits(stopBits),
+            flowControl(flowControl)
+        {
+            /* empty */
+        }
+
+        BaudRate      baudRate ;
+        CharacterSize charSize ;
+        Parity        parityType ;
+        StopBits      stopBits ;
+        FlowControl   flowControl ;
+    } ;
+
+    /**
+     * @brief Counters describing the activity of a serial port. Returned
+     *        by GetStatistics().
+     */
+    struct Statistics
+    {
+        Statistics() :
+            numOfBytesReceived(0),
+            numOfBytesTransmitted(0),
+            numOfReadCalls(0),
+            numOfWriteCalls(0),
+            numOfInputSignals(0),
+            numOfReactorEvents(0),
+            numOfFillContentions(0),
+            numOfReaderWakeups(0),
+            numOfReadTimeouts(0),
+            numOfWriteTimeouts(0),
+            numOfDroppedInputBytes(0),
+            numOfInputBackpressureEvents(0),
+            inputBufferHighWaterMark(0)
+        {
+            /* empty */
+        }
+
+        unsigned long long numOfBytesReceived ;           //!< Bytes read from the serial port, including dropped bytes.
+        unsigned long long numOfBytesTransmitted ;        //!< Bytes accepted by write().
+        unsigned long long numOfReadCalls ;               //!< read() and readv() calls on the serial port.
+        unsigned long long numOfWriteCalls ;              //!< write() calls on the serial port.
+        unsigned long long numOfInputSignals ;            //!< Input signals handled (see SetInputSignal()).
+        unsigned long long numOfReactorEvents ;           //!< Input events delivered by a SerialReactor.
+        unsigned long long numOfFillContentions ;         //!< Times a thread found the input buffer being filled by another thread and handed its work over.
+        unsigned long long numOfReaderWakeups ;           //!< Times a reader waiting for data was woken up.
+        unsigned long long numOfReadTimeouts ;            //!< Reads that ended because their timeout expired.
+        unsigned long long numOfWriteTimeouts ;           //!< Writes that ended because their timeout expired.
+        unsigned long long numOfDroppedInputBytes ;       //!< See GetNumOfDroppedInputBytes().
+        unsigned long long numOfInputBackpressureEvents ; //!< See GetNumOfInputBackpressureEvents().
+        size_t             inputBufferHighWaterMark ;     //!< See GetInputBufferHighWaterMark().
+    } ;
+
     /**
      * @brief Default Constructor for a serial port object.
      */
@@ -206,6 +329,23 @@ public:
                UnsupportedBaudRate,
                std::invalid_argument ) ;
 
+    /**
+     * @brief Opens the serial port and applies the specified settings to
+     *        it with a single call to tcsetattr().
+     * @throw AlreadyOpen This exception is thrown if the serial port
+     *        is already open.
+     * @throw OpenFailed This exception is thrown if the serial port
+     *        could not be opened.
+     * @throw std::invalid_argument This exception is thrown if an
+     *        invalid parameter value is specified.
+     */
+    void
+    Open( const PortSettings& portSettings )
+        throw( AlreadyOpen,
+               OpenFailed,
+               UnsupportedBaudRate,
+               std::invalid_argument ) ;
+
     /**
      * @brief Determines if the serial port is open for I/O.
      * @return Returns true iff the serial port is open.
@@ -213,6 +353,180 @@ public:
     bool
     IsOpen() const ;
 
+    /**
+     * @brief Selects the signal that notifies the serial port about
+     *        arriving data. The default is SIGIO, which is shared by all
+     *        serial ports, so every open port is checked whenever any of
+     *        them receives data. With a real-time signal (SIGRTMIN to
+     *        SIGRTMAX) the signal identifies the serial port that
+     *        received the data and only that port is read. Real-time
+     *        signals are also queued instead of being merged. Several
+     *        ports can use the same real-time signal.
+     * @param signalNumber SIGIO or a real-time signal.
+     * @throw AlreadyOpen This exception is thrown if the serial port is
+     *        open. The signal must be selected before calling Open().
+     * @throw std::invalid_argument This exception is thrown if
+     *        signalNumber is neither SIGIO nor a real-time signal.
+     */
+    void
+    SetInputSignal( const int signalNumber )
+        throw( AlreadyOpen,
+               std::invalid_argument ) ;
+
+    /**
+     * @brief Returns the signal that notifies the serial port about
+     *        arriving data.
+     */
+    int
+    GetInputSignal() const ;
+
+    /**
+     * @brief Sets the number of bytes the input buffer of the serial
+     *        port can hold. The buffer is allocated once, so its size
+     *        bounds the memory used for received data. The capacity is
+     *        rounded up to the next power of two. The default is 64 KiB.
+     * @throw AlreadyOpen This exception is thrown if the serial port is
+     *        open. The capacity must be set before calling Open().
+     * @throw std::invalid_argument This exception is thrown if capacity
+     *        is zero or too large, or if the buffer cannot be allocated.
+     *        The previous capacity is kept in that case.
+     */
+    void
+    SetInputBufferCapacity( const size_t capacity )
+        throw( AlreadyOpen,
+               std::invalid_argument ) ;
+
+    /**
+     * @brief Returns the number of bytes the input buffer can hold.
+     */
+    size_t
+    GetInputBufferCapacity() const ;
+
+    /**
+     * @brief Selects what happens to arriving data while the input
+     *        buffer is full. With INPUT_OVERFLOW_BACKPRESSURE, the default,
+     *        no data is lost in the input buffer; the kernel's tty buffer
+     *        fills up instead and hardware or software flow control, if
+     *        enabled, stops the sender. The drop policies keep draining
+     *        the tty and discard data, which keeps the latency of the
+     *        data that is kept low. The policy may be changed at any
+     *        time.
+     */
+    void
+    SetInputOverflowPolicy( const InputOverflowPolicy overflowPolicy ) ;
+
+    /**
+     * @brief Returns the current input overflow policy.
+     */
+    InputOverflowPolicy
+    GetInputOverflowPolicy() const ;
+
+    /**
+     * @brief Returns the number of received bytes that were discarded
+     *        because the input buffer was full, since the serial port
+     *        was opened or ResetInputBufferCounters() was called.
+     */
+    unsigned long long
+    GetNumOfDroppedInputBytes() const ;
+
+    /**
+     * @brief Returns the number of times data had to be left in the
+     *        kernel's tty buffer because the input buffer was full, since
+     *        the serial port was opened or ResetInputBufferCounters()
+     *        was called. Only counted with INPUT_OVERFLOW_BACKPRESSURE.
+     */
+    unsigned long long
+    GetNumOfInputBackpressureEvents() const ;
+
+    /**
+     * @brief Returns the largest number of bytes that has been stored in
+     *        the input buffer since the serial port was opened or
+     *        ResetInputBufferCounters() was called.
+     */
+    size_t
+    GetInputBufferHighWaterMark() const ;
+
+    /**
+     * @brief Resets the counters of the input buffer to zero.
+     */
+    void
+    ResetInputBufferCounters() ;
+
+    /**
+     * @brief Returns a snapshot of the counters of the serial port. The
+     *        counters are updated without locking, so the values are
+     *        not necessarily consistent with each other while the port
+     *        is in use.
+     */
+    Statistics
+    GetStatistics() const ;
+
+    /**
+     * @brief Resets all counters of the serial port, including those of
+     *        the input buffer, to zero. The counters are also reset by
+     *        Open().
+     */
+    void
+    ResetStatistics() ;
+
+    /**
+     * @brief Starts measuring the input latency of the serial port, i.e.
+     *        the time from reading a chunk of data from the serial port
+     *        into the input buffer until the last byte of the chunk is
+     *        returned by ReadByte(), Read() or ReadLine(). The latencies
+     *        are collected in a log-linear histogram with a relative
+     *        error of at most 6.25%. The measurement uses the arrival
+     *        times reported by ReadWithTimestamps() and costs one more
+     *        clock_gettime() call per chunk.
+     *
+     *        The measurement may be started at any time and stays
+     *        enabled when the serial port is closed and opened again.
+     *        The histogram is cleared by Open().
+     *
+     * @note Chunks that are discarded with INPUT_OVERFLOW_DROP_OLDEST
+     *       are counted as if they had been read.
+     */
+    void
+    EnableInputLatencyHistogram() ;
+
+    /**
+     * @brief Stops measuring the input latency. The histogram keeps the
+     *        latencies measured so far.
+     */
+    void
+    DisableInputLatencyHistogram() ;
+
+    /**
+     * @brief Returns true if the input latency is being measured.
+     */
+    bool
+    IsInputLatencyHistogramEnabled() const ;
+
+    /**
+     * @brief Returns the number of latencies in the input latency
+     *        histogram.
+     */
+    unsigned long long
+    GetNumOfInputLatencySamples() const ;
+
+    /**
+     * @brief Returns a percentile of the input latency in nanoseconds.
+     *        The histogram is read without locking, so this method does
+     *        not wait for readers of the serial port.
+     * @param percentile The percentile, e.g. 50.0, 99.0 or 99.9.
+     * @return The smallest latency that is not exceeded by the specified
+     *         percentage of the measured latencies, or zero if no latency
+     *         has been measured.
+     */
+    long long
+    GetInputLatencyPercentile( const double percentile ) const ;
+
+    /**
+     * @brief Removes all latencies from the input latency histogram.
+     */
+    void
+    ResetInputLatencyHistogram() ;
+
     /**
      * @brief Closes the serial port. All settings of the serial port will be
      *        lost and no more I/O can be performed on the serial port.
@@ -339,6 +653,58 @@ public:
     GetFlowControl() const
         throw( NotOpen ) ;
 
+    /**
+     * @brief Applies all of the specified settings to the serial port
+     *        with a single call to tcsetattr().
+     * @param portSettings The new settings of the serial port.
+     * @param drain If true, the settings are applied only after all data
+     *        written to the serial port has been transmitted (TCSADRAIN).
+     *        Otherwise they are applied immediately (TCSANOW).
+     * @throw NotOpen This exception is thrown if the method is called while
+     *        the serial port is not open.
+     * @throw UnsupportedBaudRate This exception is thrown if the specified
+     *        baud rate is not supported.
+     * @throw std::invalid_argument This exception is thrown if an invalid
+     *        parameter value is specified.
+     * @throw std::runtime_error This exception is thrown if any standard
+     *        runtime error is encountered.
+     */
+    void
+    SetPortSettings( const PortSettings& portSettings,
+                     const bool          drain = false )
+        throw( NotOpen,
+               UnsupportedBaudRate,
+               std::invalid_argument,
+               std::runtime_error ) ;
+
+    /**
+     * @brief Gets all current settings of the serial port.
+     * @throw NotOpen This exception is thrown if the method is called while
+     *        the serial port is not open.
+     * @throw std::runtime_error This exception is thrown if any standard
+     *        runtime error is encountered.
+     */
+    PortSettings
+    GetPortSettings() const
+        throw( NotOpen,
+               std::runtime_error ) ;
+
+    /**
+     * @brief Reads the settings of the serial port from the driver.
+     *        The Get*() methods return a copy of the settings that is
+     *        updated by the Set*() methods. This method only needs to
+     *        be called if the settings were changed by other means,
+     *        e.g. by another process.
+     * @throw NotOpen This exception is thrown if the method is called while
+     *        the serial port is not open.
+     * @throw std::runtime_error This exception is thrown if any standard
+     *        runtime error is encountered.
+     */
+    void
+    RefreshPortSettings()
+        throw( NotOpen,
+               std::runtime_error ) ;
+
     /**
      * @brief Checks if data is available at the input of the serial port.
      * @throw NotOpen This exception is thrown if the method is called while
@@ -379,8 +745,10 @@ public:
     
     /**
      * @brief Reads the specified number of bytes from the serial port.
-     *        The method will timeout if no data is received in the specified
-     *        number of milliseconds (msTimeout). If msTimeout is 0, then
+     *        The method will timeout if all requested bytes have not been
+     *        received within the specified number of milliseconds
+     *        (msTimeout). The timeout applies to the whole request and not
+     *        to individual bytes. If msTimeout is 0, then
      *        this method will block until all requested bytes are
      *        received. If numOfBytes is zero, then this method will keep
      *        reading data till no more data is available at the serial port.
@@ -404,11 +772,203 @@ public:
                ReadTimeout,
                std::runtime_error ) ;
 
+    /**
+     * @brief Reads up to numOfBytes bytes from the serial port into the
+     *        memory pointed to by dataBuffer. The method returns when
+     *        numOfBytes bytes have been read or when msTimeout
+     *        milliseconds have elapsed, whichever happens first. If
+     *        msTimeout is 0, then this method will block until all
+     *        requested bytes are received. No memory is allocated and the
+     *        data is copied directly from the input buffer of the port.
+     * @param dataBuffer The memory to place serial data into. It must be
+     *        large enough to hold numOfBytes bytes.
+     * @param numOfBytes The maximum number of bytes to read.
+     * @param msTimeout The timeout period in milliseconds.
+     * @throw NotOpen This exception is thrown if this method is called while
+     *        the serial port is not open.
+     * @throw std::runtime_error This exception is thrown if any standard
+     *        runtime error is encountered.
+     * @return Returns the number of bytes read. This is less than
+     *         numOfBytes iff the timeout was reached.
+     */
+    size_t
+    Read( unsigned char*     dataBuffer,
+          const size_t       numOfBytes,
+          const unsigned int msTimeout = 0 )
+        throw( NotOpen,
+               std::runtime_error ) ;
+
+    /**
+     * @brief The arrival time of a run of bytes returned by
+     *        ReadWithTimestamps().
+     */
+    struct ArrivalTime
+    {
+        size_t    offset ;    //!< Index of the first byte of the run in the data buffer.
+        long long timestamp ; //!< CLOCK_MONOTONIC time in nanoseconds at which the run was read from the serial port.
+    } ;
+
+    /**
+     * @brief A list of arrival times ordered by offset. Each entry applies
+     *        to the bytes up to the offset of the next entry or the end of
+     *        the data.
+     */
+    typedef std::vector<ArrivalTime> ArrivalTimes ;
+
+    /**
+     * @brief Reads data from the serial port like Read( dataBuffer,
+     *        numOfBytes, msTimeout ) and also returns the time at which
+     *        the data arrived. The serial port notes the time whenever it
+     *        moves a chunk of data into its input buffer, so the
+     *        timestamps do not depend on when the data is read.
+     *        Consecutive bytes with the same timestamp are described by a
+     *        single entry of arrivalTimes.
+     *
+     *        The arrival time of the last 4096 chunks waiting in the
+     *        input buffer is kept. If more chunks are waiting, the
+     *        remaining ones are given the arrival time of the next chunk
+     *        that was noted or, failing that, the time of the read. A
+     *        reported arrival time is therefore never earlier than the
+     *        actual one.
+     *
+     * @param dataBuffer The data buffer to place serial data into.
+     * @param arrivalTimes Receives the arrival times of the data.
+     * @param numOfBytes The number of bytes to read before returning.
+     * @param msTimeout The timeout period in milliseconds.
+     * @throw NotOpen This exception is thrown if this method is called while
+     *        the serial port is not open.
+     * @throw ReadTimeout This exception is thrown if the timeout value is
+     *        reached before numOfBytes bytes are received. The data read so
+     *        far and its arrival times are still returned.
+     * @throw std::runtime_error This exception is thrown if any standard
+     *        runtime error is encountered.
+     */
+    void
+    ReadWithTimestamps( DataBuffer&        dataBuffer,
+                        ArrivalTimes&      arrivalTimes,
+                        const unsigned int numOfBytes = 0,
+                        const unsigned int msTimeout  = 0 )
+        throw( NotOpen,
+               ReadTimeout,
+               std::runtime_error ) ;
+
+    /**
+     * @brief Copies received data to dataBuffer without removing it from
+     *        the input buffer of the serial port, so that it is returned
+     *        again by the next read. The method waits until numOfBytes
+     *        bytes are buffered and copies the first numOfBytes of them.
+     *        If numOfBytes is zero, then all data currently buffered is
+     *        copied without waiting.
+     * @param dataBuffer The data buffer to place the data into.
+     * @param numOfBytes The number of bytes to look at. It must not
+     *        exceed GetInputBufferCapacity().
+     * @param msTimeout The timeout period in milliseconds. If msTimeout
+     *        is 0, then this method will block until numOfBytes bytes are
+     *        received.
+     * @throw NotOpen This exception is thrown if this method is called while
+     *        the serial port is not open.
+     * @throw ReadTimeout This exception is thrown if fewer than numOfBytes
+     *        bytes are buffered when the timeout is reached. dataBuffer
+     *        then contains the data buffered so far.
+     * @throw std::invalid_argument This exception is thrown if numOfBytes
+     *        exceeds the capacity of the input buffer.
+     * @throw std::runtime_error This exception is thrown if any standard
+     *        runtime error is encountered.
+     */
+    void
+    Peek( DataBuffer&        dataBuffer,
+          const unsigned int numOfBytes = 0,
+          const unsigned int msTimeout  = 0 )
+        throw( NotOpen,
+               ReadTimeout,
+               std::invalid_argument,
+               std::runtime_error ) ;
+
+    /**
+     * @brief A contiguous region of received data returned by
+     *        AcquireReadable().
+     */
+    struct ReadableRegion
+    {
+        const unsigned char* data ; //!< First byte of the region.
+        size_t               size ; //!< Number of bytes in the region.
+    } ;
+
+    /**
+     * @brief Gives direct access to the data in the input buffer of the
+     *        serial port so that it can be parsed without copying it. The
+     *        method waits until at least minNumOfBytes bytes are buffered
+     *        and then describes all buffered data, oldest byte first, as
+     *        up to two regions. The second region is only used when the
+     *        data wraps around the end of the input buffer; otherwise its
+     *        size is zero.
+     *
+     *        The data stays valid and in the input buffer until
+     *        CommitReadable() is called, which must be done by the same
+     *        thread. Until then the calling thread is the only reader of
+     *        the serial port: reads by other threads block and the
+     *        calling thread must not use any other read method. Data
+     *        keeps arriving in the free part of the input buffer in the
+     *        meantime. INPUT_OVERFLOW_DROP_OLDEST behaves like
+     *        INPUT_OVERFLOW_BACKPRESSURE while the data is held, so that
+     *        it is never overwritten.
+     *
+     * @param regions Receives the regions of buffered data.
+     * @param minNumOfBytes The minimum number of bytes to wait for. It
+     *        must not exceed GetInputBufferCapacity().
+     * @param msTimeout The timeout period in milliseconds. If msTimeout
+     *        is 0, then this method will block until enough data is
+     *        received.
+     * @throw NotOpen This exception is thrown if this method is called while
+     *        the serial port is not open.
+     * @throw ReadTimeout This exception is thrown if fewer than
+     *        minNumOfBytes bytes are buffered when the timeout is
+     *        reached. No data is held in that case.
+     * @throw std::invalid_argument This exception is thrown if
+     *        minNumOfBytes exceeds the capacity of the input buffer.
+     * @throw std::logic_error This exception is thrown if the calling
+     *        thread still holds data returned by an earlier call.
+     * @throw std::runtime_error This exception is thrown if any standard
+     *        runtime error is encountered.
+     * @return Returns the total number of bytes in both regions.
+     */
+    size_t
+    AcquireReadable( ReadableRegion     regions[2],
+                     const size_t       minNumOfBytes = 1,
+                     const unsigned int msTimeout     = 0 )
+        throw( NotOpen,
+               ReadTimeout,
+               std::invalid_argument,
+               std::logic_error,
+               std::runtime_error ) ;
+
+    /**
+     * @brief Removes the first numOfBytes bytes of the data returned by
+     *        AcquireReadable() from the input buffer and ends the direct
+     *        access. The rest of the data stays in the input buffer for
+     *        the next read. The regions returned by AcquireReadable() must
+     *        not be used afterwards.
+     * @param numOfBytes The number of bytes consumed. Zero leaves all of
+     *        the data in the input buffer.
+     * @throw std::invalid_argument This exception is thrown if numOfBytes
+     *        exceeds the number of bytes returned by AcquireReadable(). The
+     *        data is still held in that case.
+     * @throw std::logic_error This exception is thrown if the calling
+     *        thread holds no data returned by AcquireReadable(). A parser
+     *        that fails while it holds the data must still call this
+     *        method, e.g. with zero, before the serial port can be read
+     *        again.
+     */
+    void
+    CommitReadable( const size_t numOfBytes )
+        throw( std::logic_error ) ;
+
     /**
      * @brief Reads a line of characters from the serial port.
-     *        The method will timeout if no data is received in the specified
-     *        number of milliseconds (msTimeout). If msTimeout is 0, then
-     *        this method will block until a line terminator is received.
+     *        The method will timeout if a complete line has not been
+     *        received in the specified number of milliseconds (msTimeout).
+     *        If msTimeout is 0, then this method will block until a line
+     *        terminator is received.
      *        If a line terminator is read, a string will be returned,
      *        however, if the timeout is reached, an exception will be thrown
      *        and all previously read data will be lost.
@@ -416,6 +976,11 @@ public:
      *        character is not read.
      * @param lineTerminator The line termination character to specify the
      *        end of a line.
+     * @param maxLength The maximum number of characters to read. If no
+     *        line terminator is found within the first maxLength
+     *        characters, those characters are returned without a line
+     *        terminator and the rest of the line is left for the next
+     *        read. A value of 0 places no limit on the length of a line.
      * @throw NotOpen This exception is thrown if this method is called while
      *        the serial port is not open.
      * @throw ReadTimeout This exception is thrown if the timeout value is
@@ -425,13 +990,30 @@ public:
      * @return Returns the line read from the serial port ending with the line
      *         termination character iff sucessful.
      */
-    const std::string
+    std::string
     ReadLine( const unsigned int msTimeout = 0,
-              const char         lineTerminator = '\n' )
+              const char         lineTerminator = '\n',
+              const size_t       maxLength = 0 )
         throw( NotOpen,
                ReadTimeout,
                std::runtime_error ) ;
 
+    /**
+     * @brief Reads a line of characters ending with a multi-character
+     *        line terminator such as "\r\n" from the serial port. This
+     *        method behaves like ReadLine() above otherwise.
+     * @throw std::invalid_argument This exception is thrown if
+     *        lineTerminator is empty.
+     */
+    std::string
+    ReadLine( const unsigned int msTimeout,
+              const std::string& lineTerminator,
+              const size_t       maxLength = 0 )
+        throw( NotOpen,
+               ReadTimeout,
+               std::invalid_argument,
+               std::runtime_error ) ;
+
     /**
      * @brief Writes a single byte to the serial port.
      * @param dataByte The byte to be written to the serial port.
@@ -446,30 +1028,139 @@ public:
                std::runtime_error ) ;
 
     /**
-     * @brief Writes a DataBuffer vector to the serial port.
+     * @brief Writes a DataBuffer vector to the serial port. The method
+     *        returns once all data has been passed to the operating
+     *        system, waiting for room in the output buffer of the port
+     *        when necessary. If not all data could be written within
+     *        msTimeout milliseconds, then a WriteTimeout exception is
+     *        thrown. If msTimeout is 0, then this method will block until
+     *        all data is written.
      * @param dataBuffer The DataBuffer vector to be written to the serial
      *        port.
+     * @param msTimeout The timeout period in milliseconds.
      * @throw NotOpen This exception is thrown if this method is called while
      *        the serial port is not open.
+     * @throw WriteTimeout This exception is thrown if the timeout value is
+     *        reached before all data is written.
      * @throw std::runtime_error This exception is thrown if any standard
      *        runtime error is encountered.
      */
     void
-    Write(const DataBuffer& dataBuffer)
+    Write( const DataBuffer&  dataBuffer,
+           const unsigned int msTimeout = 0 )
         throw( NotOpen,
+               WriteTimeout,
                std::runtime_error ) ;
 
     /**
-     * @brief Writes a std::string to the serial port.
+     * @brief Writes a std::string to the serial port. See
+     *        Write(const DataBuffer&, const unsigned int) for details.
      * @param dataString The data string to be written to the serial port.
+     * @param msTimeout The timeout period in milliseconds.
      * @throw NotOpen This exception is thrown if this method is called while the serial port is not open.
+     * @throw WriteTimeout This exception is thrown if the timeout value is reached before all data is written.
      * @throw std::runtime_error This exception is thrown if any standard runtime error is encountered.
      */
     void
-    Write(const std::string& dataString)
+    Write( const std::string& dataString,
+           const unsigned int msTimeout = 0 )
         throw( NotOpen,
+               WriteTimeout,
                std::runtime_error ) ;
 
+    /**
+     * @brief Writes numOfBytes bytes from the memory pointed to by
+     *        dataBuffer to the serial port. The data is passed to the
+     *        operating system without being copied first. The method
+     *        returns when all data has been written or when msTimeout
+     *        milliseconds have elapsed, whichever happens first. If
+     *        msTimeout is 0, then this method will block until all data
+     *        is written.
+     * @param dataBuffer The data to be written to the serial port.
+     * @param numOfBytes The number of bytes to be written.
+     * @param msTimeout The timeout period in milliseconds.
+     * @throw NotOpen This exception is thrown if this method is called while
+     *        the serial port is not open.
+     * @throw std::runtime_error This exception is thrown if any standard
+     *        runtime error is encountered.
+     * @return Returns the number of bytes written. This is less than
+     *         numOfBytes iff the timeout was reached.
+     */
+    size_t
+    Write( const void*        dataBuffer,
+           const size_t       numOfBytes,
+           const unsigned int msTimeout = 0 )
+        throw( NotOpen,
+               std::runtime_error ) ;
+
+    /**
+     * @brief Enables asynchronous writes with WriteAsync(). All memory
+     *        used for queued data is allocated by this method and a
+     *        writer thread is started that passes the queued data to the
+     *        serial port in the order in which it was queued. Data written
+     *        with the other write methods is never interleaved with the
+     *        data of a single asynchronous write.
+     * @param completionHandler The handler that is notified when each
+     *        asynchronous write has completed or 0 if no notifications
+     *        are needed.
+     * @param bufferSize The number of bytes that can be queued.
+     * @param maxNumOfRequests The number of writes that can be queued.
+     * @throw NotOpen This exception is thrown if this method is called while
+     *        the serial port is not open.
+     * @throw std::logic_error This exception is thrown if asynchronous
+     *        writes are already enabled. An std::invalid_argument is
+     *        thrown if bufferSize is zero or too large.
+     * @throw std::runtime_error This exception is thrown if the queue
+     *        cannot be allocated or any other standard runtime error is
+     *        encountered.
+     */
+    void
+    EnableAsyncWrite( WriteCompletionHandler* completionHandler = 0,
+                      const size_t            bufferSize        = 64 * 1024,
+                      const size_t            maxNumOfRequests  = 256 )
+        throw( NotOpen,
+               std::logic_error,
+               std::runtime_error ) ;
+
+    /**
+     * @brief Waits until all queued asynchronous writes have completed,
+     *        stops the writer thread and frees the queue. Closing the
+     *        serial port also disables asynchronous writes but discards
+     *        the queued data instead of waiting for it to be written.
+     */
+    void
+    DisableAsyncWrite() ;
+
+    /**
+     * @brief Queues numOfBytes bytes from the memory pointed to by
+     *        dataBuffer for writing by the writer thread and returns
+     *        immediately. The data is copied, so the memory can be reused
+     *        as soon as this method returns.
+     * @param dataBuffer The data to be written to the serial port.
+     * @param numOfBytes The number of bytes to be written.
+     * @throw NotOpen This exception is thrown if this method is called while
+     *        the serial port is not open.
+     * @throw std::logic_error This exception is thrown if asynchronous
+     *        writes have not been enabled with EnableAsyncWrite().
+     * @return Returns a non-zero ticket that identifies the write in the
+     *         call to the completion handler, or 0 if the queue does not
+     *         have enough room for the data.
+     */
+    unsigned long
+    WriteAsync( const void*  dataBuffer,
+                const size_t numOfBytes )
+        throw( NotOpen,
+               std::logic_error ) ;
+
+    /**
+     * @brief Waits until all queued asynchronous writes have completed or
+     *        msTimeout milliseconds have elapsed. If msTimeout is 0, then
+     *        this method will wait until the queue is empty.
+     * @return Returns true iff no asynchronous writes are pending.
+     */
+    bool
+    WaitForAsyncWrites( const unsigned int msTimeout = 0 ) ;
+
     /**
      * @brief Sets the DTR line to the specified value.
      * @param dtrState The line voltage state to be set,
@@ -558,6 +1249,31 @@ private:
      */
     SerialPort& operator=(const SerialPort& otherSerialPort ) ;
 
+    /**
+     * @brief SerialReactor::Attach() and SerialReactor::Detach() use
+     *        AttachReactor() and DetachReactor().
+     */
+    friend class SerialReactor ;
+
+    /**
+     * @brief Stops using SIGIO and lets the specified reactor move the
+     *        incoming data into the input buffer.
+     */
+    void
+    AttachReactor( SerialReactor& serialReactor )
+        throw( NotOpen,
+               std::logic_error,
+               std::runtime_error ) ;
+
+    /**
+     * @brief Detaches the serial port from the specified reactor and
+     *        uses SIGIO again.
+     */
+    void
+    DetachReactor( SerialReactor& serialReactor )
+        throw( std::logic_error,
+               std::runtime_error ) ;
+
     /**
      * @brief Forward declaration of the implementation class folowing
      *        the PImpl idiom.
@@ -570,5 +1286,11 @@ private:
     SerialPortImpl* mSerialPortImpl ;
 } ;
 
+inline
+SerialPort::WriteCompletionHandler::~WriteCompletionHandler()
+{
+    /* empty */
+}
+
 #endif // #ifndef _SerialPort_h_
 
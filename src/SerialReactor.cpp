@@ -0,0 +1,541 @@
+/******************************************************************************
+ *   @file SerialReactor.cpp                                                  *
+ *                                                                            *
+ *   This program is free software; you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published by     *
+ *   the Free Software Foundation; either version 2 of the License, or        *
+ *   (at your option) any later version.                                      *
+ *                                                                            *
+ *   This program is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *   GNU General Public License for more details.                             *
+ *                                                                            *
+ *   You should have received a copy of the GNU General Public License        *
+ *   along with this program; if not, write to the                            *
+ *   Free Software Foundation, Inc.,                                          *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.                *
+ *****************************************************************************/
+
+#include "SerialReactor.h"
+#include "SerialReactorHandler.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace
+{
+    /*
+     * Maximum number of events returned by a single call to
+     * epoll_wait().
+     */
+    const int MAX_NUM_OF_EVENTS = 64 ;
+
+    /*
+     * Value of epoll_event::data used for the pipe that stops the I/O
+     * threads. Handler identifiers start at one.
+     */
+    const unsigned long long STOP_PIPE_ID = 0 ;
+}
+
+class SerialReactor::SerialReactorImpl
+{
+public:
+    /**
+     * Constructor.
+     */
+    explicit SerialReactorImpl( const unsigned numOfThreads )
+        throw( std::runtime_error ) ;
+
+    /**
+     * Destructor.
+     */
+    ~SerialReactorImpl() ;
+
+    /**
+     * Stop and join all I/O threads.
+     */
+    void
+    Stop() ;
+
+    void
+    RegisterHandler( const int             fileDescriptor,
+                     SerialReactorHandler& handler )
+        throw( std::runtime_error ) ;
+
+    bool
+    UnregisterHandler( const SerialReactorHandler& handler ) ;
+
+    /**
+     * Return the handlers that are currently registered.
+     */
+    std::vector<SerialReactorHandler*>
+    GetHandlers() const ;
+
+    unsigned
+    GetNumOfThreads() const ;
+
+    size_t
+    GetNumOfHandlers() const ;
+
+private:
+    /**
+     * A handler registered with the reactor.
+     */
+    struct HandlerEntry
+    {
+        SerialReactorHandler* mHandler ;
+        int                   mFileDescriptor ;
+        /**
+         * Number of I/O threads currently calling mHandler.
+         */
+        unsigned              mNumOfActiveCalls ;
+        /**
+         * Set by UnregisterHandler(). No new calls are started once this
+         * is true.
+         */
+        bool                  mIsRemoved ;
+    } ;
+
+    /**
+     * Handlers are identified by a number that is never reused, so an
+     * event returned by epoll_wait() for a handler that has been
+     * unregistered in the meantime is recognized and ignored.
+     */
+    typedef std::map<unsigned long long, HandlerEntry> HandlerList ;
+
+    /**
+     * Entry point of the I/O threads. serialReactorImpl points to the
+     * SerialReactorImpl instance that started the thread.
+     */
+    static void*
+    IoThread( void* serialReactorImpl ) ;
+
+    /**
+     * Wait for events and dispatch them until the reactor is stopped.
+     */
+    void
+    IoLoop() ;
+
+    /**
+     * Call the handler with the specified identifier unless it has been
+     * unregistered.
+     */
+    void
+    DispatchInputReady( const unsigned long long handlerId ) ;
+
+    /**
+     * The epoll instance watching all registered file descriptors.
+     */
+    int mEpollFileDescriptor ;
+
+    /**
+     * A byte written to this pipe stops all I/O threads. The byte is
+     * never read, so the read end stays readable for every thread.
+     */
+    int mStopPipe[2] ;
+
+    /**
+     * The I/O threads.
+     */
+    std::vector<pthread_t> mIoThreads ;
+
+    /**
+     * True once Stop() has been called.
+     */
+    std::atomic<bool> mIsStopping ;
+
+    /**
+     * Registered handlers. Protected by mHandlerMutex.
+     */
+    HandlerList mHandlers ;
+
+    /**
+     * Identifier of the next handler to be registered.
+     */
+    unsigned long long mNextHandlerId ;
+
+    /*
+     * Mutex protecting mHandlers. It is never held while a handler is
+     * called.
+     */
+    mutable pthread_mutex_t mHandlerMutex ;
+
+    /*
+     * Signaled when the last active call of a removed handler has
+     * returned.
+     */
+    pthread_cond_t mHandlerIdleCondition ;
+} ;
+
+SerialReactor::SerialReactor( const unsigned numOfThreads )
+    throw( std::runtime_error ) :
+    mSerialReactorImpl( new SerialReactorImpl( numOfThreads ) )
+{
+    /* empty */
+}
+
+SerialReactor::~SerialReactor()
+{
+    //
+    // Stop the I/O threads first so that the handlers can unregister
+    // themselves without racing with them.
+    //
+    mSerialReactorImpl->Stop() ;
+    const std::vector<SerialReactorHandler*> handlers =
+        mSerialReactorImpl->GetHandlers() ;
+    for( std::vector<SerialReactorHandler*>::const_iterator i = handlers.begin() ;
+         i != handlers.end() ;
+         ++i )
+    {
+        (*i)->HandleReactorShutdown() ;
+    }
+    delete mSerialReactorImpl ;
+}
+
+void
+SerialReactor::Attach( SerialPort& serialPort )
+    throw( SerialPort::NotOpen,
+           std::logic_error,
+           std::runtime_error )
+{
+    serialPort.AttachReactor( *this ) ;
+    return ;
+}
+
+void
+SerialReactor::Detach( SerialPort& serialPort )
+    throw( std::logic_error,
+           std::runtime_error )
+{
+    serialPort.DetachReactor( *this ) ;
+    return ;
+}
+
+unsigned
+SerialReactor::GetNumOfThreads() const
+{
+    return mSerialReactorImpl->GetNumOfThreads() ;
+}
+
+size_t
+SerialReactor::GetNumOfAttachedPorts() const
+{
+    return mSerialReactorImpl->GetNumOfHandlers() ;
+}
+
+void
+SerialReactor::RegisterHandler( const int             fileDescriptor,
+                                SerialReactorHandler& handler )
+    throw( std::runtime_error )
+{
+    mSerialReactorImpl->RegisterHandler( fileDescriptor,
+                                         handler ) ;
+    return ;
+}
+
+bool
+SerialReactor::UnregisterHandler( const SerialReactorHandler& handler )
+{
+    return mSerialReactorImpl->UnregisterHandler( handler ) ;
+}
+
+/* ------------------------------------------------------------ */
+inline
+SerialReactor::SerialReactorImpl::SerialReactorImpl( const unsigned numOfThreads )
+    throw( std::runtime_error ) :
+    mEpollFileDescriptor(-1),
+    mStopPipe(),
+    mIoThreads(),
+    mIsStopping(false),
+    mHandlers(),
+    mNextHandlerId(STOP_PIPE_ID + 1),
+    mHandlerMutex(),
+    mHandlerIdleCondition()
+{
+    mStopPipe[0] = -1 ;
+    mStopPipe[1] = -1 ;
+    if ( ( pthread_mutex_init( &mHandlerMutex, NULL ) != 0 ) ||
+         ( pthread_cond_init( &mHandlerIdleCondition, NULL ) != 0 ) )
+    {
+        throw std::runtime_error( "Could not initialize the reactor mutex." ) ;
+    }
+    //
+    // Create the epoll instance and add the read end of the stop pipe
+    // to it.
+    //
+    mEpollFileDescriptor = epoll_create1( EPOLL_CLOEXEC ) ;
+    if ( mEpollFileDescriptor < 0 )
+    {
+        throw std::runtime_error( strerror(errno) ) ;
+    }
+    if ( pipe( mStopPipe ) < 0 )
+    {
+        const int error_number = errno ;
+        close( mEpollFileDescriptor ) ;
+        throw std::runtime_error( strerror(error_number) ) ;
+    }
+    struct epoll_event stop_event ;
+    std::memset( &stop_event, 0, sizeof(stop_event) ) ;
+    stop_event.events   = EPOLLIN ;
+    stop_event.data.u64 = STOP_PIPE_ID ;
+    if ( epoll_ctl( mEpollFileDescriptor,
+                    EPOLL_CTL_ADD,
+                    mStopPipe[0],
+                    &stop_event ) < 0 )
+    {
+        const int error_number = errno ;
+        close( mStopPipe[0] ) ;
+        close( mStopPipe[1] ) ;
+        close( mEpollFileDescriptor ) ;
+        throw std::runtime_error( strerror(error_number) ) ;
+    }
+    //
+    // Start the I/O threads.
+    //
+    const unsigned num_of_threads = ( numOfThreads > 0 ? numOfThreads : 1 ) ;
+    for( unsigned i=0; i<num_of_threads; ++i )
+    {
+        pthread_t io_thread ;
+        const int error_number = pthread_create( &io_thread,
+                                                 NULL,
+                                                 &SerialReactorImpl::IoThread,
+                                                 this ) ;
+        if ( 0 != error_number )
+        {
+            this->Stop() ;
+            close( mStopPipe[0] ) ;
+            close( mStopPipe[1] ) ;
+            close( mEpollFileDescriptor ) ;
+            throw std::runtime_error( strerror(error_number) ) ;
+        }
+        mIoThreads.push_back( io_thread ) ;
+    }
+}
+
+inline
+SerialReactor::SerialReactorImpl::~SerialReactorImpl()
+{
+    this->Stop() ;
+    close( mStopPipe[0] ) ;
+    close( mStopPipe[1] ) ;
+    close( mEpollFileDescriptor ) ;
+    pthread_cond_destroy( &mHandlerIdleCondition ) ;
+    pthread_mutex_destroy( &mHandlerMutex ) ;
+}
+
+inline
+void
+SerialReactor::SerialReactorImpl::Stop()
+{
+    if ( mIsStopping.exchange( true ) )
+    {
+        return ;
+    }
+    const char stop_byte = 0 ;
+    if ( write( mStopPipe[1],
+                &stop_byte,
+                1 ) < 0 )
+    {
+        /*
+         * The threads also check mIsStopping after every wakeup.
+         */
+    }
+    for( std::vector<pthread_t>::const_iterator i = mIoThreads.begin() ;
+         i != mIoThreads.end() ;
+         ++i )
+    {
+        pthread_join( *i, NULL ) ;
+    }
+    mIoThreads.clear() ;
+    return ;
+}
+
+inline
+void
+SerialReactor::SerialReactorImpl::RegisterHandler( const int             fileDescriptor,
+                                                   SerialReactorHandler& handler )
+    throw( std::runtime_error )
+{
+    pthread_mutex_lock( &mHandlerMutex ) ;
+    const unsigned long long handler_id = mNextHandlerId++ ;
+    HandlerEntry& handler_entry = mHandlers[ handler_id ] ;
+    handler_entry.mHandler          = &handler ;
+    handler_entry.mFileDescriptor   = fileDescriptor ;
+    handler_entry.mNumOfActiveCalls = 0 ;
+    handler_entry.mIsRemoved        = false ;
+    //
+    // Watch the file descriptor in edge-triggered mode. An event is
+    // reported whenever new data arrives, just like SIGIO. Data that
+    // is already waiting is reported once right after the file
+    // descriptor has been added.
+    //
+    struct epoll_event input_event ;
+    std::memset( &input_event, 0, sizeof(input_event) ) ;
+    input_event.events   = EPOLLIN | EPOLLET ;
+    input_event.data.u64 = handler_id ;
+    if ( epoll_ctl( mEpollFileDescriptor,
+                    EPOLL_CTL_ADD,
+                    fileDescriptor,
+                    &input_event ) < 0 )
+    {
+        const int error_number = errno ;
+        mHandlers.erase( handler_id ) ;
+        pthread_mutex_unlock( &mHandlerMutex ) ;
+        throw std::runtime_error( strerror(error_number) ) ;
+    }
+    pthread_mutex_unlock( &mHandlerMutex ) ;
+    return ;
+}
+
+inline
+bool
+SerialReactor::SerialReactorImpl::UnregisterHandler( const SerialReactorHandler& handler )
+{
+    pthread_mutex_lock( &mHandlerMutex ) ;
+    HandlerList::iterator handler_location = mHandlers.begin() ;
+    while( ( mHandlers.end() != handler_location ) &&
+           ( handler_location->second.mIsRemoved ||
+             ( handler_location->second.mHandler != &handler ) ) )
+    {
+        ++handler_location ;
+    }
+    if ( mHandlers.end() == handler_location )
+    {
+        pthread_mutex_unlock( &mHandlerMutex ) ;
+        return false ;
+    }
+    HandlerEntry& handler_entry = handler_location->second ;
+    epoll_ctl( mEpollFileDescriptor,
+               EPOLL_CTL_DEL,
+               handler_entry.mFileDescriptor,
+               NULL ) ;
+    //
+    // Events that have already been returned by epoll_wait() are
+    // ignored from now on. Wait for the calls that are in progress.
+    //
+    handler_entry.mIsRemoved = true ;
+    while( handler_entry.mNumOfActiveCalls > 0 )
+    {
+        pthread_cond_wait( &mHandlerIdleCondition,
+                           &mHandlerMutex ) ;
+    }
+    mHandlers.erase( handler_location ) ;
+    pthread_mutex_unlock( &mHandlerMutex ) ;
+    return true ;
+}
+
+inline
+std::vector<SerialReactorHandler*>
+SerialReactor::SerialReactorImpl::GetHandlers() const
+{
+    std::vector<SerialReactorHandler*> handlers ;
+    pthread_mutex_lock( &mHandlerMutex ) ;
+    for( HandlerList::const_iterator i = mHandlers.begin() ;
+         i != mHandlers.end() ;
+         ++i )
+    {
+        if ( ! i->second.mIsRemoved )
+        {
+            handlers.push_back( i->second.mHandler ) ;
+        }
+    }
+    pthread_mutex_unlock( &mHandlerMutex ) ;
+    return handlers ;
+}
+
+inline
+unsigned
+SerialReactor::SerialReactorImpl::GetNumOfThreads() const
+{
+    return mIoThreads.size() ;
+}
+
+inline
+size_t
+SerialReactor::SerialReactorImpl::GetNumOfHandlers() const
+{
+    pthread_mutex_lock( &mHandlerMutex ) ;
+    const size_t num_of_handlers = mHandlers.size() ;
+    pthread_mutex_unlock( &mHandlerMutex ) ;
+    return num_of_handlers ;
+}
+
+void*
+SerialReactor::SerialReactorImpl::IoThread( void* serialReactorImpl )
+{
+    static_cast<SerialReactorImpl*>( serialReactorImpl )->IoLoop() ;
+    return NULL ;
+}
+
+inline
+void
+SerialReactor::SerialReactorImpl::IoLoop()
+{
+    struct epoll_event events[ MAX_NUM_OF_EVENTS ] ;
+    while( ! mIsStopping )
+    {
+        const int num_of_events = epoll_wait( mEpollFileDescriptor,
+                                              events,
+                                              MAX_NUM_OF_EVENTS,
+                                              -1 ) ;
+        for( int i=0; i<num_of_events; ++i )
+        {
+            if ( STOP_PIPE_ID == events[i].data.u64 )
+            {
+                return ;
+            }
+            this->DispatchInputReady( events[i].data.u64 ) ;
+        }
+    }
+    return ;
+}
+
+inline
+void
+SerialReactor::SerialReactorImpl::DispatchInputReady( const unsigned long long handlerId )
+{
+    //
+    // Look up the handler and mark it as busy so that it cannot be
+    // unregistered while it is being called.
+    //
+    pthread_mutex_lock( &mHandlerMutex ) ;
+    const HandlerList::iterator handler_location = mHandlers.find( handlerId ) ;
+    if ( ( mHandlers.end() == handler_location ) ||
+         handler_location->second.mIsRemoved )
+    {
+        pthread_mutex_unlock( &mHandlerMutex ) ;
+        return ;
+    }
+    HandlerEntry& handler_entry = handler_location->second ;
+    ++handler_entry.mNumOfActiveCalls ;
+    pthread_mutex_unlock( &mHandlerMutex ) ;
+
+    //
+    // An exception must neither leave the entry marked as busy, which
+    // would block UnregisterHandler() forever, nor terminate the I/O
+    // thread.
+    //
+    try
+    {
+        handler_entry.mHandler->HandleInputReady() ;
+    }
+    catch( ... )
+    {
+        /* ignore */
+    }
+
+    pthread_mutex_lock( &mHandlerMutex ) ;
+    if ( ( 0 == --handler_entry.mNumOfActiveCalls ) &&
+         handler_entry.mIsRemoved )
+    {
+        pthread_cond_broadcast( &mHandlerIdleCondition ) ;
+    }
+    pthread_mutex_unlock( &mHandlerMutex ) ;
+    return ;
+}
@@ -0,0 +1,164 @@
+/******************************************************************************
+ *   @file SerialReactor.h                                                    *
+ *   @copyright                                                               *
+ *                                                                            *
+ *   This program is free software; you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published by     *
+ *   the Free Software Foundation; either version 2 of the License, or        *
+ *   (at your option) any later version.                                      *
+ *                                                                            *
+ *   This program is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *   GNU General Public License for more details.                             *
+ *                                                                            *
+ *   You should have received a copy of the GNU General Public License        *
+ *   along with this program; if not, write to the                            *
+ *   Free Software Foundation, Inc.,                                          *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.                *
+ *****************************************************************************/
+
+#ifndef _SerialReactor_h_
+#define _SerialReactor_h_
+
+#include "SerialPort.h"
+#include <stdexcept>
+
+/**
+ * @brief Forward declarations.
+ */
+class SerialReactorHandler ;
+
+/**
+ * @brief Receives the data of many serial ports using a single epoll
+ *        instance and a fixed number of I/O threads.
+ *
+ *        By default, every SerialPort is notified about incoming data by
+ *        the SIGIO signal. Since the signal does not tell which port has
+ *        data, every open port is checked on every signal. A SerialPort
+ *        that is attached to a SerialReactor stops using SIGIO. Instead,
+ *        the I/O threads of the reactor wait for the ports with epoll and
+ *        only move the data of the ports that are actually readable into
+ *        their input buffers. Reading from an attached port works exactly
+ *        as before.
+ *
+ * @note Attach() and Detach() must not be called concurrently with Open()
+ *       or Close() of the same serial port. Closing an attached serial
+ *       port detaches it automatically. All serial ports should be
+ *       detached or closed before the reactor is destroyed; any port that
+ *       is still attached at that point falls back to SIGIO.
+ */
+class SerialReactor
+{
+public:
+    /**
+     * @brief Creates the epoll instance and starts the I/O threads.
+     * @param numOfThreads The number of I/O threads. At least one thread
+     *        is always started.
+     * @throw std::runtime_error This exception is thrown if the epoll
+     *        instance or the threads cannot be created.
+     */
+    explicit SerialReactor( const unsigned numOfThreads = 1 )
+        throw( std::runtime_error ) ;
+
+    /**
+     * @brief Stops the I/O threads. Serial ports that are still attached
+     *        are detached and receive their data through SIGIO again.
+     */
+    ~SerialReactor() ;
+
+    /**
+     * @brief Attaches an open serial port to the reactor. From now on,
+     *        the data arriving at the serial port is moved into its
+     *        input buffer by the I/O threads of the reactor instead of
+     *        the SIGIO handler.
+     * @throw SerialPort::NotOpen This exception is thrown if the serial
+     *        port is not open.
+     * @throw std::logic_error This exception is thrown if the serial port
+     *        is already attached to a reactor.
+     * @throw std::runtime_error This exception is thrown if the serial
+     *        port cannot be added to the epoll instance.
+     */
+    void
+    Attach( SerialPort& serialPort )
+        throw( SerialPort::NotOpen,
+               std::logic_error,
+               std::runtime_error ) ;
+
+    /**
+     * @brief Detaches a serial port from the reactor. The serial port
+     *        receives its data through SIGIO again. When this method
+     *        returns, no I/O thread of the reactor is accessing the
+     *        serial port anymore.
+     * @throw std::logic_error This exception is thrown if the serial port
+     *        is not attached to this reactor.
+     * @throw std::runtime_error This exception is thrown if SIGIO cannot
+     *        be enabled for the serial port again.
+     */
+    void
+    Detach( SerialPort& serialPort )
+        throw( std::logic_error,
+               std::runtime_error ) ;
+
+    /**
+     * @brief Returns the number of I/O threads used by the reactor.
+     */
+    unsigned
+    GetNumOfThreads() const ;
+
+    /**
+     * @brief Returns the number of serial ports currently attached to
+     *        the reactor.
+     */
+    size_t
+    GetNumOfAttachedPorts() const ;
+
+private:
+    /**
+     * @brief The implementation of SerialPort registers itself with the
+     *        reactor using RegisterHandler() and UnregisterHandler().
+     */
+    friend class SerialPort::SerialPortImpl ;
+
+    /**
+     * @brief Starts watching fileDescriptor for incoming data and calls
+     *        the HandleInputReady() method of handler when data arrives.
+     */
+    void
+    RegisterHandler( const int             fileDescriptor,
+                     SerialReactorHandler& handler )
+        throw( std::runtime_error ) ;
+
+    /**
+     * @brief Stops watching the file descriptor of handler. Waits until
+     *        no I/O thread is executing a method of handler anymore.
+     * @return Returns false if handler is not registered.
+     */
+    bool
+    UnregisterHandler( const SerialReactorHandler& handler ) ;
+
+    /**
+     * @brief Copying of an instance of this class is not allowed. This
+     *        method is never defined.
+     */
+    SerialReactor( const SerialReactor& otherSerialReactor ) ;
+
+    /**
+     * @brief Copying of an instance of this class is not allowed. This
+     *        method is never defined.
+     */
+    SerialReactor& operator=( const SerialReactor& otherSerialReactor ) ;
+
+    /**
+     * @brief Forward declaration of the implementation class folowing
+     *        the PImpl idiom.
+     */
+    class SerialReactorImpl ;
+
+    /**
+     * @brief Pointer to implementation class instance.
+     */
+    SerialReactorImpl* mSerialReactorImpl ;
+} ;
+
+#endif // #ifndef _SerialReactor_h_
@@ -0,0 +1,63 @@
+/******************************************************************************
+ *   @file SerialReactorHandler.h                                             *
+ *   @copyright                                                               *
+ *                                                                            *
+ *   This program is free software; you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published by     *
+ *   the Free Software Foundation; either version 2 of the License, or        *
+ *   (at your option) any later version.                                      *
+ *                                                                            *
+ *   This program is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *   GNU General Public License for more details.                             *
+ *                                                                            *
+ *   You should have received a copy of the GNU General Public License        *
+ *   along with this program; if not, write to the                            *
+ *   Free Software Foundation, Inc.,                                          *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.                *
+ *****************************************************************************/
+
+#ifndef _SerialReactorHandler_h_
+#define _SerialReactorHandler_h_
+
+/**
+ * @brief Gets a method called by one of the I/O threads of a SerialReactor
+ *        when its file descriptor becomes readable. A SerialReactorHandler
+ *        must be registered with the SerialReactor for it to be called.
+ */
+class SerialReactorHandler
+{
+public:
+    /**
+     * @brief This method is called when new data is available at the
+     *        file descriptor of the handler. The file descriptor is
+     *        watched in edge-triggered mode, so the method must read all
+     *        available data or make sure that it is read later. The
+     *        method may be called by several I/O threads at the same
+     *        time. Exceptions thrown by the method are ignored.
+     */
+    virtual void HandleInputReady() = 0 ;
+
+    /**
+     * @brief This method is called when the SerialReactor is destroyed
+     *        while the handler is still registered. The I/O threads have
+     *        already stopped at this point. The handler is expected to
+     *        unregister itself.
+     */
+    virtual void HandleReactorShutdown() = 0 ;
+
+    /**
+     * @brief Destructor is declared virtual as we expect this class to be
+     *        subclassed. It is also declared pure abstract to make this
+     *        class a pure abstract class.
+     */
+    virtual ~SerialReactorHandler() = 0 ;
+} ;
+
+inline
+SerialReactorHandler::~SerialReactorHandler()
+{
+    /* empty */
+}
+#endif // #ifndef _SerialReactorHandler_h_
@@ -109,8 +109,9 @@ SerialStream::SerialStream( const std::string fileName,
 }
 
 void 
-SerialStream::Open( const std::string       fileName, 
-                    std::ios_base::openmode openMode ) 
+SerialStream::Open( const std::string         fileName, 
+                    std::ios_base::openmode   openMode,
+                    SerialStreamBuf::IoEngine ioEngine ) 
 {
     //
     // Create a new SerialStreamBuf if one does not exist. 
@@ -124,13 +125,33 @@ SerialStream::Open( const std::string       fileName,
     //
     // Open the serial port. 
     //
-    if ( 0 == mIOBuffer->open(fileName, openMode) )
+    if ( 0 == mIOBuffer->open(fileName, openMode, ioEngine) )
     {
         setstate(badbit) ;    
     }
     return ;
 }
 
+void
+SerialStream::SetPortSettings( const SerialPort::PortSettings& portSettings,
+                               bool                            drain )
+{
+    SerialStreamBuf* my_buffer = 
+        dynamic_cast<SerialStreamBuf *>(this->rdbuf()) ;
+    //
+    // Make sure that we are dealing with a SerialStreamBuf before
+    // proceeding and stop all I/O using this stream if the settings
+    // could not be applied.
+    //
+    if ( ( ! my_buffer ) ||
+         ( -1 == my_buffer->SetPortSettings( portSettings,
+                                             drain ) ) )
+    {
+        setstate(badbit) ;
+    }
+    return ;
+}
+
 void 
 SerialStream::SetBaudRate( 
     const SerialStreamBuf::BaudRateEnum baudRate ) 
@@ -535,3 +556,103 @@ SerialStream::FlowControl()
         return SerialStreamBuf::FLOW_CONTROL_INVALID ;
     }
 }
+
+void
+SerialStream::SetReadTimeout( const unsigned int msTimeout )
+{
+    SerialStreamBuf* my_buffer = dynamic_cast<SerialStreamBuf *>(this->rdbuf()) ;
+    if ( ( 0 == my_buffer ) ||
+         ( -1 == my_buffer->SetReadTimeout( msTimeout ) ) )
+    {
+        setstate(badbit) ;
+    }
+}
+
+unsigned int
+SerialStream::ReadTimeout()
+{
+    SerialStreamBuf* my_buffer = dynamic_cast<SerialStreamBuf *>(this->rdbuf()) ;
+    if ( my_buffer )
+    {
+        return my_buffer->ReadTimeout() ;
+    }
+    else
+    {
+        setstate(badbit) ;
+        return 0 ;
+    }
+}
+
+void
+SerialStream::SetWriteTimeout( const unsigned int msTimeout )
+{
+    SerialStreamBuf* my_buffer = dynamic_cast<SerialStreamBuf *>(this->rdbuf()) ;
+    if ( ( 0 == my_buffer ) ||
+         ( -1 == my_buffer->SetWriteTimeout( msTimeout ) ) )
+    {
+        setstate(badbit) ;
+    }
+}
+
+unsigned int
+SerialStream::WriteTimeout()
+{
+    SerialStreamBuf* my_buffer = dynamic_cast<SerialStreamBuf *>(this->rdbuf()) ;
+    if ( my_buffer )
+    {
+        return my_buffer->WriteTimeout() ;
+    }
+    else
+    {
+        setstate(badbit) ;
+        return 0 ;
+    }
+}
+
+bool
+SerialStream::IsTimedOut()
+{
+    SerialStreamBuf* my_buffer = dynamic_cast<SerialStreamBuf *>(this->rdbuf()) ;
+    if ( my_buffer )
+    {
+        return my_buffer->IsTimedOut() ;
+    }
+    else
+    {
+        setstate(badbit) ;
+        return false ;
+    }
+}
+
+std::streamsize
+SerialStream::ReadBlock( char*                 buffer,
+                         const std::streamsize numOfChars,
+                         const unsigned int    msTimeout )
+{
+    SerialStreamBuf* my_buffer = dynamic_cast<SerialStreamBuf *>(this->rdbuf()) ;
+    if ( my_buffer )
+    {
+        return my_buffer->ReadBlock( buffer, numOfChars, msTimeout ) ;
+    }
+    else
+    {
+        setstate(badbit) ;
+        return 0 ;
+    }
+}
+
+std::streamsize
+SerialStream::WriteBlock( const char*           buffer,
+                          const std::streamsize numOfChars )
+{
+    SerialStreamBuf* my_buffer = dynamic_cast<SerialStreamBuf *>(this->rdbuf()) ;
+    if ( my_buffer )
+    {
+        return my_buffer->WriteBlock( buffer, numOfChars ) ;
+    }
+    else
+    {
+        setstate(badbit) ;
+        return 0 ;
+    }
+}
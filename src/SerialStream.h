@@ -149,10 +149,16 @@ extern "C++"
              * @param fileName The file descriptor of the serial stream object.
              * @param openMode The communication mode status when the serial
              *        communication port is opened.
+             * @param ioEngine Selects how the serial port is accessed. With
+             *        SerialStreamBuf::IO_ENGINE_SERIAL_PORT, all I/O goes
+             *        through a SerialPort object that buffers input in the
+             *        background. See SerialStreamBuf::open().
              */
             void Open( const std::string fileName, 
                        std::ios_base::openmode openMode = 
-                       std::ios_base::in | std::ios_base::out) ;
+                       std::ios_base::in | std::ios_base::out,
+                       SerialStreamBuf::IoEngine ioEngine =
+                       SerialStreamBuf::IO_ENGINE_DIRECT ) ;
 
             /**
              * @brief Closes the serial port. No communications can occur with
@@ -166,6 +172,14 @@ extern "C++"
              */
             bool IsOpen() const ;
 
+            /**
+             * @brief Applies all of the specified serial communication
+             *        parameters at once. Sets the badbit of the stream if
+             *        the settings could not be applied.
+             */
+            void SetPortSettings( const SerialPort::PortSettings& portSettings,
+                                  bool drain = false ) ;
+
             /** 
              * @brief Sets the input and output baud ratesfor the
              *        Serial Stream object. 
@@ -271,6 +285,77 @@ extern "C++"
              */
             short VTime() ;
 
+            /**
+             * @brief Sets the time in milliseconds that reading from the
+             *        stream may wait for data. When it expires, the read
+             *        fails and IsTimedOut() returns true. A value of 0
+             *        makes reads wait indefinitely. Unlike VTIME, this
+             *        timeout does not depend on VMIN. See
+             *        SerialStreamBuf::SetReadTimeout() for details.
+             * @param msTimeout The timeout period in milliseconds.
+             */
+            void SetReadTimeout( const unsigned int msTimeout ) ;
+
+            /**
+             * @brief Returns the read timeout in milliseconds.
+             */
+            unsigned int ReadTimeout() ;
+
+            /**
+             * @brief Sets the time in milliseconds that writing to the
+             *        stream may wait for the serial port to accept more
+             *        characters. When it expires, the write fails and
+             *        IsTimedOut() returns true. A value of 0 makes writes
+             *        wait indefinitely. See
+             *        SerialStreamBuf::SetWriteTimeout() for details.
+             * @param msTimeout The timeout period in milliseconds.
+             */
+            void SetWriteTimeout( const unsigned int msTimeout ) ;
+
+            /**
+             * @brief Returns the write timeout in milliseconds.
+             */
+            unsigned int WriteTimeout() ;
+
+            /**
+             * @brief Returns true if the most recent read from or write to
+             *        the serial port failed because its timeout expired.
+             *        This distinguishes a timeout from other failures after
+             *        the stream has set failbit or badbit.
+             */
+            bool IsTimedOut() ;
+
+            /**
+             * @brief Reads exactly numOfChars characters into buffer unless
+             *        msTimeout milliseconds pass first, with as few system
+             *        calls as possible. Unlike read(), this method does not
+             *        construct a sentry, does not set failbit or eofbit,
+             *        and keeps reading after short reads. The timeout
+             *        applies to the whole request. See
+             *        SerialStreamBuf::ReadBlock() for details.
+             * @param buffer The memory to read the characters into.
+             * @param numOfChars The number of characters to read.
+             * @param msTimeout The timeout period in milliseconds.
+             * @return Returns the number of characters read into buffer.
+             */
+            std::streamsize ReadBlock( char*                 buffer,
+                                       const std::streamsize numOfChars,
+                                       const unsigned int    msTimeout = 0 ) ;
+
+            /**
+             * @brief Writes numOfChars characters from buffer to the serial
+             *        port after any characters that are still buffered.
+             *        Unlike write(), this method does not construct a
+             *        sentry, does not set badbit, and does not copy the
+             *        characters into the output buffer. See
+             *        SerialStreamBuf::WriteBlock() for details.
+             * @param buffer The characters to write.
+             * @param numOfChars The number of characters to write.
+             * @return Returns the number of characters written.
+             */
+            std::streamsize WriteBlock( const char*           buffer,
+                                        const std::streamsize numOfChars ) ;
+
 
             /**------------------------------------------------------------
              * Friends
@@ -19,7 +19,12 @@
  *****************************************************************************/
 
 #include "SerialStreamBuf.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -27,7 +32,11 @@
 #include <cassert>
 #include <fstream>
 #include <limits.h>
+#include <poll.h>
 #include <strings.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <vector>
 
 
 using namespace std ;
@@ -57,14 +66,20 @@ SerialStreamBuf::DEFAULT_VMIN            = 1                  ;
 const short
 SerialStreamBuf::DEFAULT_VTIME           = 0                  ;
 
+const std::streamsize
+SerialStreamBuf::DEFAULT_BUFFER_SIZE     = 1024               ;
+
 
 class SerialStreamBuf::Implementation
 {
 public:
-    Implementation() ;
+    Implementation( SerialStreamBuf& streamBuf ) ;
 
     ~Implementation() { /* empty */ }
 
+    bool
+    IsOpen() const ;
+
     SerialStreamBuf::BaudRateEnum
     SetBaudRate(const SerialStreamBuf::BaudRateEnum baud_rate) ;
 
@@ -98,6 +113,50 @@ public:
     short SetVTime( short vtime ) ;
     short VTime() const;
 
+    streamsize
+    Peek( char_type* s, streamsize n ) ;
+
+    void
+    setbuf(char_type *s, streamsize n) ;
+
+    void
+    ResetGetArea() ;
+
+    int
+    SetOutputBufferSize( streamsize size ) ;
+
+    void
+    SetAutoFlushChar( int_type autoFlushChar ) ;
+
+    /**
+     * Sets the put area of mStreamBuf to mPutBuffer with the specified
+     * number of characters already in it. While an auto-flush character
+     * is set, the put area ends at pptr(), so that every character is
+     * passed to overflow() which checks for it.
+     */
+    void
+    SetPutArea( streamsize numOfPendingChars ) ;
+
+    /**
+     * Removes the specified number of characters from the beginning of
+     * the put area, e.g. after they have been written.
+     */
+    void
+    RemovePendingChars( streamsize numOfChars ) ;
+
+    int
+    sync() ;
+
+    int
+    SetTimeouts( unsigned int readTimeout,
+                 unsigned int writeTimeout ) ;
+
+    streamsize
+    ReadBlock( char_type* s, streamsize n, unsigned int msTimeout ) ;
+
+    streamsize
+    WriteBlock( const char_type* s, streamsize n ) ;
+
     streamsize
     xsgetn(char_type *s, streamsize n) ;
 
@@ -117,24 +176,77 @@ public:
     overflow(int_type c) ;
 
 public: // Yes. "public"
-    /** 
-     * We use unbuffered I/O for the serial port. However, we
-     * need to provide the putback of atleast one
-     * character. This character contains the putback
-     * character.
+    /**
+     * The stream buffer whose get area is managed by this object.
+     */
+    SerialStreamBuf& mStreamBuf ;
+
+    /**
+     * The buffer that underflow() fills with characters read from
+     * the serial port. It is either supplied by the user through
+     * setbuf() or points to mOwnedGetBuffer. The get area of
+     * mStreamBuf lies in this buffer or in mLookahead.
+     */
+    char_type* mGetBuffer ;
+    streamsize mGetBufferSize ;
+
+    /**
+     * Storage for mGetBuffer when the user did not supply a buffer.
      */
-    char mPutbackChar ;
+    std::vector<char_type> mOwnedGetBuffer ;
 
     /** 
-     * True if a putback value is available in mPutbackChar. 
+     * Storage for the get area when it has to hold more characters
+     * than fit into mGetBuffer, e.g. for Peek() or when characters are
+     * put back in front of the get area. The next underflow() returns
+     * to mGetBuffer.
+     */
+    std::string mLookahead ;
+
+    /**
+     * The buffer that holds the put area of mStreamBuf. Output is
+     * unbuffered if it is empty.
+     */
+    std::vector<char_type> mPutBuffer ;
+
+    /**
+     * The character that makes the put area be written to the serial
+     * port, or traits_type::eof() if there is none.
+     */
+    int_type mAutoFlushChar ;
+
+    /**
+     * The read and write timeouts in milliseconds, or 0 to wait
+     * indefinitely. The serial port is in non-blocking mode if either
+     * of them is set.
+     */
+    unsigned int mReadTimeout ;
+    unsigned int mWriteTimeout ;
+
+    /**
+     * True if the last call to ReadPort() or WriteFully() failed
+     * because the timeout expired.
      */
-    bool mPutbackAvailable ;
+    bool mIsTimedOut ;
       
     /** 
      * The file descriptor associated with the serial port. 
      */
     int mFileDescriptor ;
 
+    /**
+     * The object that performs all I/O if the serial port was opened
+     * with IO_ENGINE_SERIAL_PORT. mFileDescriptor is -1 in that case.
+     */
+    boost::scoped_ptr<SerialPort> mSerialPort ;
+
+    /**
+     * Copy of the terminal settings currently applied to the serial
+     * port. It is read back from the driver whenever the settings are
+     * changed, so the accessor methods do not need to call tcgetattr().
+     */
+    struct termios mTermSetting ;
+
     /* ------------------------------------------------------------
      * Private Methods
      * ------------------------------------------------------------
@@ -148,13 +260,111 @@ public: // Yes. "public"
      */
     int InitializeSerialPort() ;
 
+    /**
+     * Opens the specified serial port with a SerialPort object and
+     * stores it in mSerialPort.
+     *
+     * @return -1 on failure and some other value on success.
+     */
+    int OpenSerialPort( const std::string& fileName ) ;
+
     int SetParametersToDefault() ;
+
+    int SetPortSettings( const SerialPort::PortSettings& portSettings,
+                         const bool                      drain ) ;
+
+    int RefreshPortSettings() ;
+
+    /**
+     * Puts the serial port into non-blocking mode if a read or write
+     * timeout is set and into blocking mode otherwise.
+     *
+     * @return -1 on failure and some other value on success.
+     */
+    int ApplyBlockingMode() ;
+
+    /**
+     * Waits with poll() until the specified events occur on the serial
+     * port or msTimeout milliseconds have passed. If msTimeout is 0, it
+     * waits indefinitely.
+     *
+     * @return The result of poll(), i.e. 0 if the timeout expired.
+     */
+    int WaitForPort( short        events,
+                     unsigned int msTimeout ) ;
+
+    /**
+     * Reads up to size characters from the serial port like read(). If
+     * the serial port is in non-blocking mode, it first waits for data
+     * for up to mReadTimeout milliseconds.
+     *
+     * @return The number of characters read, or -1 on failure.
+     */
+    ssize_t ReadPort( char_type* buffer,
+                      streamsize size ) ;
+
+    /**
+     * Writes headSize characters at head followed by tailSize characters
+     * at tail to the serial port with as few calls to writev() as
+     * possible. Short writes are continued and interrupted calls are
+     * restarted until all characters are written or writev() fails. In
+     * non-blocking mode, it waits for up to mWriteTimeout milliseconds
+     * whenever the driver does not accept more characters.
+     *
+     * @return The number of characters written.
+     */
+    streamsize WriteFully( const char_type* head,
+                           streamsize       headSize,
+                           const char_type* tail,
+                           streamsize       tailSize ) ;
+
+    /**
+     * Applies the specified terminal settings to the serial port and
+     * updates mTermSetting with the settings used by the driver. The
+     * copy is updated even if tcsetattr() fails because some of the
+     * settings may have been applied.
+     *
+     * @return -1 on failure and some other value on success.
+     */
+    int WriteTermSetting( const struct termios& termSetting,
+                          const int             optionalActions ) ;
+
+    /**
+     * The following methods modify the specified termios structure
+     * without applying it to the serial port. This allows several
+     * parameters to be changed with a single call to tcsetattr().
+     *
+     * @return false if the specified value is not supported.
+     */
+    static bool ApplyBaudRate( struct termios&                    termSetting,
+                               const SerialStreamBuf::BaudRateEnum baudRate ) ;
+
+    static bool ApplyCharSize( struct termios&                    termSetting,
+                               const SerialStreamBuf::CharSizeEnum charSize ) ;
+
+    static bool ApplyNumOfStopBits( struct termios& termSetting,
+                                    const short     numOfStopBits ) ;
+
+    static bool ApplyParity( struct termios&                  termSetting,
+                             const SerialStreamBuf::ParityEnum parityType ) ;
+
+    static bool ApplyFlowControl( struct termios&                       termSetting,
+                                  const SerialStreamBuf::FlowControlEnum flowControlType ) ;
+
+private:
+    /**
+     * The copy constructor and the assignment operator are declared
+     * private but never defined.
+     */
+    Implementation( const Implementation& ) ;
+    Implementation& operator=( const Implementation& ) ;
 } ;
 
 SerialStreamBuf::SerialStreamBuf() :
-    mImpl( new Implementation )
+    mImpl( new Implementation( *this ) )
 {
-    setbuf(0, 0) ;
+    setbuf( 0, DEFAULT_BUFFER_SIZE ) ;
+    SetOutputBufferSize( DEFAULT_BUFFER_SIZE ) ;
     return ;
 }
 
@@ -172,14 +382,22 @@ SerialStreamBuf::~SerialStreamBuf()
 bool
 SerialStreamBuf::is_open() const 
 {
-    return (-1 != mImpl->mFileDescriptor) ;
+    return mImpl->IsOpen() ;
+}
+
+
+bool
+SerialStreamBuf::IsUsingSerialPort() const
+{
+    return ( 0 != mImpl->mSerialPort.get() ) ;
 }
     
 
 std::streambuf* 
-SerialStreamBuf::setbuf(char_type *, std::streamsize) 
+SerialStreamBuf::setbuf(char_type *s, std::streamsize n) 
 {
-    return std::streambuf::setbuf(0, 0) ;
+    mImpl->setbuf( s, n ) ;
+    return this ;
 }
 
 
@@ -194,40 +412,58 @@ SerialStreamBuf::close()
         return 0 ;
     }
     //
-    // Otherwise, close the serial port and set the file descriptor
-    // to an invalid value.
+    // Otherwise, write the characters in the put area and close the
+    // serial port even if they could not all be written. Then set the
+    // file descriptor to an invalid value.
     //
-    if ( -1 == ::close(mImpl->mFileDescriptor) ) 
+    const int sync_result = mImpl->sync() ;
+    if ( 0 != mImpl->mSerialPort.get() )
+    {
+        //
+        // The SerialPort object closes the serial port when it is
+        // destroyed.
+        //
+        mImpl->mSerialPort.reset() ;
+    }
+    else if ( -1 == ::close(mImpl->mFileDescriptor) ) 
     {
         //
         // If the close failed then return a null pointer. 
         //
         return 0 ;
     } 
-    else 
+    //
+    // Set the file descriptor to an invalid value, -1, and forget
+    // the characters that have not been extracted or written.
+    //
+    mImpl->mFileDescriptor = -1 ;
+    mImpl->ResetGetArea() ;
+    mImpl->SetPutArea( 0 ) ;
+    //
+    // On success, return "this" as required by the C++ standard.
+    //
+    if ( -1 == sync_result )
     {
-        //
-        // Set the file descriptor to an invalid value, -1. 
-        //
-        mImpl->mFileDescriptor = -1 ;
-        //
-        // On success, return "this" as required by the C++ standard.
-        //
-        return this ;
+        return 0 ;
     }
+    return this ;
 }
     
 std::streambuf::int_type
 SerialStreamBuf::uflow() 
 {
     int_type next_ch = underflow() ;
-    mImpl->mPutbackAvailable = false ;
+    if ( ! traits_type::eq_int_type( next_ch, traits_type::eof() ) )
+    {
+        gbump( 1 ) ;
+    }
     return next_ch ;
 }
 
 SerialStreamBuf*
-SerialStreamBuf::open( const string filename,
-                       ios_base::openmode mode ) 
+SerialStreamBuf::open( const string       filename,
+                       ios_base::openmode mode,
+                       IoEngine           ioEngine ) 
 {
     //
     // If the buffer is alreay open then we should not allow a call to
@@ -259,6 +495,17 @@ SerialStreamBuf::open( const string filename,
     {
         return 0 ;
     }
+    //
+    // A SerialPort object opens and configures the serial port itself.
+    //
+    if ( IO_ENGINE_SERIAL_PORT == ioEngine )
+    {
+        if ( -1 == mImpl->OpenSerialPort( filename ) )
+        {
+            return 0 ;
+        }
+        return this ;
+    }
     /* switch( mode )
        {
        case ios_base::in:
@@ -305,6 +552,20 @@ SerialStreamBuf::SetParametersToDefault()
 }
 
 
+int
+SerialStreamBuf::RefreshPortSettings()
+{
+    return mImpl->RefreshPortSettings() ;
+}
+
+int
+SerialStreamBuf::SetPortSettings( const SerialPort::PortSettings& portSettings,
+                                  const bool                      drain )
+{
+    return mImpl->SetPortSettings( portSettings,
+                                   drain ) ;
+}
+
 SerialStreamBuf::BaudRateEnum
 SerialStreamBuf::SetBaudRate(const BaudRateEnum baud_rate) 
 {
@@ -367,6 +628,18 @@ SerialStreamBuf::SetFlowControl(const FlowControlEnum flow_c)
 SerialStreamBuf::FlowControlEnum
 SerialStreamBuf::Implementation::SetFlowControl(const SerialStreamBuf::FlowControlEnum flow_c) 
 {
+    if ( 0 != mSerialPort.get() )
+    {
+        try
+        {
+            mSerialPort->SetFlowControl( SerialPort::FlowControl( flow_c ) ) ;
+        }
+        catch( const std::exception& )
+        {
+            return FLOW_CONTROL_INVALID ;
+        }
+        return this->FlowControl() ;
+    }
     if ( -1 == mFileDescriptor ) 
     {
         return FLOW_CONTROL_INVALID ;
@@ -381,38 +654,13 @@ SerialStreamBuf::Implementation::SetFlowControl(const SerialStreamBuf::FlowContr
     //
     // Get the current terminal settings. 
     //
-    struct termios tset;
-    int retval = tcgetattr( mFileDescriptor, &tset );
-    if ( -1 == retval )
-    {
-        return FLOW_CONTROL_INVALID ;
-    }
+    struct termios tset = mTermSetting ;
     //
-    // Set the flow control. Hardware flow control uses the RTS (Ready
-    // To Send) and CTS (clear to Send) lines. Software flow control
-    // uses IXON|IXOFF
+    // Set the flow control.
     //
-    if ( FLOW_CONTROL_HARD == flow_c )
-    {
-        tset.c_iflag &= ~ (IXON|IXOFF) ;
-        tset.c_cflag |= CRTSCTS ;
-        tset.c_cc[VSTART] = _POSIX_VDISABLE ;
-        tset.c_cc[VSTOP] = _POSIX_VDISABLE ;
-    }
-    else if ( FLOW_CONTROL_SOFT == flow_c )
-    {
-        tset.c_iflag |= IXON|IXOFF ;
-        tset.c_cflag &= ~CRTSCTS ;
-        tset.c_cc[VSTART] = CTRL_Q ; // 0x11 (021) ^q
-        tset.c_cc[VSTOP]  = CTRL_S ; // 0x13 (023) ^s
-    }
-    else
-    {
-        tset.c_iflag &= ~(IXON|IXOFF) ;
-        tset.c_cflag &= ~CRTSCTS ;
-    }
+    ApplyFlowControl( tset, flow_c ) ;
     
-    retval = tcsetattr(mFileDescriptor, TCSANOW, &tset);
+    int retval = this->WriteTermSetting( tset, TCSANOW ) ;
     
     if (-1 == retval)
     {
@@ -449,12 +697,7 @@ SerialStreamBuf::Implementation::VMin() const
     //
     // Get the current terminal settings. 
     //
-    struct termios term_setting ;
-    
-    if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-    {
-        return -1 ;
-    }
+    const struct termios& term_setting = mTermSetting ;
 
     return term_setting.c_cc[VMIN];
 }
@@ -472,6 +715,95 @@ SerialStreamBuf::VTime() const
 }
 
 
+streamsize
+SerialStreamBuf::Peek( char_type* s, streamsize n )
+{
+    return mImpl->Peek( s, n ) ;
+}
+
+
+int
+SerialStreamBuf::SetOutputBufferSize( streamsize size )
+{
+    return mImpl->SetOutputBufferSize( size ) ;
+}
+
+
+streamsize
+SerialStreamBuf::OutputBufferSize() const
+{
+    return mImpl->mPutBuffer.size() ;
+}
+
+
+void
+SerialStreamBuf::SetAutoFlushChar( int_type autoFlushChar )
+{
+    mImpl->SetAutoFlushChar( autoFlushChar ) ;
+}
+
+
+streambuf::int_type
+SerialStreamBuf::AutoFlushChar() const
+{
+    return mImpl->mAutoFlushChar ;
+}
+
+
+int
+SerialStreamBuf::SetReadTimeout( unsigned int msTimeout )
+{
+    return mImpl->SetTimeouts( msTimeout,
+                               mImpl->mWriteTimeout ) ;
+}
+
+
+unsigned int
+SerialStreamBuf::ReadTimeout() const
+{
+    return mImpl->mReadTimeout ;
+}
+
+
+int
+SerialStreamBuf::SetWriteTimeout( unsigned int msTimeout )
+{
+    return mImpl->SetTimeouts( mImpl->mReadTimeout,
+                               msTimeout ) ;
+}
+
+
+unsigned int
+SerialStreamBuf::WriteTimeout() const
+{
+    return mImpl->mWriteTimeout ;
+}
+
+
+bool
+SerialStreamBuf::IsTimedOut() const
+{
+    return mImpl->mIsTimedOut ;
+}
+
+
+streamsize
+SerialStreamBuf::ReadBlock( char_type*   s,
+                            streamsize   n,
+                            unsigned int msTimeout )
+{
+    return mImpl->ReadBlock( s, n, msTimeout ) ;
+}
+
+
+streamsize
+SerialStreamBuf::WriteBlock( const char_type* s,
+                             streamsize       n )
+{
+    return mImpl->WriteBlock( s, n ) ;
+}
+
+
 streamsize
 SerialStreamBuf::xsgetn(char_type *s, streamsize n) 
 {
@@ -499,6 +831,13 @@ SerialStreamBuf::pbackfail(int_type c)
 }
 
 
+int
+SerialStreamBuf::sync()
+{
+    return mImpl->sync() ;
+}
+
+
 streamsize
 SerialStreamBuf::xsputn(const char_type *s, streamsize n) 
 {
@@ -512,18 +851,65 @@ SerialStreamBuf::overflow(int_type c)
 }
 
 inline
-SerialStreamBuf::Implementation::Implementation() :
-    mPutbackChar(0),
-    mPutbackAvailable(false),
-    mFileDescriptor(-1)
+SerialStreamBuf::Implementation::Implementation( SerialStreamBuf& streamBuf ) :
+    mStreamBuf(streamBuf),
+    mGetBuffer(0),
+    mGetBufferSize(0),
+    mOwnedGetBuffer(),
+    mLookahead(),
+    mPutBuffer(),
+    mAutoFlushChar( traits_type::eof() ),
+    mReadTimeout(0),
+    mWriteTimeout(0),
+    mIsTimedOut(false),
+    mFileDescriptor(-1),
+    mSerialPort(),
+    mTermSetting()
 {
     /* empty */
 }
 
+inline
+bool
+SerialStreamBuf::Implementation::IsOpen() const
+{
+    return ( ( -1 != mFileDescriptor ) ||
+             ( 0 != mSerialPort.get() ) ) ;
+}
+
+inline
+int
+SerialStreamBuf::Implementation::OpenSerialPort( const std::string& fileName )
+{
+    boost::scoped_ptr<SerialPort> serial_port( new SerialPort( fileName ) ) ;
+    try
+    {
+        serial_port->Open() ;
+    }
+    catch( const std::exception& )
+    {
+        return -1 ;
+    }
+    mSerialPort.swap( serial_port ) ;
+    return 0 ;
+}
+
 inline
 int 
 SerialStreamBuf::Implementation::SetParametersToDefault()
 {
+    if ( 0 != mSerialPort.get() )
+    {
+        try
+        {
+            mSerialPort->SetPortSettings( SerialPort::PortSettings() ) ;
+        }
+        catch( const std::exception& )
+        {
+            return -1 ;
+        }
+        return 0 ;
+    }
     if ( -1 == mFileDescriptor )
     {
         return -1 ;
@@ -551,91 +937,320 @@ SerialStreamBuf::Implementation::SetParametersToDefault()
     tio.c_line = '\0';
 #endif
     bzero( &tio.c_cc, sizeof(tio.c_cc) ) ;
-    tio.c_cc[VTIME] = 0;
-    tio.c_cc[VMIN]  = 1;
-    
-    if ( -1 == tcsetattr(mFileDescriptor,TCSANOW,&tio) )
-    {
-        return -1 ;
-    }
+    tio.c_cc[VTIME] = DEFAULT_VTIME ;
+    tio.c_cc[VMIN]  = DEFAULT_VMIN ;
     //
-    // Baud rate
+    // Add the default communication parameters to the same structure
+    // so that the serial port is configured with a single call to
+    // tcsetattr() and never runs with a partial configuration.
     //
-    if ( BAUD_INVALID == SetBaudRate(DEFAULT_BAUD) )
+    if ( ( ! ApplyBaudRate( tio, DEFAULT_BAUD ) )                      ||
+         ( ! ApplyCharSize( tio, DEFAULT_CHAR_SIZE ) )                 ||
+         ( ! ApplyNumOfStopBits( tio, DEFAULT_NO_OF_STOP_BITS ) )      ||
+         ( ! ApplyParity( tio, DEFAULT_PARITY ) )                      ||
+         ( ! ApplyFlowControl( tio, DEFAULT_FLOW_CONTROL ) ) )
     {
         return -1 ;
     }
-    //
-    // Character size. 
-    //
-    if ( CHAR_SIZE_INVALID == SetCharSize(DEFAULT_CHAR_SIZE) )
+    if ( -1 == this->WriteTermSetting( tio, TCSANOW ) )
     {
         return -1 ;
     }
     //
-    // Number of stop bits. 
+    // All done. Return a value other than -1. 
     //
-    if ( -1 == SetNumOfStopBits(DEFAULT_NO_OF_STOP_BITS) )
+    return 0 ;
+}
+
+inline
+int
+SerialStreamBuf::Implementation::SetPortSettings( const SerialPort::PortSettings& portSettings,
+                                                  const bool                      drain )
+{
+    if ( 0 != mSerialPort.get() )
     {
-        return -1 ;
+        //
+        // Write the characters in the put area first if the pending
+        // output has to be transmitted with the current settings.
+        //
+        if ( drain &&
+             ( -1 == this->sync() ) )
+        {
+            return -1 ;
+        }
+        try
+        {
+            mSerialPort->SetPortSettings( portSettings,
+                                          drain ) ;
+        }
+        catch( const std::exception& )
+        {
+            return -1 ;
+        }
+        return 0 ;
     }
-    //
-    // Parity
-    //
-    if ( PARITY_INVALID == SetParity(DEFAULT_PARITY) )
+    if ( -1 == mFileDescriptor )
     {
         return -1 ;
     }
     //
-    // Flow control
+    // Get the current terminal settings. 
+    //
+    struct termios term_setting = mTermSetting ;
     //
-    if ( FLOW_CONTROL_INVALID == SetFlowControl(DEFAULT_FLOW_CONTROL) )
+    // Modify all parameters in our copy of the settings. Nothing is
+    // applied to the serial port if any of the values is invalid.
+    //
+    const short num_of_stop_bits =
+        ( SerialPort::STOP_BITS_2 == portSettings.stopBits ) ? 2 : 1 ;
+    if ( ( ! ApplyBaudRate( term_setting,
+                            BaudRateEnum( portSettings.baudRate ) ) )        ||
+         ( ! ApplyCharSize( term_setting,
+                            CharSizeEnum( portSettings.charSize ) ) )        ||
+         ( ! ApplyNumOfStopBits( term_setting,
+                                 num_of_stop_bits ) )                        ||
+         ( ! ApplyParity( term_setting,
+                          ParityEnum( portSettings.parityType ) ) )          ||
+         ( ! ApplyFlowControl( term_setting,
+                               FlowControlEnum( portSettings.flowControl ) ) ) )
     {
         return -1 ;
     }
     //
-    // VMin
+    // Apply all of them at once, optionally after the pending output
+    // has been transmitted. This includes the characters in the put
+    // area, so they have to be written first.
     //
-    if ( -1 == SetVMin(DEFAULT_VMIN) )
+    if ( drain &&
+         ( -1 == this->sync() ) )
     {
         return -1 ;
     }
-    //
-    // VTime
-    //
-    if ( -1 == SetVTime(DEFAULT_VTIME) )
+    if ( -1 == this->WriteTermSetting( term_setting,
+                                       ( drain ? TCSADRAIN : TCSANOW ) ) )
     {
         return -1 ;
     }
-    //
-    // All done. Return a value other than -1. 
-    //
     return 0 ;
 }
 
 inline
 int
-SerialStreamBuf::Implementation::InitializeSerialPort() 
+SerialStreamBuf::Implementation::RefreshPortSettings()
 {
-    //
-    // If we do not have a valid file descriptor then return with
-    // failure.
-    //
-    if ( -1 == this->mFileDescriptor )
+    if ( 0 != mSerialPort.get() )
     {
-        return -1 ;
+        try
+        {
+            mSerialPort->RefreshPortSettings() ;
+        }
+        catch( const std::exception& )
+        {
+            return -1 ;
+        }
+        return 0 ;
     }
-    //
-    // Use non-blocking mode while configuring the serial port. 
-    //
-    int flags = fcntl(this->mFileDescriptor, F_GETFL, 0) ;
-    if ( -1 == fcntl( this->mFileDescriptor, 
-                     F_SETFL, 
-                     flags | O_NONBLOCK ) )
+    if ( -1 == mFileDescriptor )
     {
         return -1 ;
     }
-    //
+    return tcgetattr(mFileDescriptor, &mTermSetting) ;
+}
+
+inline
+int
+SerialStreamBuf::Implementation::WriteTermSetting( const struct termios& termSetting,
+                                                   const int             optionalActions )
+{
+    const int retval = tcsetattr(mFileDescriptor, optionalActions, &termSetting) ;
+    //
+    // Read back the settings because the driver may silently ignore
+    // some of them.
+    //
+    if ( ( -1 == tcgetattr(mFileDescriptor, &mTermSetting) ) ||
+         ( -1 == retval ) )
+    {
+        return -1 ;
+    }
+    return 0 ;
+}
+
+inline
+bool
+SerialStreamBuf::Implementation::ApplyBaudRate( struct termios&                    termSetting,
+                                                const SerialStreamBuf::BaudRateEnum baudRate )
+{
+    switch (baudRate)
+    {
+    case BAUD_50:
+    case BAUD_75:   
+    case BAUD_110:  
+    case BAUD_134:  
+    case BAUD_150:  
+    case BAUD_200:  
+    case BAUD_300:  
+    case BAUD_600:  
+    case BAUD_1200: 
+    case BAUD_1800: 
+    case BAUD_2400: 
+    case BAUD_4800: 
+    case BAUD_9600: 
+    case BAUD_19200:
+    case BAUD_38400:
+    case BAUD_57600:
+    case BAUD_115200:
+        break ;
+    default:
+        return false ;
+        break ;
+    }
+    //
+    // Modify the baud rate in the termios structure.
+    //
+    cfsetispeed( &termSetting, baudRate ) ;
+    cfsetospeed( &termSetting, baudRate ) ;
+    return true ;
+}
+
+inline
+bool
+SerialStreamBuf::Implementation::ApplyCharSize( struct termios&                    termSetting,
+                                                const SerialStreamBuf::CharSizeEnum charSize )
+{
+    switch(charSize)
+    {
+    case CHAR_SIZE_5:
+    case CHAR_SIZE_6:
+    case CHAR_SIZE_7:
+    case CHAR_SIZE_8:
+        break ;
+    default:
+        return false ;
+        break ;
+    }
+    //
+    // Set the character size to the specified value. If the character
+    // size is not 8 then it is also important to set ISTRIP. Setting
+    // ISTRIP causes all but the 7 low-order bits to be set to
+    // zero. Otherwise they are set to unspecified values and may
+    // cause problems. At the same time, we should clear the ISTRIP
+    // flag when the character size is 8 otherwise the MSB will always
+    // be set to zero (ISTRIP does not check the character size
+    // setting; it just sets every bit above the low 7 bits to zero).
+    //
+    if ( charSize == CHAR_SIZE_8 )
+    {
+        termSetting.c_iflag &= ~ISTRIP ; // clear the ISTRIP flag.
+    }
+    else
+    {
+        termSetting.c_iflag |= ISTRIP ;  // set the ISTRIP flag.
+    }
+
+    termSetting.c_cflag &= ~CSIZE ;     // clear all the CSIZE bits.
+    termSetting.c_cflag |= charSize ;   // set the character size. 
+    return true ;
+}
+
+inline
+bool
+SerialStreamBuf::Implementation::ApplyNumOfStopBits( struct termios& termSetting,
+                                                     const short     numOfStopBits )
+{
+    switch ( numOfStopBits )
+    {
+    case 1:
+        termSetting.c_cflag &= ~CSTOPB ;
+        break ;
+    case 2:
+        termSetting.c_cflag |= CSTOPB ;
+        break ;
+    default: 
+        return false ;
+        break ;
+    }
+    return true ;
+}
+
+inline
+bool
+SerialStreamBuf::Implementation::ApplyParity( struct termios&                  termSetting,
+                                              const SerialStreamBuf::ParityEnum parityType )
+{
+    switch ( parityType )
+    {
+    case PARITY_EVEN:
+        termSetting.c_cflag |= PARENB ;
+        termSetting.c_cflag &= ~PARODD ;
+        break ;
+    case PARITY_ODD:
+        termSetting.c_cflag |= PARENB ;
+        termSetting.c_cflag |= PARODD ;
+        break ;
+    case PARITY_NONE:
+        termSetting.c_cflag &= ~PARENB ;
+        break ;
+    default:
+        return false ;
+    }
+    return true ;
+}
+
+inline
+bool
+SerialStreamBuf::Implementation::ApplyFlowControl( struct termios&                       termSetting,
+                                                   const SerialStreamBuf::FlowControlEnum flowControlType )
+{
+    //
+    // Set the flow control. Hardware flow control uses the RTS (Ready
+    // To Send) and CTS (clear to Send) lines. Software flow control
+    // uses IXON|IXOFF
+    //
+    if ( FLOW_CONTROL_HARD == flowControlType )
+    {
+        termSetting.c_iflag &= ~ (IXON|IXOFF) ;
+        termSetting.c_cflag |= CRTSCTS ;
+        termSetting.c_cc[VSTART] = _POSIX_VDISABLE ;
+        termSetting.c_cc[VSTOP] = _POSIX_VDISABLE ;
+    }
+    else if ( FLOW_CONTROL_SOFT == flowControlType )
+    {
+        termSetting.c_iflag |= IXON|IXOFF ;
+        termSetting.c_cflag &= ~CRTSCTS ;
+        termSetting.c_cc[VSTART] = CTRL_Q ; // 0x11 (021) ^q
+        termSetting.c_cc[VSTOP]  = CTRL_S ; // 0x13 (023) ^s
+    }
+    else
+    {
+        termSetting.c_iflag &= ~(IXON|IXOFF) ;
+        termSetting.c_cflag &= ~CRTSCTS ;
+    }
+    return true ;
+}
+
+inline
+int
+SerialStreamBuf::Implementation::InitializeSerialPort() 
+{
+    //
+    // If we do not have a valid file descriptor then return with
+    // failure.
+    //
+    if ( -1 == this->mFileDescriptor )
+    {
+        return -1 ;
+    }
+    //
+    // Use non-blocking mode while configuring the serial port. 
+    //
+    int flags = fcntl(this->mFileDescriptor, F_GETFL, 0) ;
+    if ( -1 == fcntl( this->mFileDescriptor, 
+                     F_SETFL, 
+                     flags | O_NONBLOCK ) )
+    {
+        return -1 ;
+    }
+    //
     // Flush out any garbage left behind in the buffers associated
     // with the port from any previous operations. 
     //
@@ -652,12 +1267,9 @@ SerialStreamBuf::Implementation::InitializeSerialPort()
     }
     //
     // Allow all further communications to happen in blocking 
-    // mode. 
+    // mode unless a read or write timeout has been set. 
     //
-    flags = fcntl(this->mFileDescriptor, F_GETFL, 0) ;
-    if ( -1 == fcntl( this->mFileDescriptor, 
-                      F_SETFL, 
-                      flags & ~O_NONBLOCK ) )
+    if ( -1 == this->ApplyBlockingMode() )
     {
         return -1 ;
     }
@@ -672,6 +1284,18 @@ inline
 SerialStreamBuf::BaudRateEnum
 SerialStreamBuf::Implementation::SetBaudRate( const SerialStreamBuf::BaudRateEnum baud_rate )
 {
+    if ( 0 != mSerialPort.get() )
+    {
+        try
+        {
+            mSerialPort->SetBaudRate( SerialPort::BaudRate( baud_rate ) ) ;
+        }
+        catch( const std::exception& )
+        {
+            return BAUD_INVALID ;
+        }
+        return this->BaudRate() ;
+    }
     if ( -1 == mFileDescriptor )
     {
         return BAUD_INVALID ;
@@ -700,20 +1324,16 @@ SerialStreamBuf::Implementation::SetBaudRate( const SerialStreamBuf::BaudRateEnu
         // Get the current terminal settings. 
         //
         struct termios term_setting ;
-        if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-        {
-            return BAUD_INVALID ;
-        }
+        term_setting = mTermSetting ;
         //
         // Modify the baud rate in the term_setting structure.
         //
-        cfsetispeed( &term_setting, baud_rate ) ;
-        cfsetospeed( &term_setting, baud_rate ) ;
+        ApplyBaudRate( term_setting, baud_rate ) ;
         //
         // Apply the modified termios structure to the serial 
         // port. 
         //
-        if ( -1 == tcsetattr(mFileDescriptor, TCSANOW, &term_setting) )
+        if ( -1 == this->WriteTermSetting( term_setting, TCSANOW ) )
         {
             return BAUD_INVALID ;
         }
@@ -743,6 +1363,17 @@ inline
 SerialStreamBuf::BaudRateEnum
 SerialStreamBuf::Implementation::BaudRate() const 
 {
+    if ( 0 != mSerialPort.get() )
+    {
+        try
+        {
+            return BaudRateEnum( mSerialPort->GetBaudRate() ) ;
+        }
+        catch( const std::exception& )
+        {
+            return BAUD_INVALID ;
+        }
+    }
     if ( -1 == mFileDescriptor )
     {
         return BAUD_INVALID ;
@@ -750,11 +1381,7 @@ SerialStreamBuf::Implementation::BaudRate() const
     //
     // Get the current terminal settings. 
     //
-    struct termios term_setting ;
-    if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-    {
-        return BAUD_INVALID ;
-    }
+    const struct termios& term_setting = mTermSetting ;
     //
     // Read the input and output baud rates. 
     //
@@ -822,6 +1449,18 @@ inline
 SerialStreamBuf::CharSizeEnum
 SerialStreamBuf::Implementation::SetCharSize(const SerialStreamBuf::CharSizeEnum char_size) 
 {
+    if ( 0 != mSerialPort.get() )
+    {
+        try
+        {
+            mSerialPort->SetCharSize( SerialPort::CharacterSize( char_size ) ) ;
+        }
+        catch( const std::exception& )
+        {
+            return CHAR_SIZE_INVALID ;
+        }
+        return this->CharSize() ;
+    }
     if ( -1 == mFileDescriptor )
     {
         return CHAR_SIZE_INVALID ;
@@ -837,35 +1476,15 @@ SerialStreamBuf::Implementation::SetCharSize(const SerialStreamBuf::CharSizeEnum
         // Get the current terminal settings. 
         //
         struct termios term_setting ;
-        if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-        {
-            return CHAR_SIZE_INVALID ;
-        }
+        term_setting = mTermSetting ;
         //
-        // Set the character size to the specified value. If the character
-        // size is not 8 then it is also important to set ISTRIP. Setting
-        // ISTRIP causes all but the 7 low-order bits to be set to
-        // zero. Otherwise they are set to unspecified values and may
-        // cause problems. At the same time, we should clear the ISTRIP
-        // flag when the character size is 8 otherwise the MSB will always
-        // be set to zero (ISTRIP does not check the character size
-        // setting; it just sets every bit above the low 7 bits to zero).
+        // Set the character size to the specified value.
         //
-        if ( char_size == CHAR_SIZE_8 )
-        {
-            term_setting.c_iflag &= ~ISTRIP ; // clear the ISTRIP flag.
-        }
-        else
-        {
-            term_setting.c_iflag |= ISTRIP ;  // set the ISTRIP flag.
-        }
-
-        term_setting.c_cflag &= ~CSIZE ;     // clear all the CSIZE bits.
-        term_setting.c_cflag |= char_size ;  // set the character size. 
+        ApplyCharSize( term_setting, char_size ) ;
         //
         // Set the new settings for the serial port. 
         //
-        if ( -1 == tcsetattr(mFileDescriptor, TCSANOW, &term_setting) )
+        if ( -1 == this->WriteTermSetting( term_setting, TCSANOW ) )
         {
             return CHAR_SIZE_INVALID ;
         } 
@@ -881,6 +1500,10 @@ inline
 SerialStreamBuf::CharSizeEnum
 SerialStreamBuf::Implementation::CharSize() const 
 {
+    if ( 0 != mSerialPort.get() )
+    {
+        return CharSizeEnum( mSerialPort->GetCharSize() ) ;
+    }
     if ( -1 == mFileDescriptor )
     {
         return CHAR_SIZE_INVALID ;
@@ -888,11 +1511,7 @@ SerialStreamBuf::Implementation::CharSize() const
     //
     // Get the current terminal settings. 
     //
-    struct termios term_setting ;
-    if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-    {
-        return CHAR_SIZE_INVALID ;
-    }
+    const struct termios& term_setting = mTermSetting ;
     //
     // Extract the character size from the terminal settings. 
     //
@@ -921,6 +1540,25 @@ inline
 short
 SerialStreamBuf::Implementation::SetNumOfStopBits(short stop_bits) 
 {
+    if ( 0 != mSerialPort.get() )
+    {
+        if ( ( 1 != stop_bits ) &&
+             ( 2 != stop_bits ) )
+        {
+            return 0 ;
+        }
+        try
+        {
+            mSerialPort->SetNumOfStopBits( ( 2 == stop_bits ) ?
+                                           SerialPort::STOP_BITS_2 :
+                                           SerialPort::STOP_BITS_1 ) ;
+        }
+        catch( const std::exception& )
+        {
+            return 0 ;
+        }
+        return this->NumOfStopBits() ;
+    }
     if ( -1 == mFileDescriptor )
     {
         return 0 ;
@@ -928,27 +1566,15 @@ SerialStreamBuf::Implementation::SetNumOfStopBits(short stop_bits)
     //
     // Get the current terminal settings. 
     //
-    struct termios term_setting ;
-    if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-    {
-        return 0 ;
-    }
-    switch ( stop_bits )
+    struct termios term_setting = mTermSetting ;
+    if ( ! ApplyNumOfStopBits( term_setting, stop_bits ) )
     {
-    case 1:
-        term_setting.c_cflag &= ~CSTOPB ;
-        break ;
-    case 2:
-        term_setting.c_cflag |= CSTOPB ;
-        break ;
-    default: 
         return 0 ;
-        break ;
     }
     //
     // Set the new settings for the serial port. 
     //
-    if ( -1 == tcsetattr(mFileDescriptor, TCSANOW, &term_setting) )
+    if ( -1 == this->WriteTermSetting( term_setting, TCSANOW ) )
     {
         return 0 ;
     } 
@@ -959,6 +1585,10 @@ inline
 short 
 SerialStreamBuf::Implementation::NumOfStopBits() const 
 {
+    if ( 0 != mSerialPort.get() )
+    {
+        return ( SerialPort::STOP_BITS_2 == mSerialPort->GetNumOfStopBits() ) ? 2 : 1 ;
+    }
     if ( -1 == mFileDescriptor )
     {
         return 0 ;
@@ -966,11 +1596,7 @@ SerialStreamBuf::Implementation::NumOfStopBits() const
     //
     // Get the current terminal settings. 
     //
-    struct termios term_setting ;
-    if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-    {
-        return 0 ;
-    }
+    const struct termios& term_setting = mTermSetting ;
     //
     // If CSTOPB is set then the number of stop bits is 2 otherwise it
     // is 1.
@@ -989,6 +1615,18 @@ inline
 SerialStreamBuf::ParityEnum
 SerialStreamBuf::Implementation::SetParity(const SerialStreamBuf::ParityEnum parity) 
 {
+    if ( 0 != mSerialPort.get() )
+    {
+        try
+        {
+            mSerialPort->SetParity( SerialPort::Parity( parity ) ) ;
+        }
+        catch( const std::exception& )
+        {
+            return PARITY_INVALID ;
+        }
+        return this->Parity() ;
+    }
     if ( -1 == mFileDescriptor )
     {
         return PARITY_INVALID ;
@@ -996,34 +1634,18 @@ SerialStreamBuf::Implementation::SetParity(const SerialStreamBuf::ParityEnum par
     //
     // Get the current terminal settings. 
     //
-    struct termios term_setting ;
-    if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-    {
-        return PARITY_INVALID ;
-    }
+    struct termios term_setting = mTermSetting ;
     //
     // Set the parity in the termios structure. 
     //
-    switch ( parity )
+    if ( ! ApplyParity( term_setting, parity ) )
     {
-    case PARITY_EVEN:
-        term_setting.c_cflag |= PARENB ;
-        term_setting.c_cflag &= ~PARODD ;
-        break ;
-    case PARITY_ODD:
-        term_setting.c_cflag |= PARENB ;
-        term_setting.c_cflag |= PARODD ;
-        break ;
-    case PARITY_NONE:
-        term_setting.c_cflag &= ~PARENB ;
-        break ;
-    default:
         return PARITY_INVALID ;
     }
     //
     // Write the settings back to the serial port. 
     //
-    if ( -1 == tcsetattr(mFileDescriptor, TCSANOW, &term_setting) )
+    if ( -1 == this->WriteTermSetting( term_setting, TCSANOW ) )
     {
         return PARITY_INVALID ;
     }
@@ -1036,6 +1658,10 @@ inline
 SerialStreamBuf::ParityEnum
 SerialStreamBuf::Implementation::Parity() const 
 {
+    if ( 0 != mSerialPort.get() )
+    {
+        return ParityEnum( mSerialPort->GetParity() ) ;
+    }
     if ( -1 == mFileDescriptor )
     {
         return PARITY_INVALID ;
@@ -1043,11 +1669,7 @@ SerialStreamBuf::Implementation::Parity() const
     //
     // Get the current terminal settings. 
     //
-    struct termios term_setting ;
-    if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-    {
-        return PARITY_INVALID ;
-    }
+    const struct termios& term_setting = mTermSetting ;
     //
     // Get the parity setting from the termios structure. 
     //
@@ -1073,6 +1695,10 @@ inline
 SerialStreamBuf::FlowControlEnum
 SerialStreamBuf::Implementation::FlowControl() const 
 {
+    if ( 0 != mSerialPort.get() )
+    {
+        return FlowControlEnum( mSerialPort->GetFlowControl() ) ;
+    }
     if ( -1 == mFileDescriptor )
     {
         return FLOW_CONTROL_INVALID ;
@@ -1080,11 +1706,7 @@ SerialStreamBuf::Implementation::FlowControl() const
     //
     // Get the current terminal settings.
     //
-    struct termios tset ;
-    if ( -1 == tcgetattr(mFileDescriptor, &tset) )
-    {
-        return FLOW_CONTROL_INVALID ;
-    }
+    const struct termios& tset = mTermSetting ;
     //
     // Check if IXON and IXOFF are set in c_iflag. If both are set and
     // VSTART and VSTOP are set to 0x11 (^Q) and 0x13 (^S) respectively,
@@ -1138,17 +1760,13 @@ SerialStreamBuf::Implementation::SetVMin( short vmin )
     //
     // Get the current terminal settings. 
     //
-    struct termios term_setting ;
-    if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-    {
-        return -1 ;
-    }
+    struct termios term_setting = mTermSetting ;
 
     term_setting.c_cc[VMIN] = (cc_t)vmin;
     //
     // Set the new settings for the serial port. 
     //
-    if ( -1 == tcsetattr(mFileDescriptor, TCSANOW, &term_setting) )
+    if ( -1 == this->WriteTermSetting( term_setting, TCSANOW ) )
     {
         return -1 ;
     } 
@@ -1173,17 +1791,13 @@ SerialStreamBuf::Implementation::SetVTime( short vtime )
     //
     // Get the current terminal settings. 
     //
-    struct termios term_setting ;
-    if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-    {
-        return -1 ;
-    }
+    struct termios term_setting = mTermSetting ;
 
     term_setting.c_cc[VTIME] = (cc_t)vtime;
     //
     // Set the new settings for the serial port. 
     //
-    if ( -1 == tcsetattr(mFileDescriptor, TCSANOW, &term_setting) )
+    if ( -1 == this->WriteTermSetting( term_setting, TCSANOW ) )
     {
         return -1 ;
     }
@@ -1202,199 +1816,597 @@ SerialStreamBuf::Implementation::VTime() const
     //
     // Get the current terminal settings. 
     //
-    struct termios term_setting ;
-    if ( -1 == tcgetattr(mFileDescriptor, &term_setting) )
-    {
-        return -1 ;
-    }
+    const struct termios& term_setting = mTermSetting ;
 
     return term_setting.c_cc[VTIME];
 }
 
 inline
 streamsize
-SerialStreamBuf::Implementation::xsgetn(char_type *s, streamsize n) 
+SerialStreamBuf::Implementation::Peek( char_type* s, streamsize n )
 {
-    //
-    // If mFileDescriptor is -1 then we do not have a valid serial port
-    // associated with this buffer. Hence, we cannot read any characters
-    // from the serial port. Similarly, if the parameter n is less than
-    // or equal to 0, then we do not need to do anything here.
-    // 
-    if ( (-1 == mFileDescriptor) ||
-        (n <= 0) )
+    if ( ( ! this->IsOpen() ) ||
+         (n <= 0) )
     {
         return 0 ;
     }
     //
-    // Try to read upto n characters in the array s.
-    //
-    ssize_t retval = -1;
+    // If the get area does not hold n characters yet, move the
+    // characters it holds to the beginning of a buffer that is large
+    // enough for n characters and read the rest from the serial port
+    // into the free space behind them.
     //
-    // If a putback character is available, then we need to read only
-    // n-1 character.
-    //
-    if ( mPutbackAvailable )
+    streamsize num_of_chars = mStreamBuf.egptr() - mStreamBuf.gptr() ;
+    if ( num_of_chars < n )
     {
+        char_type* buffer ;
+        streamsize buffer_size ;
+        if ( n <= mGetBufferSize )
+        {
+            std::memmove( mGetBuffer,
+                          mStreamBuf.gptr(),
+                          num_of_chars ) ;
+            buffer      = mGetBuffer ;
+            buffer_size = mGetBufferSize ;
+        }
+        else
+        {
+            std::string lookahead( mStreamBuf.gptr(),
+                                   mStreamBuf.egptr() ) ;
+            lookahead.resize( n ) ;
+            mLookahead.swap( lookahead ) ;
+            buffer      = &mLookahead[0] ;
+            buffer_size = n ;
+        }
         //
-        // Put the mPutbackChar at the beginning of the array,
-        // s. Increment retval to indicate that a character has been
-        // placed in s.
-        // 
-        // (Corrected Bug#2364846 by incrementing retval below)
-        //
-        s[0] = mPutbackChar ; 
-        ++retval ;
-        //
-        // The putback character is no longer available. 
-        //
-        mPutbackAvailable = false ;
-        //
-        // If we need to read more than one character, then call read()
-        // and try to read n-1 more characters and put them at location
-        // starting from &s[1].
+        // Stop if a read returns no data, e.g. because of VTIME or the
+        // read timeout.
         //
-        if ( n > 1 )
+        while( num_of_chars < n )
         {
-
-            retval = read(mFileDescriptor, &s[1], n-1) ;
-
-            //
-            // If read was successful, then we need to increment retval by
-            // one to indicate that the putback character was prepended to
-            // the array, s. If read failed then leave retval at -1. 
-            //
-            if ( retval != -1 )
+            const ssize_t retval = this->ReadPort( buffer + num_of_chars,
+                                                   buffer_size - num_of_chars ) ;
+            if ( retval <= 0 )
             {
-                retval ++ ;
+                break ;
             }
+            num_of_chars += retval ;
         }
+        mStreamBuf.setg( buffer,
+                         buffer,
+                         buffer + num_of_chars ) ;
     }
-    else
+    //
+    // Copy the characters without extracting them.
+    //
+    num_of_chars = std::min( n, num_of_chars ) ;
+    std::memcpy( s,
+                 mStreamBuf.gptr(),
+                 num_of_chars ) ;
+    return num_of_chars ;
+}
+
+inline
+void
+SerialStreamBuf::Implementation::setbuf(char_type *s, streamsize n)
+{
+    //
+    // Keep the characters that have not been extracted yet in
+    // mLookahead, because they may be stored in the buffer that is
+    // being replaced.
+    //
+    const bool has_chars = ( mStreamBuf.gptr() < mStreamBuf.egptr() ) ;
+    if ( has_chars )
+    {
+        std::string lookahead( mStreamBuf.gptr(),
+                               mStreamBuf.egptr() ) ;
+        mLookahead.swap( lookahead ) ;
+    }
+    if ( ( 0 != s ) &&
+         ( n > 0 ) )
+    {
+        mOwnedGetBuffer.clear() ;
+        mGetBuffer     = s ;
+        mGetBufferSize = n ;
+    }
+    else
     {
         //
-        // If no putback character is available then we try to read n
-        // characters.
+        // setbuf(0, 0) means unbuffered I/O, which uses a buffer of
+        // a single character.
         //
+        mGetBufferSize = std::max( n, static_cast<streamsize>( 1 ) ) ;
+        mOwnedGetBuffer.resize( mGetBufferSize ) ;
+        mGetBuffer = &mOwnedGetBuffer[0] ;
+    }
+    if ( has_chars )
+    {
+        mStreamBuf.setg( &mLookahead[0],
+                         &mLookahead[0],
+                         &mLookahead[0] + mLookahead.size() ) ;
+    }
+    else
+    {
+        this->ResetGetArea() ;
+    }
+    return ;
+}
 
-        retval = read(mFileDescriptor, s, n);
+inline
+void
+SerialStreamBuf::Implementation::ResetGetArea()
+{
+    mStreamBuf.setg( mGetBuffer,
+                     mGetBuffer,
+                     mGetBuffer ) ;
+    mLookahead.clear() ;
+    return ;
+}
 
+inline
+int
+SerialStreamBuf::Implementation::SetOutputBufferSize( streamsize size )
+{
+    if ( ( size < 0 ) ||
+         ( -1 == this->sync() ) )
+    {
+        return -1 ;
     }
-    // 
-    // If retval == -1 then the read call had an error, otherwise, if
-    // retval == 0 then we could not read the characters. In either
-    // case, we return 0 to indicate that no characters could be read
-    // from the serial port.
-    //
-    if ( ( -1 == retval ) ||
-         (  0 == retval ) )
+    std::vector<char_type>( size ).swap( mPutBuffer ) ;
+    this->SetPutArea( 0 ) ;
+    return 0 ;
+}
+
+inline
+void
+SerialStreamBuf::Implementation::SetAutoFlushChar( int_type autoFlushChar )
+{
+    mAutoFlushChar = autoFlushChar ;
+    this->SetPutArea( mStreamBuf.pptr() - mStreamBuf.pbase() ) ;
+    return ;
+}
+
+inline
+void
+SerialStreamBuf::Implementation::SetPutArea( streamsize numOfPendingChars )
+{
+    char_type* const buffer = mPutBuffer.empty() ? 0 : &mPutBuffer[0] ;
+    if ( traits_type::eq_int_type( mAutoFlushChar,
+                                   traits_type::eof() ) )
+    {
+        mStreamBuf.setp( buffer,
+                         buffer + mPutBuffer.size() ) ;
+    }
+    else
+    {
+        mStreamBuf.setp( buffer,
+                         buffer + numOfPendingChars ) ;
+    }
+    mStreamBuf.pbump( numOfPendingChars ) ;
+    return ;
+}
+
+inline
+void
+SerialStreamBuf::Implementation::RemovePendingChars( streamsize numOfChars )
+{
+    const streamsize num_of_pending_chars =
+        mStreamBuf.pptr() - mStreamBuf.pbase() - numOfChars ;
+    if ( ( numOfChars > 0 ) &&
+         ( num_of_pending_chars > 0 ) )
+    {
+        std::memmove( mStreamBuf.pbase(),
+                      mStreamBuf.pbase() + numOfChars,
+                      num_of_pending_chars ) ;
+    }
+    this->SetPutArea( num_of_pending_chars ) ;
+    return ;
+}
+
+inline
+int
+SerialStreamBuf::Implementation::sync()
+{
+    const streamsize num_of_pending_chars =
+        mStreamBuf.pptr() - mStreamBuf.pbase() ;
+    if ( 0 == num_of_pending_chars )
     {
         return 0 ;
     }
+    if ( ! this->IsOpen() )
+    {
+        return -1 ;
+    }
     //
-    // Return the number of characters actually read from the serial
-    // port.
+    // Keep the characters that could not be written, so that the next
+    // flush tries again.
     //
-    return retval ;
+    const streamsize num_of_written_chars =
+        this->WriteFully( mStreamBuf.pbase(),
+                          num_of_pending_chars,
+                          0,
+                          0 ) ;
+    this->RemovePendingChars( num_of_written_chars ) ;
+    if ( num_of_written_chars < num_of_pending_chars )
+    {
+        return -1 ;
+    }
+    return 0 ;
 }
 
 inline
-std::streamsize
-SerialStreamBuf::Implementation::showmanyc() 
+int
+SerialStreamBuf::Implementation::SetTimeouts( unsigned int readTimeout,
+                                              unsigned int writeTimeout )
 {
-    ssize_t retval = -1 ;
-
+    mReadTimeout  = readTimeout ;
+    mWriteTimeout = writeTimeout ;
+    //
+    // The timeouts are kept while the serial port is closed and applied
+    // when it is opened.
+    //
     if ( -1 == mFileDescriptor )
     {
-        return -1 ;
+        return 0 ;
     }
+    return this->ApplyBlockingMode() ;
+}
 
-    if ( mPutbackAvailable )
+inline
+int
+SerialStreamBuf::Implementation::ApplyBlockingMode()
+{
+    const int flags = fcntl( mFileDescriptor, F_GETFL, 0 ) ;
+    if ( -1 == flags )
     {
-        // We still have a character left in the buffer.
-        retval = 1 ;
+        return -1 ;
     }
-    else
+    int new_flags = flags & ~O_NONBLOCK ;
+    if ( ( 0 != mReadTimeout ) ||
+         ( 0 != mWriteTimeout ) )
     {
-        // Switch to non-blocking read.
-        int flags = fcntl(this->mFileDescriptor, F_GETFL, 0) ;
-        if ( -1 == fcntl( this->mFileDescriptor, 
-                         F_SETFL, 
-                         flags | O_NONBLOCK ) )
+        new_flags |= O_NONBLOCK ;
+    }
+    if ( ( new_flags != flags ) &&
+         ( -1 == fcntl( mFileDescriptor,
+                        F_SETFL,
+                        new_flags ) ) )
+    {
+        return -1 ;
+    }
+    return 0 ;
+}
+
+inline
+int
+SerialStreamBuf::Implementation::WaitForPort( short        events,
+                                              unsigned int msTimeout )
+{
+    struct pollfd port_fd ;
+    port_fd.fd      = mFileDescriptor ;
+    port_fd.events  = events ;
+    port_fd.revents = 0 ;
+    const int poll_timeout =
+        ( 0 == msTimeout ) ? -1 :
+        static_cast<int>( std::min( msTimeout,
+                                    static_cast<unsigned int>( INT_MAX ) ) ) ;
+    int retval ;
+    do
+    {
+        retval = poll( &port_fd,
+                       1,
+                       poll_timeout ) ;
+    } while( ( -1 == retval ) &&
+             ( EINTR == errno ) ) ;
+    return retval ;
+}
+
+inline
+ssize_t
+SerialStreamBuf::Implementation::ReadPort( char_type* buffer,
+                                           streamsize size )
+{
+    mIsTimedOut = false ;
+    //
+    // Copy as much of the input buffer of the SerialPort object as
+    // fits, waiting for at least one character. 
+    //
+    if ( 0 != mSerialPort.get() )
+    {
+        try
+        {
+            SerialPort::ReadableRegion regions[2] ;
+            mSerialPort->AcquireReadable( regions,
+                                          1,
+                                          mReadTimeout ) ;
+            streamsize num_of_chars = 0 ;
+            for( int i=0; i<2; ++i )
+            {
+                const streamsize num_of_region_chars =
+                    std::min( size - num_of_chars,
+                              static_cast<streamsize>( regions[i].size ) ) ;
+                std::memcpy( buffer + num_of_chars,
+                             regions[i].data,
+                             num_of_region_chars ) ;
+                num_of_chars += num_of_region_chars ;
+            }
+            mSerialPort->CommitReadable( num_of_chars ) ;
+            return num_of_chars ;
+        }
+        catch( const SerialPort::ReadTimeout& )
         {
+            mIsTimedOut = true ;
             return -1 ;
         }
-
-        // Try to read a character.
-        retval = read(mFileDescriptor, &mPutbackChar, 1);
-
-        if ( retval == 1 )
+        catch( const std::exception& )
         {
-            mPutbackAvailable = true;
+            return -1 ;
         }
-        else
+    }
+    //
+    // In non-blocking mode, try to read first and only wait if no data
+    // is available, so that buffered input costs a single read(). 
+    //
+    while( true )
+    {
+        const ssize_t retval = read( mFileDescriptor,
+                                     buffer,
+                                     size ) ;
+        if ( ( retval >= 0 ) ||
+             ( EAGAIN != errno ) )
         {
-            retval = 0 ;
+            return retval ;
         }
-
-        // Switch back to blocking read.
-        if ( -1 == fcntl( this->mFileDescriptor, 
-                         F_SETFL, 
-                         flags ) )
+        const int wait_result = this->WaitForPort( POLLIN,
+                                                   mReadTimeout ) ;
+        if ( wait_result <= 0 )
         {
+            mIsTimedOut = ( 0 == wait_result ) ;
             return -1 ;
         }
     }
-
-    return retval;    
 }
 
 inline
-streambuf::int_type
-SerialStreamBuf::Implementation::underflow() 
+streamsize
+SerialStreamBuf::Implementation::ReadBlock( char_type*   s,
+                                            streamsize   n,
+                                            unsigned int msTimeout )
 {
+    if ( ( ! this->IsOpen() ) ||
+         (n <= 0) )
+    {
+        return 0 ;
+    }
     //
-    // If we do not have a valid file handler for the serial port, we
-    // cannot do much.
+    // Hand out the characters in the get area first.
     //
-    if ( -1 == mFileDescriptor )
+    streamsize num_of_chars = std::min( n,
+                                        static_cast<streamsize>( mStreamBuf.egptr() -
+                                                                 mStreamBuf.gptr() ) ) ;
+    std::memcpy( s,
+                 mStreamBuf.gptr(),
+                 num_of_chars ) ;
+    mStreamBuf.gbump( num_of_chars ) ;
+    mIsTimedOut = false ;
+    if ( 0 != mSerialPort.get() )
     {
-        return traits_type::eof() ;
+        const size_t num_of_requested_chars = n - num_of_chars ;
+        try
+        {
+            const size_t num_of_read_chars =
+                mSerialPort->Read( reinterpret_cast<unsigned char*>( s + num_of_chars ),
+                                   num_of_requested_chars,
+                                   ( 0 != msTimeout ) ? msTimeout : mReadTimeout ) ;
+            num_of_chars += num_of_read_chars ;
+            mIsTimedOut = ( num_of_read_chars < num_of_requested_chars ) ;
+        }
+        catch( const std::exception& )
+        {
+            /* Return the characters from the get area. */
+        }
+        return num_of_chars ;
     }
     //
-    // Read the next character from the serial port. 
+    // Read the rest straight into s. With a timeout, wait for data
+    // with poll() until the deadline so that read() does not block.
     //
-    char next_ch ;
-    ssize_t retval = -1;
+    struct timespec deadline ;
+    clock_gettime( CLOCK_MONOTONIC, &deadline ) ;
+    deadline.tv_sec  += msTimeout / 1000 ;
+    deadline.tv_nsec += ( msTimeout % 1000 ) * 1000000L ;
+    while( num_of_chars < n )
+    {
+        if ( 0 != msTimeout )
+        {
+            struct timespec now ;
+            clock_gettime( CLOCK_MONOTONIC, &now ) ;
+            const long long ns_left =
+                ( deadline.tv_sec - now.tv_sec ) * 1000000000LL +
+                ( deadline.tv_nsec - now.tv_nsec ) ;
+            const int wait_result =
+                ( ns_left <= 0 ) ? 0 :
+                this->WaitForPort( POLLIN,
+                                   static_cast<unsigned int>( ( ns_left + 999999 ) / 1000000 ) ) ;
+            if ( wait_result <= 0 )
+            {
+                mIsTimedOut = ( 0 == wait_result ) ;
+                break ;
+            }
+        }
+        const ssize_t retval = this->ReadPort( s + num_of_chars,
+                                               n - num_of_chars ) ;
+        if ( retval <= 0 )
+        {
+            break ;
+        }
+        num_of_chars += retval ;
+    }
+    return num_of_chars ;
+}
+
+inline
+streamsize
+SerialStreamBuf::Implementation::WriteBlock( const char_type* s,
+                                             streamsize       n )
+{
+    if ( ( ! this->IsOpen() ) ||
+         (n <= 0) )
+    {
+        return 0 ;
+    }
     //
-    // If a putback character is available then we return that
-    // character. However, we are not supposed to change the value of
-    // gptr() in this routine so we leave mPutbackAvailable set to true.
+    // Write the buffered characters and s with the same writev() calls
+    // and keep the buffered characters that could not be written.
+    //
+    const streamsize num_of_pending_chars =
+        mStreamBuf.pptr() - mStreamBuf.pbase() ;
+    const streamsize num_of_written_chars =
+        this->WriteFully( mStreamBuf.pbase(),
+                          num_of_pending_chars,
+                          s,
+                          n ) ;
+    const streamsize num_of_written_pending_chars =
+        std::min( num_of_written_chars, num_of_pending_chars ) ;
+    this->RemovePendingChars( num_of_written_pending_chars ) ;
+    return num_of_written_chars - num_of_written_pending_chars ;
+}
+
+inline
+streamsize
+SerialStreamBuf::Implementation::xsgetn(char_type *s, streamsize n) 
+{
+    //
+    // If mFileDescriptor is -1 then we do not have a valid serial port
+    // associated with this buffer. Hence, we cannot read any characters
+    // from the serial port. Similarly, if the parameter n is less than
+    // or equal to 0, then we do not need to do anything here.
     // 
-    if ( mPutbackAvailable )
+    if ( ( ! this->IsOpen() ) ||
+        (n <= 0) )
     {
-        next_ch = mPutbackChar ;
+        return 0 ;
     }
-    else
+    //
+    // Hand out the characters in the get area first.
+    //
+    streamsize num_of_chars = std::min( n,
+                                        static_cast<streamsize>( mStreamBuf.egptr() -
+                                                                 mStreamBuf.gptr() ) ) ;
+    std::memcpy( s,
+                 mStreamBuf.gptr(),
+                 num_of_chars ) ;
+    mStreamBuf.gbump( num_of_chars ) ;
+    if ( num_of_chars == n )
     {
+        return n ;
+    }
+    //
+    // Read large requests straight into s. Smaller ones are read
+    // through the get area so that the characters beyond the request
+    // are kept for the next call.
+    //
+    if ( n - num_of_chars >= mGetBufferSize )
+    {
+        const ssize_t retval = this->ReadPort( s + num_of_chars,
+                                               n - num_of_chars ) ;
+        // 
+        // If retval == -1 then the read call had an error, otherwise,
+        // if retval == 0 then we could not read the characters. In
+        // either case, only the buffered characters were returned.
         //
-        // If no putback character is available then we need to read one
-        // character from the serial port.
-        //
-        retval = read(mFileDescriptor, &next_ch, 1);
+        if ( retval > 0 )
+        {
+            num_of_chars += retval ;
+        }
+    }
+    else if ( ! traits_type::eq_int_type( this->underflow(),
+                                          traits_type::eof() ) )
+    {
+        const streamsize num_of_buffered_chars =
+            std::min( n - num_of_chars,
+                      static_cast<streamsize>( mStreamBuf.egptr() -
+                                               mStreamBuf.gptr() ) ) ;
+        std::memcpy( s + num_of_chars,
+                     mStreamBuf.gptr(),
+                     num_of_buffered_chars ) ;
+        mStreamBuf.gbump( num_of_buffered_chars ) ;
+        num_of_chars += num_of_buffered_chars ;
+    }
+    //
+    // Return the number of characters actually returned in s.
+    //
+    return num_of_chars ;
+}
 
+inline
+std::streamsize
+SerialStreamBuf::Implementation::showmanyc() 
+{
+    if ( ! this->IsOpen() )
+    {
+        return -1 ;
+    }
+    //
+    // Add the number of characters that the driver has received but
+    // not handed out yet to the characters left in the get area. This
+    // neither reads any characters nor changes the file status flags.
+    //
+    std::streamsize num_of_chars = mStreamBuf.egptr() - mStreamBuf.gptr() ;
+    if ( 0 != mSerialPort.get() )
+    {
         //
-        // Make the next character the putback character. This has the
-        // effect of returning the next character without changing gptr()
-        // as required by the C++ standard.
+        // Count the characters in the input buffer of the SerialPort
+        // object without removing them.
         //
-        if ( retval == 1 )
+        try
         {
-            mPutbackChar = next_ch ;
-            mPutbackAvailable = true ;
+            if ( mSerialPort->IsDataAvailable() )
+            {
+                SerialPort::ReadableRegion regions[2] ;
+                num_of_chars += mSerialPort->AcquireReadable( regions ) ;
+                mSerialPort->CommitReadable( 0 ) ;
+            }
         }
-        else if ( ( -1 == retval ) ||
-                  (  0 == retval ) )
+        catch( const std::exception& )
+        {
+            /* Only report the characters in the get area. */
+        }
+        return num_of_chars ;
+    }
+    int num_of_pending_chars = 0 ;
+    if ( -1 != ioctl( mFileDescriptor,
+                      FIONREAD,
+                      &num_of_pending_chars ) )
+    {
+        num_of_chars += num_of_pending_chars ;
+    }
+    return num_of_chars ;
+}
+
+inline
+streambuf::int_type
+SerialStreamBuf::Implementation::underflow() 
+{
+    //
+    // If we do not have a valid file handler for the serial port, we
+    // cannot do much.
+    //
+    if ( ! this->IsOpen() )
+    {
+        return traits_type::eof() ;
+    }
+    //
+    // If the get area is empty, refill it with as many characters as a
+    // single read() returns. The first character stays in the get area.
+    // This has the effect of returning the next character without
+    // changing gptr() as required by the C++ standard.
+    //
+    if ( mStreamBuf.gptr() == mStreamBuf.egptr() )
+    {
+        this->ResetGetArea() ;
+        ssize_t retval = this->ReadPort( mGetBuffer, mGetBufferSize ) ;
+        if ( retval <= 0 )
         {
             //
             // If we had a problem reading the character, we return
@@ -1402,17 +2414,15 @@ SerialStreamBuf::Implementation::underflow()
             //
             return traits_type::eof() ;
         }
+        mStreamBuf.setg( mGetBuffer,
+                         mGetBuffer,
+                         mGetBuffer + retval ) ;
     }
     //
-    // :NOTE: Wed Aug  9 21:26:51 2000 Pagey
-    // The value of mPutbackAvailable is always true when the code
-    // reaches here.
-    //
-    //
     // Return the character as an int value as required by the C++
     // standard.
     //
-    return traits_type::to_int_type(next_ch) ;
+    return traits_type::to_int_type( *mStreamBuf.gptr() ) ;
 }
 
 inline
@@ -1422,19 +2432,11 @@ SerialStreamBuf::Implementation::pbackfail(int_type c)
     //
     // If we do not have a valid file descriptor, then we return eof. 
     //
-    if ( -1 == mFileDescriptor )
-    {
-        return traits_type::eof() ;
-    }
-    //
-    // If a putback character is already available, then we cannot
-    // do any more putback and hence need to return eof.
-    //
-    if ( mPutbackAvailable )
+    if ( ! this->IsOpen() )
     {
         return traits_type::eof() ;
     }
-    else if ( traits_type::eq_int_type(c, traits_type::eof()) )
+    if ( traits_type::eq_int_type(c, traits_type::eof()) )
     {
         //
         // If an eof character is passed in, then we are required to
@@ -1443,16 +2445,28 @@ SerialStreamBuf::Implementation::pbackfail(int_type c)
         //
         return traits_type::eof() ;
     }
+    //
+    // Otherwise, make c the next character to be extracted and return
+    // it. If the character in front of gptr() is a different one,
+    // overwrite it. At the beginning of the get area, move the get area
+    // to mLookahead with c in front.
+    //
+    if ( mStreamBuf.eback() < mStreamBuf.gptr() )
+    {
+        mStreamBuf.gbump( -1 ) ;
+        *mStreamBuf.gptr() = traits_type::to_char_type(c) ;
+    }
     else
     {
-        //
-        // If no putback character is available at present, then make
-        // c the putback character and return it. 
-        //
-        mPutbackChar = traits_type::to_char_type(c) ;
-        mPutbackAvailable = true ;
-        return traits_type::not_eof(c) ;
+        std::string lookahead( 1, traits_type::to_char_type(c) ) ;
+        lookahead.append( mStreamBuf.gptr(),
+                          mStreamBuf.egptr() ) ;
+        mLookahead.swap( lookahead ) ;
+        mStreamBuf.setg( &mLookahead[0],
+                         &mLookahead[0],
+                         &mLookahead[0] + mLookahead.size() ) ;
     }
+    return traits_type::not_eof(c) ;
 }
 
 inline
@@ -1464,27 +2478,70 @@ SerialStreamBuf::Implementation::xsputn(const char_type *s, streamsize n)
     // here. Similarly if n is non-positive then we have nothing to do
     // here.
     //
-    if ( (-1 == mFileDescriptor) ||
+    if ( ( ! this->IsOpen() ) ||
          (n <= 0) )
     {
         return 0 ;
     }
+    const streamsize num_of_pending_chars =
+        mStreamBuf.pptr() - mStreamBuf.pbase() ;
     //
-    // Write the n characters to the serial port. 
-    //
-    ssize_t retval = write(mFileDescriptor, s, n) ;
-    //
-    // If the write failed then return 0. 
+    // The characters up to and including the last auto-flush character
+    // have to be written now. If the characters do not fit into the put
+    // area, all of them are written together with the buffered ones
+    // instead of being copied first.
     //
-    if ( (-1 == retval) ||
-         ( 0 == retval) )
+    streamsize num_of_chars_to_write = 0 ;
+    if ( num_of_pending_chars + n > static_cast<streamsize>( mPutBuffer.size() ) )
     {
-        return 0 ;
+        num_of_chars_to_write = n ;
+    }
+    else if ( ! traits_type::eq_int_type( mAutoFlushChar,
+                                          traits_type::eof() ) )
+    {
+        const char_type auto_flush_char =
+            traits_type::to_char_type( mAutoFlushChar ) ;
+        for( streamsize i = n; i > 0; --i )
+        {
+            if ( traits_type::eq( s[i - 1], auto_flush_char ) )
+            {
+                num_of_chars_to_write = i ;
+                break ;
+            }
+        }
+    }
+    if ( num_of_chars_to_write > 0 )
+    {
+        const streamsize num_of_written_chars =
+            this->WriteFully( mStreamBuf.pbase(),
+                              num_of_pending_chars,
+                              s,
+                              num_of_chars_to_write ) ;
+        const streamsize num_of_written_pending_chars =
+            std::min( num_of_written_chars, num_of_pending_chars ) ;
+        this->RemovePendingChars( num_of_written_pending_chars ) ;
+        //
+        // If the write failed, report how many of the characters in s
+        // have been written. The remaining buffered characters are kept.
+        //
+        if ( num_of_written_chars < num_of_pending_chars + num_of_chars_to_write )
+        {
+            return num_of_written_chars - num_of_written_pending_chars ;
+        }
     }
     //
-    // Otherwise, return the number of bytes actually written. 
+    // Append the remaining characters to the put area. 
     //
-    return retval ;
+    if ( num_of_chars_to_write < n )
+    {
+        const streamsize num_of_chars_in_buffer =
+            mStreamBuf.pptr() - mStreamBuf.pbase() ;
+        std::memcpy( &mPutBuffer[0] + num_of_chars_in_buffer,
+                     s + num_of_chars_to_write,
+                     n - num_of_chars_to_write ) ;
+        this->SetPutArea( num_of_chars_in_buffer + n - num_of_chars_to_write ) ;
+    }
+    return n ;
 }
 
 inline
@@ -1495,39 +2552,144 @@ SerialStreamBuf::Implementation::overflow(int_type c)
     // If we do not have a valid file descriptor then we cannot do much
     // here.
     //
-    if ( -1 == mFileDescriptor )
+    if ( ! this->IsOpen() )
     {
         return traits_type::eof() ;
     }
     //
-    // Try to write the specified character to the serial port. 
+    // If c is the eof character then we only write the put area. 
     //
     if ( traits_type::eq_int_type( c, traits_type::eof()) )
     {
-        //
-        // If c is the eof character then we do nothing. 
-        //
-        return traits_type::eof() ;
+        if ( -1 == this->sync() )
+        {
+            return traits_type::eof() ;
+        }
+        return traits_type::not_eof(c) ;
     }
-    else
+    const char_type out_ch = traits_type::to_char_type(c) ;
+    //
+    // Without an output buffer, write the character to the serial port
+    // right away. 
+    //
+    if ( mPutBuffer.empty() )
     {
-        //
-        // Otherwise we write the character to the serial port. 
-        //
-        char out_ch = traits_type::to_char_type(c) ;
-        ssize_t retval = write(mFileDescriptor, &out_ch, 1) ;
-        //
-        // If the write failed then return eof. 
-        //
-        if ( (-1 == retval) ||
-             ( 0 == retval) )
+        if ( 1 != this->WriteFully( &out_ch, 1, 0, 0 ) )
         {
             return traits_type::eof() ;
         }
-        //
-        // Otherwise, return something other than eof().
-        //
         return traits_type::not_eof(c) ;
     }
-    assert( 0 == "The code should never reach here." ) ;
+    //
+    // Otherwise make room in the put area if it is full and append the
+    // character. The put area also ends at pptr() while an auto-flush
+    // character is set, in which case the characters are only written
+    // if c is that character.
+    //
+    streamsize num_of_pending_chars =
+        mStreamBuf.pptr() - mStreamBuf.pbase() ;
+    if ( num_of_pending_chars == static_cast<streamsize>( mPutBuffer.size() ) )
+    {
+        if ( -1 == this->sync() )
+        {
+            return traits_type::eof() ;
+        }
+        num_of_pending_chars = 0 ;
+    }
+    mPutBuffer[num_of_pending_chars] = out_ch ;
+    this->SetPutArea( num_of_pending_chars + 1 ) ;
+    if ( traits_type::eq_int_type( c, mAutoFlushChar ) &&
+         ( -1 == this->sync() ) )
+    {
+        return traits_type::eof() ;
+    }
+    return traits_type::not_eof(c) ;
+}
+
+inline
+streamsize
+SerialStreamBuf::Implementation::WriteFully( const char_type* head,
+                                             streamsize       headSize,
+                                             const char_type* tail,
+                                             streamsize       tailSize )
+{
+    streamsize num_of_chars = 0 ;
+    mIsTimedOut = false ;
+    //
+    // SerialPort::Write() continues short writes itself and returns
+    // fewer characters only if the timeout expired. 
+    //
+    if ( 0 != mSerialPort.get() )
+    {
+        try
+        {
+            if ( headSize > 0 )
+            {
+                num_of_chars = mSerialPort->Write( head,
+                                                   headSize,
+                                                   mWriteTimeout ) ;
+            }
+            if ( ( num_of_chars == headSize ) &&
+                 ( tailSize > 0 ) )
+            {
+                num_of_chars += mSerialPort->Write( tail,
+                                                    tailSize,
+                                                    mWriteTimeout ) ;
+            }
+            mIsTimedOut = ( num_of_chars < headSize + tailSize ) ;
+        }
+        catch( const std::exception& )
+        {
+            /* The characters that have not been written are kept. */
+        }
+        return num_of_chars ;
+    }
+    while( headSize + tailSize > 0 )
+    {
+        struct iovec iov[2] ;
+        iov[0].iov_base = const_cast<char_type*>( head ) ;
+        iov[0].iov_len  = headSize ;
+        iov[1].iov_base = const_cast<char_type*>( tail ) ;
+        iov[1].iov_len  = tailSize ;
+        const ssize_t retval = writev( mFileDescriptor,
+                                       iov,
+                                       2 ) ;
+        if ( retval < 0 )
+        {
+            if ( EINTR == errno )
+            {
+                continue ;
+            }
+            //
+            // In non-blocking mode, wait until the driver accepts more
+            // characters.
+            //
+            if ( EAGAIN == errno )
+            {
+                const int wait_result = this->WaitForPort( POLLOUT,
+                                                           mWriteTimeout ) ;
+                if ( wait_result > 0 )
+                {
+                    continue ;
+                }
+                mIsTimedOut = ( 0 == wait_result ) ;
+            }
+            break ;
+        }
+        if ( 0 == retval )
+        {
+            break ;
+        }
+        //
+        // Skip the characters that have been written. 
+        //
+        num_of_chars += retval ;
+        const streamsize num_of_head_chars = std::min( static_cast<streamsize>( retval ),
+                                                       headSize ) ;
+        head     += num_of_head_chars ;
+        headSize -= num_of_head_chars ;
+        tail     += retval - num_of_head_chars ;
+        tailSize -= retval - num_of_head_chars ;
+    }
+    return num_of_chars ;
 }
@@ -42,8 +42,17 @@ extern "C++"
          *        associated with the serial port and the standard filebuf
          *        does not provide access to it.
          *
-         *        At present, this class uses unbuffered I/O and all calls
-         *        to setbuf() will be ignored.
+         *        Input is buffered: each underflow() fills the get area
+         *        with a single read() call, so that characters are then
+         *        extracted without any system calls. The size of the
+         *        buffer can be changed with pubsetbuf(). Output is
+         *        buffered as well: characters are collected in the put
+         *        area and written with as few write() calls as possible
+         *        when the buffer is full, when the stream is flushed
+         *        (e.g. by std::flush or std::endl), or when the
+         *        character set with SetAutoFlushChar() is written. The
+         *        size of this buffer can be changed with
+         *        SetOutputBufferSize().
          *
          * @author $Author: crayzeewulf $ <A HREF="pagey@gnudom.org">Manish P. Pagey</A>
          * @version $Id: SerialStreamBuf.h,v 1.9 2005-10-17 00:19:12 crayzeewulf Exp $
@@ -160,6 +169,16 @@ extern "C++"
                 FLOW_CONTROL_INVALID //!< Invalid flow control setting. 
             } ;
 
+            /**
+             * @brief The ways in which the stream buffer can access the
+             *        serial port. See open().
+             */
+            enum IoEngine
+            {
+                IO_ENGINE_DIRECT,      //!< System calls on a file descriptor.
+                IO_ENGINE_SERIAL_PORT  //!< A SerialPort object.
+            } ;
+
             /* ------------------------------------------------------------
              * Public Static Members
              * ------------------------------------------------------------
@@ -220,6 +239,12 @@ extern "C++"
              */
             static const short DEFAULT_VTIME ;
 
+            /**
+             * @brief The default size of the buffers used for input and
+             *        output. See setbuf() and SetOutputBufferSize().
+             */
+            static const std::streamsize DEFAULT_BUFFER_SIZE ;
+
             /* -----------------------------------------------------------------
              * Constructors and Destructor
              * -----------------------------------------------------------------
@@ -288,17 +313,29 @@ extern "C++"
              *        </tr>
              *        </table>
              *
+             *        If ioEngine is IO_ENGINE_SERIAL_PORT, the serial port is
+             *        opened by a SerialPort object instead, which always
+             *        opens it for reading and writing. All settings, reads
+             *        and writes then go through that object, which drains
+             *        the input queue of the driver in the background as
+             *        data arrives, so the stream behaves like a SerialPort
+             *        under load. The input buffer of the SerialPort object
+             *        replaces VMIN and VTIME, which cannot be used in this
+             *        case, and SetReadTimeout() also limits ReadBlock()
+             *        calls without a timeout as a whole.
+             *
              * @return Returns <tt>this</tt> on success, a null pointer
              *         otherwise.
              */
             SerialStreamBuf* open( const std::string filename,
                                    std::ios_base::openmode mode =
-                                   std::ios_base::in | std::ios_base::out ) ;
+                                   std::ios_base::in | std::ios_base::out,
+                                   IoEngine ioEngine = IO_ENGINE_DIRECT ) ;
 
             /**
              * @brief If is_open() == false, returns a null pointer.
-             *        If a put area exists, calls overflow(EOF) to flush
-             *        characters. Finally it closes the file by calling 
+             *        Otherwise, writes the characters in the put area to
+             *        the serial port. Finally it closes the file by calling 
              *        <tt>std::close(mFileDescriptor)</tt> where
              *        mFileDescriptor is the value returned by the last call
              *        to Open().
@@ -315,16 +352,46 @@ extern "C++"
              *        <b>Postcondition</b>: is_open() == <tt>false<tt>
              *
              * @return Returns <tt>this</tt> on success, a null pointer
-             *         otherwise.
+             *         otherwise, including when the characters in the
+             *         put area could not be written.
              */
             SerialStreamBuf* close() ;
 
+            /**
+             * @brief Returns true if the serial port is open and was opened
+             *        with IO_ENGINE_SERIAL_PORT.
+             */
+            bool IsUsingSerialPort() const ;
+
             /**
              * @brief Initializes the serial communication parameters to their
              *        default values.
              */
             int SetParametersToDefault() ;
 
+            /**
+             * @brief Applies all of the specified serial communication
+             *        parameters with a single call to tcsetattr(). If any
+             *        of the values is invalid, none of them is applied.
+             * @param portSettings The new settings of the serial port.
+             * @param drain If true, the characters in the output buffer
+             *        are written first and the settings take effect after
+             *        all pending output has been transmitted.
+             * @return -1 on failure and some other value on success.
+             */
+            int SetPortSettings( const SerialPort::PortSettings& portSettings,
+                                 bool drain = false ) ;
+
+            /**
+             * @brief Reads the settings of the serial port from the
+             *        driver. The accessor methods such as BaudRate() use a
+             *        copy of the settings that is only updated when they
+             *        are changed through this object. Call this method if
+             *        the settings may have been changed by other means.
+             * @return -1 on failure and some other value on success.
+             */
+            int RefreshPortSettings() ;
+
             /**
              * @brief Sets the baud rate of the associated serial port unless 
              *        is_open() != true, then returns -1.
@@ -404,7 +471,8 @@ extern "C++"
              *        reads.
              * @note See VMIN in man termios(3).
              * @param vMin the number of minimum characters to be set.
-             * @return Returns the minimum number of charcters set.
+             * @return Returns the minimum number of charcters set, or -1
+             *         on failure, e.g. with IO_ENGINE_SERIAL_PORT.
              */
             short SetVMin( short vMin ) ;
 
@@ -421,7 +489,8 @@ extern "C++"
              *        deciseconds.
              * @param vtime The timeout value (in deciseconds) to be set.
              * @return Returns the character buffer timeout for non-canonical
-             *         reads in deciseconds.
+             *         reads in deciseconds, or -1 on failure, e.g. with
+             *         IO_ENGINE_SERIAL_PORT.
              */
             short SetVTime( short vtime ) ;
 
@@ -433,6 +502,137 @@ extern "C++"
              */
             short VTime() const;
 
+            /**
+             * @brief Copies up to n characters that have been received but
+             *        not extracted yet to s without extracting them, so
+             *        that a parser can look ahead before it consumes any
+             *        input. Characters are read from the serial port until
+             *        n characters are available. Each read follows the
+             *        VMIN and VTIME settings, so fewer characters are
+             *        returned if a read times out or fails.
+             * @param s The array to copy the characters to.
+             * @param n The number of characters to look at.
+             * @return Returns the number of characters copied to s.
+             */
+            std::streamsize Peek( char_type*      s,
+                                  std::streamsize n ) ;
+
+            /**
+             * @brief Sets the size of the buffer that holds the characters
+             *        written to the stream buffer until they are sent to
+             *        the serial port. The characters that are already in
+             *        the buffer are written first. A size of 0 makes every
+             *        output operation write its characters immediately.
+             * @param size The new size of the output buffer.
+             * @return -1 on failure and some other value on success. The
+             *         size is not changed if the buffered characters could
+             *         not be written or if size is negative.
+             */
+            int SetOutputBufferSize( std::streamsize size ) ;
+
+            /**
+             * @brief Returns the size of the output buffer.
+             */
+            std::streamsize OutputBufferSize() const ;
+
+            /**
+             * @brief Makes the stream buffer write its output to the serial
+             *        port every time the specified character is written,
+             *        e.g. the carriage return that terminates a modem
+             *        command, so that complete messages are sent without
+             *        explicitly flushing the stream. Pass traits_type::eof()
+             *        to turn this off, which is the default.
+             * @param autoFlushChar The character that triggers the flush.
+             */
+            void SetAutoFlushChar( int_type autoFlushChar ) ;
+
+            /**
+             * @brief Returns the character set with SetAutoFlushChar(), or
+             *        traits_type::eof() if there is none.
+             */
+            int_type AutoFlushChar() const ;
+
+            /**
+             * @brief Sets the time that a read from the serial port may
+             *        wait for data, e.g. to refill the get area. If no data
+             *        arrives within msTimeout milliseconds, the read fails,
+             *        so the stream sets its failbit (and eofbit), and
+             *        IsTimedOut() returns true. A value of 0, which is the
+             *        default, makes reads wait indefinitely.
+             *
+             *        While a read or a write timeout is set, the serial port
+             *        is used in non-blocking mode and waits are implemented
+             *        with poll(). Reads then return as soon as any data is
+             *        available, so the VMIN and VTIME settings have no
+             *        effect.
+             * @param msTimeout The timeout period in milliseconds.
+             * @return -1 on failure and some other value on success.
+             */
+            int SetReadTimeout( unsigned int msTimeout ) ;
+
+            /**
+             * @brief Returns the read timeout in milliseconds. See
+             *        SetReadTimeout().
+             */
+            unsigned int ReadTimeout() const ;
+
+            /**
+             * @brief Sets the time that a write to the serial port may
+             *        wait for the driver to accept more characters. If it
+             *        does not accept any within msTimeout milliseconds, the
+             *        characters that have not been written stay in the
+             *        output buffer, the stream sets its badbit, and
+             *        IsTimedOut() returns true. A value of 0, which is the
+             *        default, makes writes wait indefinitely. See also
+             *        SetReadTimeout().
+             * @param msTimeout The timeout period in milliseconds.
+             * @return -1 on failure and some other value on success.
+             */
+            int SetWriteTimeout( unsigned int msTimeout ) ;
+
+            /**
+             * @brief Returns the write timeout in milliseconds. See
+             *        SetWriteTimeout().
+             */
+            unsigned int WriteTimeout() const ;
+
+            /**
+             * @brief Returns true if the most recent read from or write to
+             *        the serial port failed because its timeout expired.
+             */
+            bool IsTimedOut() const ;
+
+            /**
+             * @brief Reads exactly n characters into s unless msTimeout
+             *        milliseconds pass first. Characters in the get area
+             *        are returned first, the rest is read from the serial
+             *        port straight into s. The timeout applies to the whole
+             *        request. If msTimeout is 0, it reads until a single
+             *        read from the serial port fails or returns no data,
+             *        e.g. because the read timeout or VTIME expired.
+             * @param s The array to read the characters into.
+             * @param n The number of characters to read.
+             * @param msTimeout The timeout period in milliseconds.
+             * @return Returns the number of characters read into s.
+             */
+            std::streamsize ReadBlock( char_type*      s,
+                                       std::streamsize n,
+                                       unsigned int    msTimeout = 0 ) ;
+
+            /**
+             * @brief Writes the characters in the output buffer followed by
+             *        the n characters at s to the serial port, without
+             *        copying s into the output buffer. Short writes are
+             *        continued until all characters are written, the write
+             *        timeout expires, or write() fails.
+             * @param s The characters to write.
+             * @param n The number of characters to write.
+             * @return Returns the number of characters of s that were
+             *         written.
+             */
+            std::streamsize WriteBlock( const char_type* s,
+                                        std::streamsize  n ) ;
+
             /**----------------------------------------------------------------
              * Operators
              * ----------------------------------------------------------------
@@ -473,16 +673,24 @@ extern "C++"
              *        subclass's notion of getting memory for the buffered
              *        characters. 
              *
-             *        In the case of SerialStreamBuffer, we want to keep using
-             *        unbuffered I/O. Hence, using this method has no effect at
-             *        present.
-             */
-            virtual std::streambuf* setbuf( char_type*, 
-                                            std::streamsize ) ;
+             *        SerialStreamBuf uses the specified buffer for input.
+             *        setbuf(0, n) with n > 0 makes it allocate a buffer of n
+             *        characters and setbuf(0, 0) makes every underflow()
+             *        read a single character. The buffer must stay valid
+             *        until it is replaced or the stream buffer is
+             *        destroyed. Characters that have been read but not
+             *        extracted yet are kept.
+             * @return Returns <tt>this</tt>.
+             */
+            virtual std::streambuf* setbuf( char_type*      s,
+                                            std::streamsize n ) ;
 
             /**
              * @brief Reads upto n characters from the serial port and returns
-             *        them through the character array located at s.
+             *        them through the character array located at s. Buffered
+             *        characters are returned first. At most one read() call
+             *        is made; requests that are smaller than the buffer are
+             *        read through the buffer.
              * @return Returns the number of characters actually read from the
              *         serial port. 
              */
@@ -492,7 +700,10 @@ extern "C++"
             /**
              * @brief Checks wether input is available on the port.
              *        If you call \c SerialStream::in_avail, this method will
-             *        be called to check for available input.
+             *        be called to check for available input. It returns the
+             *        number of characters in the get area plus the number of
+             *        characters received by the driver, as reported by
+             *        ioctl(FIONREAD), without reading any of them.
              *        \code
              *        while(serial_port.rdbuf()->in_avail() > 0)
              *        {
@@ -504,47 +715,61 @@ extern "C++"
         virtual std::streamsize showmanyc();
 
             /**
-             * @brief Reads and returns the next character from the associated
-             *        serial port if one otherwise returns traits::eof(). This
-             *        method is used for buffered I/O while uflow() is called
-             *        for unbuffered I/O.
+             * @brief Refills the get area with a single read() call if it
+             *        is empty and returns its first character without
+             *        extracting it. Returns traits::eof() if no character
+             *        could be read.
              * @return The next character from the serial port. 
              */
             virtual int_type underflow() ;
 
             /**
-             * @brief Reads and returns the next character from the associated
-             *        serial port if one otherwise returns traits::eof(). This
-             *        method is used for unbuffered I/O while underflow() is
-             *        called for unbuffered I/O.
+             * @brief Like underflow(), but also extracts the character.
              * @return Returns the next character from the serial port.  
              */
             virtual int_type   uflow() ;
 
             /**
-             * @brief This function is called when a putback of a character
-             *        fails. This must be implemented for unbuffered I/O as all
-             *        streambuf subclasses are required to provide putback of
-             *        at least one character.
-             * @return Returns ???
+             * @brief This function is called when a character cannot be put
+             *        back by just moving gptr() backwards, e.g. at the
+             *        beginning of the get area. Any number of characters can
+             *        be put back; they are extracted again before the data
+             *        that has not been extracted yet.
+             * @return Returns c on success and traits_type::eof() if c is
+             *         traits_type::eof() and gptr() cannot be moved back.
              */
             virtual int_type pbackfail(int_type c = traits_type::eof()) ;
 
             /**
-             * @brief Writes upto n characters from the character sequence at 
-             *        char s to the serial port associated with the buffer. 
+             * @brief Writes the characters in the put area to the serial
+             *        port. Called by std::flush and std::endl.
+             * @return Returns 0 on success and -1 if not all of the
+             *         characters could be written.
+             */
+            virtual int sync() ;
+
+            /**
+             * @brief Appends upto n characters from the character sequence
+             *        at s to the output buffer. If they do not fit, the
+             *        buffered characters and the whole sequence are
+             *        written to the serial port, retrying short writes
+             *        until all of them have been written or write() fails.
              *
-             * @return Returns the number of characters that were successfully
-             *         written to the serial port. 
+             * @return Returns the number of characters that were buffered
+             *         or written to the serial port.
              */
             virtual std::streamsize xsputn( const char_type* s, 
                                             std::streamsize  n ) ;
 
             /**
-             * @brief Writes the specified character to the associated serial
-             *        port.
-             * @param c The character to be written to the serial port.
-             * @return Returns the character. 
+             * @brief Writes the characters in the put area to the serial
+             *        port and then puts the specified character into the
+             *        empty put area. If there is no output buffer, the
+             *        character is written immediately.
+             * @param c The character to be written to the serial port, or
+             *        traits_type::eof() to only flush the put area.
+             * @return Returns traits_type::eof() on failure and some other
+             *         value on success.
              */
             virtual int_type overflow(int_type c) ;
 
@@ -3,14 +3,22 @@
  * @copyright LibSerial
  */
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <csignal>
+#include <cstring>
+#include <ctime>
 #include <string>
+#include <thread>
 #include <unistd.h>
 
 #include "gtest/gtest.h"
+#include <PosixSignalDispatcher.h>
+#include <RingBuffer.h>
 #include <SerialPort.h>
+#include <SerialReactor.h>
 #include <SerialStream.h>
 
 // Default Serial Port and Baud Rate.
@@ -260,79 +268,827 @@ protected:
         ASSERT_FALSE(serialStream.IsOpen());
     }
 
+    void testSerialStreamBufPeek()
+    {
+        serialStream.Open(TEST_SERIAL_PORT);
+        serialStream2.Open(TEST_SERIAL_PORT_2);
+
+        ASSERT_TRUE(serialStream.IsOpen());
+        ASSERT_TRUE(serialStream2.IsOpen());
+
+        SerialStreamBuf* streamBuf = dynamic_cast<SerialStreamBuf*>(serialStream2.rdbuf());
+        ASSERT_TRUE(streamBuf != 0);
+
+        serialStream << writeString << std::endl;
+
+        std::string lookahead(writeString.size(), '\0');
+        ASSERT_EQ(streamBuf->Peek(&lookahead[0], lookahead.size()),
+                  static_cast<std::streamsize>(writeString.size()));
+        ASSERT_EQ(lookahead, writeString);
+
+        getline(serialStream2, readString);
+        ASSERT_EQ(readString, writeString);
+
+        serialStream.Close();
+        serialStream2.Close();
+
+        ASSERT_FALSE(serialStream.IsOpen());
+        ASSERT_FALSE(serialStream2.IsOpen());
+    }
+
+    void testSerialStreamBufSetBuf()
+    {
+        serialStream.Open(TEST_SERIAL_PORT);
+        serialStream2.Open(TEST_SERIAL_PORT_2);
+
+        ASSERT_TRUE(serialStream.IsOpen());
+        ASSERT_TRUE(serialStream2.IsOpen());
+
+        char buffer[16];
+        ASSERT_EQ(serialStream2.rdbuf()->pubsetbuf(buffer, sizeof(buffer)),
+                  serialStream2.rdbuf());
+
+        serialStream << writeString << std::endl;
+        getline(serialStream2, readString);
+        ASSERT_EQ(readString, writeString);
+
+        ASSERT_EQ(serialStream2.rdbuf()->pubsetbuf(0, 0),
+                  serialStream2.rdbuf());
+
+        serialStream << writeString << std::endl;
+        getline(serialStream2, readString);
+        ASSERT_EQ(readString, writeString);
+
+        serialStream.Close();
+        serialStream2.Close();
+
+        ASSERT_FALSE(serialStream.IsOpen());
+        ASSERT_FALSE(serialStream2.IsOpen());
+    }
+
+    void testSerialStreamBufOutputBuffer()
+    {
+        serialStream.Open(TEST_SERIAL_PORT);
+        serialStream2.Open(TEST_SERIAL_PORT_2);
+
+        ASSERT_TRUE(serialStream.IsOpen());
+        ASSERT_TRUE(serialStream2.IsOpen());
+
+        SerialStreamBuf* streamBuf = dynamic_cast<SerialStreamBuf*>(serialStream.rdbuf());
+        ASSERT_TRUE(streamBuf != 0);
+        ASSERT_EQ(streamBuf->OutputBufferSize(),
+                  SerialStreamBuf::DEFAULT_BUFFER_SIZE);
+
+        serialStream << writeString << '\n' << std::flush;
+        getline(serialStream2, readString);
+        ASSERT_EQ(readString, writeString);
+
+        streamBuf->SetAutoFlushChar('\n');
+        ASSERT_EQ(streamBuf->AutoFlushChar(), '\n');
+
+        serialStream << writeString << '\n';
+        getline(serialStream2, readString);
+        ASSERT_EQ(readString, writeString);
+
+        serialStream << writeString.substr(0, 3) << 42 << '\n';
+        getline(serialStream2, readString);
+        ASSERT_EQ(readString, writeString.substr(0, 3) + "42");
+
+        streamBuf->SetAutoFlushChar(std::char_traits<char>::eof());
+
+        ASSERT_EQ(streamBuf->SetOutputBufferSize(4), 0);
+        ASSERT_EQ(streamBuf->OutputBufferSize(), 4);
+        ASSERT_EQ(streamBuf->SetOutputBufferSize(-1), -1);
+
+        serialStream << writeString << std::endl;
+        getline(serialStream2, readString);
+        ASSERT_EQ(readString, writeString);
+
+        ASSERT_EQ(streamBuf->SetOutputBufferSize(0), 0);
+
+        serialStream << writeString << '\n';
+        getline(serialStream2, readString);
+        ASSERT_EQ(readString, writeString);
+
+        serialStream.Close();
+        serialStream2.Close();
+
+        ASSERT_FALSE(serialStream.IsOpen());
+        ASSERT_FALSE(serialStream2.IsOpen());
+    }
+
+    void testSerialStreamBufInAvail()
+    {
+        serialStream.Open(TEST_SERIAL_PORT);
+        serialStream2.Open(TEST_SERIAL_PORT_2);
+
+        ASSERT_TRUE(serialStream.IsOpen());
+        ASSERT_TRUE(serialStream2.IsOpen());
+
+        ASSERT_EQ(serialStream2.rdbuf()->in_avail(), 0);
+
+        serialStream << writeString << std::endl;
+
+        // Wait until the whole line has arrived. Calling in_avail() must
+        // not extract any of the characters.
+        const std::streamsize lineSize = writeString.size() + 1;
+        std::streamsize numOfChars = 0;
+        for (int i = 0; (i < 1000) && (numOfChars < lineSize); ++i)
+        {
+            usleep(1000);
+            numOfChars = serialStream2.rdbuf()->in_avail();
+        }
+        ASSERT_EQ(numOfChars, lineSize);
+
+        getline(serialStream2, readString);
+        ASSERT_EQ(readString, writeString);
+        ASSERT_EQ(serialStream2.rdbuf()->in_avail(), 0);
+
+        serialStream.Close();
+        serialStream2.Close();
+
+        ASSERT_FALSE(serialStream.IsOpen());
+        ASSERT_FALSE(serialStream2.IsOpen());
+    }
+
+    void testSerialStreamReadWriteTimeout()
+    {
+        serialStream.Open(TEST_SERIAL_PORT);
+        serialStream2.Open(TEST_SERIAL_PORT_2);
+
+        ASSERT_TRUE(serialStream.IsOpen());
+        ASSERT_TRUE(serialStream2.IsOpen());
+
+        serialStream.SetWriteTimeout(100);
+        ASSERT_EQ(serialStream.WriteTimeout(), 100u);
+        serialStream2.SetReadTimeout(10);
+        ASSERT_EQ(serialStream2.ReadTimeout(), 10u);
+        ASSERT_FALSE(serialStream2.IsTimedOut());
+
+        // Nothing has been written, so the read times out.
+        getline(serialStream2, readString);
+        ASSERT_TRUE(serialStream2.fail());
+        ASSERT_TRUE(serialStream2.IsTimedOut());
+
+        serialStream2.clear();
+        serialStream << writeString << std::endl;
+        ASSERT_TRUE(serialStream.good());
+        ASSERT_FALSE(serialStream.IsTimedOut());
+
+        getline(serialStream2, readString);
+        ASSERT_TRUE(serialStream2.good());
+        ASSERT_FALSE(serialStream2.IsTimedOut());
+        ASSERT_EQ(readString, writeString);
+
+        serialStream2.SetReadTimeout(0);
+        ASSERT_EQ(serialStream2.ReadTimeout(), 0u);
+
+        serialStream.Close();
+        serialStream2.Close();
+
+        ASSERT_FALSE(serialStream.IsOpen());
+        ASSERT_FALSE(serialStream2.IsOpen());
+    }
+
+    void testSerialStreamReadWriteBlock()
+    {
+        serialStream.Open(TEST_SERIAL_PORT);
+        serialStream2.Open(TEST_SERIAL_PORT_2);
+
+        ASSERT_TRUE(serialStream.IsOpen());
+        ASSERT_TRUE(serialStream2.IsOpen());
+
+        const std::streamsize numOfChars = writeString.size();
+        std::string blockString(numOfChars, '\0');
+
+        ASSERT_EQ(serialStream.WriteBlock(writeString.data(), numOfChars),
+                  numOfChars);
+        ASSERT_EQ(serialStream2.ReadBlock(&blockString[0], numOfChars, 1000),
+                  numOfChars);
+        ASSERT_FALSE(serialStream2.IsTimedOut());
+        ASSERT_EQ(blockString, writeString);
+
+        // Buffered output is written first.
+        serialStream << writeString;
+        ASSERT_EQ(serialStream.WriteBlock(writeString.data(), numOfChars),
+                  numOfChars);
+
+        blockString.assign(2 * numOfChars, '\0');
+        ASSERT_EQ(serialStream2.ReadBlock(&blockString[0], 2 * numOfChars, 1000),
+                  2 * numOfChars);
+        ASSERT_EQ(blockString, writeString + writeString);
+
+        // Only the available characters are returned on timeout.
+        ASSERT_EQ(serialStream.WriteBlock(writeString.data(), numOfChars),
+                  numOfChars);
+        ASSERT_EQ(serialStream2.ReadBlock(&blockString[0], 2 * numOfChars, 50),
+                  numOfChars);
+        ASSERT_TRUE(serialStream2.IsTimedOut());
+        ASSERT_TRUE(serialStream2.good());
+
+        serialStream.Close();
+        serialStream2.Close();
+
+        ASSERT_FALSE(serialStream.IsOpen());
+        ASSERT_FALSE(serialStream2.IsOpen());
+    }
+
+    void testSerialStreamSerialPortEngine()
+    {
+        serialStream.Open(TEST_SERIAL_PORT,
+                          std::ios_base::in | std::ios_base::out,
+                          SerialStreamBuf::IO_ENGINE_SERIAL_PORT);
+        serialStream2.Open(TEST_SERIAL_PORT_2,
+                           std::ios_base::in | std::ios_base::out,
+                           SerialStreamBuf::IO_ENGINE_SERIAL_PORT);
+
+        ASSERT_TRUE(serialStream.IsOpen());
+        ASSERT_TRUE(serialStream2.IsOpen());
+
+        SerialStreamBuf* serialStreamBuf =
+            dynamic_cast<SerialStreamBuf*>(serialStream.rdbuf());
+        ASSERT_TRUE(serialStreamBuf->IsUsingSerialPort());
+
+        serialStream.SetBaudRate(SerialStreamBuf::BAUD_115200);
+        serialStream2.SetBaudRate(SerialStreamBuf::BAUD_115200);
+        ASSERT_EQ(serialStream.BaudRate(), SerialStreamBuf::BAUD_115200);
+
+        serialStream << writeString << std::endl;
+        getline(serialStream2, readString);
+        ASSERT_EQ(readString, writeString);
+
+        // Characters are received in the background until they are read.
+        const std::streamsize numOfChars = writeString.size();
+        std::string blockString(numOfChars, '\0');
+
+        ASSERT_EQ(serialStream.WriteBlock(writeString.data(), numOfChars),
+                  numOfChars);
+        ASSERT_EQ(serialStream2.ReadBlock(&blockString[0], numOfChars, 1000),
+                  numOfChars);
+        ASSERT_EQ(blockString, writeString);
+
+        serialStream2.SetReadTimeout(50);
+        getline(serialStream2, readString);
+        ASSERT_TRUE(serialStream2.fail());
+        ASSERT_TRUE(serialStream2.IsTimedOut());
+        serialStream2.clear();
+
+        // VMIN and VTIME are not used by the SerialPort engine.
+        ASSERT_EQ(serialStreamBuf->SetVMin(1), -1);
+
+        serialStream.Close();
+        serialStream2.Close();
+
+        ASSERT_FALSE(serialStream.IsOpen());
+        ASSERT_FALSE(serialStream2.IsOpen());
+    }
+
+
+    //----------------------- Serial Port Unit Tests ------------------------//
+
+    void testSerialPortOpenClose()
+    {
+        serialPort.Open();
+        ASSERT_TRUE(serialPort.IsOpen());
+
+        serialPort.Close();
+        ASSERT_FALSE(serialPort.IsOpen());
+    }
+
+    void testSerialPortOpenFailure()
+    {
+        // /dev/null opens but is not a terminal, so Open() fails after
+        // the port has been set up partly. Nothing may be left behind.
+        const int firstFreeFileDescriptor = dup(0);
+        close(firstFreeFileDescriptor);
+
+        SerialPort nonTerminal("/dev/null");
+        for (int i = 0; i < 2; i++)
+        {
+            ASSERT_THROW(nonTerminal.Open(), SerialPort::OpenFailed);
+            ASSERT_FALSE(nonTerminal.IsOpen());
+        }
+
+        const int nextFreeFileDescriptor = dup(0);
+        close(nextFreeFileDescriptor);
+        ASSERT_EQ(nextFreeFileDescriptor, firstFreeFileDescriptor);
+    }
+
+    void testSerialPortReadWrite()
+    {
+        serialPort.Open();
+        serialPort2.Open();
+        
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+
+        SerialPort::DataBuffer readDataBuffer;
+        SerialPort::DataBuffer writeDataBuffer;
+
+        // Test using ASCII characters.
+        for (size_t i = 48; i < 122; i++)
+        {
+            writeDataBuffer.push_back(i);
+        }
+
+        serialPort.Write(writeDataBuffer);
+        serialPort2.Read(readDataBuffer, 74, 5);
+        ASSERT_EQ(readDataBuffer, writeDataBuffer);
+
+        serialPort.Close();
+        serialPort2.Close();
+        
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+        
+        serialPort.Open();
+        serialPort2.Open();
+        
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+
+        serialPort.WriteByte((unsigned char)writeByte);
+        readByte = (char)serialPort2.ReadByte(5);
+        ASSERT_EQ(readByte, writeByte);
+        
+        serialPort.Close();
+        serialPort2.Close();
+        
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+        
+        serialPort.Open();
+        serialPort2.Open();
+        
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+        
+        serialPort.Write(writeString + '\n');
+        readString = serialPort2.ReadLine(5);
+        ASSERT_EQ(readString, writeString + '\n');
+        
+        serialPort.Close();
+        serialPort2.Close();
+        
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+    }
+
+    void testSerialPortIsDataAvailableTest()
+    {
+        serialPort.Open();
+        serialPort2.Open();
+
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+
+        ASSERT_FALSE(serialPort.IsDataAvailable());
+
+        serialPort.WriteByte((unsigned char)writeByte);
+        usleep(1); // @TODO - This should be replaced to a call to tcdrain();
+        ASSERT_TRUE(serialPort2.IsDataAvailable());
+
+        readByte = (char)serialPort2.ReadByte(1);
+        ASSERT_FALSE(serialPort2.IsDataAvailable());
+
+        serialPort.Close();
+        serialPort2.Close();
+        
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+    }
+
+    void testSerialPortReadWriteRawBuffer()
+    {
+        serialPort.Open();
+        serialPort2.Open();
+
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+
+        unsigned char readBuffer[128];
+
+        ASSERT_EQ(serialPort.Write(writeString.data(), writeString.size()),
+                  writeString.size());
+        ASSERT_EQ(serialPort2.Read(readBuffer, writeString.size(), 5),
+                  writeString.size());
+        ASSERT_EQ(std::string((char*)readBuffer, writeString.size()), writeString);
+
+        // A timeout results in a short read instead of an exception.
+        ASSERT_EQ(serialPort2.Read(readBuffer, sizeof(readBuffer), 5), 0u);
+
+        serialPort.Close();
+        serialPort2.Close();
+
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+    }
+
+    void testSerialPortReactor()
+    {
+        serialPort.Open();
+        serialPort2.Open();
+
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+
+        SerialReactor serialReactor(2);
+        ASSERT_EQ(serialReactor.GetNumOfThreads(), 2u);
+
+        serialReactor.Attach(serialPort);
+        serialReactor.Attach(serialPort2);
+        ASSERT_EQ(serialReactor.GetNumOfAttachedPorts(), 2u);
+        ASSERT_THROW(serialReactor.Attach(serialPort2), std::logic_error);
+
+        serialPort.Write(writeString + "\n");
+        ASSERT_EQ(serialPort2.ReadLine(25), writeString + "\n");
+        serialPort2.Write(writeString + "\n");
+        ASSERT_EQ(serialPort.ReadLine(25), writeString + "\n");
+
+        // A detached port receives its data through SIGIO again.
+        serialReactor.Detach(serialPort2);
+        ASSERT_EQ(serialReactor.GetNumOfAttachedPorts(), 1u);
+        ASSERT_THROW(serialReactor.Detach(serialPort2), std::logic_error);
+        serialPort.Write(writeString + "\n");
+        ASSERT_EQ(serialPort2.ReadLine(25), writeString + "\n");
+
+        // Closing an attached port detaches it.
+        serialPort.Close();
+        serialPort2.Close();
+        ASSERT_EQ(serialReactor.GetNumOfAttachedPorts(), 0u);
+
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+    }
+
+    void testSerialPortInputSignal()
+    {
+        ASSERT_EQ(serialPort.GetInputSignal(), SIGIO);
+        ASSERT_THROW(serialPort.SetInputSignal(SIGUSR1), std::invalid_argument);
+
+        serialPort.SetInputSignal(SIGRTMIN + 1);
+        serialPort2.SetInputSignal(SIGRTMIN + 1);
+        ASSERT_EQ(serialPort.GetInputSignal(), SIGRTMIN + 1);
+
+        serialPort.Open();
+        serialPort2.Open();
+
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+        ASSERT_THROW(serialPort.SetInputSignal(SIGIO), SerialPort::AlreadyOpen);
+
+        serialPort.Write(writeString + "\n");
+        ASSERT_EQ(serialPort2.ReadLine(25), writeString + "\n");
+        serialPort2.Write(writeString + "\n");
+        ASSERT_EQ(serialPort.ReadLine(25), writeString + "\n");
+
+        serialPort.Close();
+        serialPort2.Close();
+
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+    }
+
+    void testSerialPortDispatcherThread()
+    {
+        // EnableDispatcherThread() cannot be undone, so the test runs in
+        // a separate process and the other tests keep using the default
+        // SIGIO handler.
+        ::testing::GTEST_FLAG(death_test_style) = "threadsafe";
+        ASSERT_EXIT(runSerialPortDispatcherThread(),
+                    ::testing::ExitedWithCode(0),
+                    "");
+    }
+
+    void runSerialPortDispatcherThread()
+    {
+        checkSerialPortDispatcherThread();
+        std::exit(::testing::Test::HasFailure() ? 1 : 0);
+    }
+
+    void checkSerialPortDispatcherThread()
+    {
+        PosixSignalDispatcher& signalDispatcher = PosixSignalDispatcher::Instance();
+        signalDispatcher.EnableDispatcherThread(SIGIO);
+        ASSERT_TRUE(signalDispatcher.IsDispatcherThreadEnabled(SIGIO));
+        ASSERT_THROW(signalDispatcher.EnableDispatcherThread(-1), std::runtime_error);
+
+        serialPort.Open();
+        serialPort2.Open();
+
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+
+        serialPort.Write(writeString + "\n");
+        ASSERT_EQ(serialPort2.ReadLine(25), writeString + "\n");
+        serialPort2.Write(writeString + "\n");
+        ASSERT_EQ(serialPort.ReadLine(25), writeString + "\n");
+
+        serialPort.Close();
+        serialPort2.Close();
+
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+    }
+
+    void testSerialPortInputOverflowPolicy()
+    {
+        serialPort2.SetInputBufferCapacity(1000);
+        ASSERT_EQ(serialPort2.GetInputBufferCapacity(), 1024u);
+        ASSERT_THROW(serialPort2.SetInputBufferCapacity(0), std::invalid_argument);
+        ASSERT_THROW(serialPort2.SetInputBufferCapacity(~static_cast<size_t>(0)),
+                     std::invalid_argument);
+        ASSERT_THROW(serialPort2.SetInputBufferCapacity(static_cast<size_t>(1) << 62),
+                     std::invalid_argument);
+        ASSERT_EQ(serialPort2.GetInputBufferCapacity(), 1024u);
+
+        serialPort.Open();
+        serialPort2.Open();
+
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+        ASSERT_THROW(serialPort2.SetInputBufferCapacity(4096), SerialPort::AlreadyOpen);
+
+        // Keep only the newest 1024 bytes of 2048.
+        serialPort2.SetInputOverflowPolicy(SerialPort::INPUT_OVERFLOW_DROP_OLDEST);
+        ASSERT_EQ(serialPort2.GetInputOverflowPolicy(), SerialPort::INPUT_OVERFLOW_DROP_OLDEST);
+
+        SerialPort::DataBuffer writeDataBuffer(2048);
+        for (size_t i = 0; i < writeDataBuffer.size(); i++)
+        {
+            writeDataBuffer[i] = static_cast<unsigned char>(i);
+        }
+        serialPort.Write(writeDataBuffer);
+        usleep(250000);
+
+        ASSERT_EQ(serialPort2.GetNumOfDroppedInputBytes(), 1024u);
+        ASSERT_EQ(serialPort2.GetInputBufferHighWaterMark(), 1024u);
+
+        SerialPort::DataBuffer readDataBuffer;
+        serialPort2.Read(readDataBuffer, 0);
+        ASSERT_EQ(readDataBuffer, SerialPort::DataBuffer(writeDataBuffer.begin() + 1024,
+                                                         writeDataBuffer.end()));
+
+        serialPort2.ResetInputBufferCounters();
+        ASSERT_EQ(serialPort2.GetNumOfDroppedInputBytes(), 0u);
+
+        serialPort.Close();
+        serialPort2.Close();
+
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+    }
+
+    void testSerialPortStatistics()
+    {
+        serialPort.Open();
+        serialPort2.Open();
+
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+
+        SerialPort::Statistics statistics = serialPort2.GetStatistics();
+        ASSERT_EQ(statistics.numOfBytesReceived, 0u);
+        ASSERT_EQ(statistics.numOfReadTimeouts, 0u);
+
+        ASSERT_THROW(serialPort2.ReadByte(1), SerialPort::ReadTimeout);
+        serialPort.Write(writeString + "\n");
+        ASSERT_EQ(serialPort2.ReadLine(25), writeString + "\n");
 
-    //----------------------- Serial Port Unit Tests ------------------------//
+        statistics = serialPort.GetStatistics();
+        ASSERT_EQ(statistics.numOfBytesTransmitted, writeString.size() + 1);
+        ASSERT_GE(statistics.numOfWriteCalls, 1u);
 
-    void testSerialPortOpenClose()
+        statistics = serialPort2.GetStatistics();
+        ASSERT_EQ(statistics.numOfBytesReceived, writeString.size() + 1);
+        ASSERT_GE(statistics.numOfReadCalls, 1u);
+        ASSERT_GE(statistics.numOfInputSignals, 1u);
+        ASSERT_EQ(statistics.numOfReadTimeouts, 1u);
+
+        serialPort2.ResetStatistics();
+        statistics = serialPort2.GetStatistics();
+        ASSERT_EQ(statistics.numOfBytesReceived, 0u);
+        ASSERT_EQ(statistics.numOfReadTimeouts, 0u);
+
+        serialPort.Close();
+        serialPort2.Close();
+
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+    }
+
+    void testSerialPortInputLatencyHistogram()
     {
         serialPort.Open();
+        serialPort2.Open();
+
         ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+
+        ASSERT_FALSE(serialPort2.IsInputLatencyHistogramEnabled());
+        ASSERT_EQ(serialPort2.GetInputLatencyPercentile(50.0), 0);
+
+        serialPort2.EnableInputLatencyHistogram();
+        ASSERT_TRUE(serialPort2.IsInputLatencyHistogramEnabled());
+
+        for (int i = 0; i < 10; ++i)
+        {
+            serialPort.Write(writeString + "\n");
+            ASSERT_EQ(serialPort2.ReadLine(25), writeString + "\n");
+        }
+
+        ASSERT_GE(serialPort2.GetNumOfInputLatencySamples(), 1u);
+        ASSERT_GT(serialPort2.GetInputLatencyPercentile(50.0), 0);
+        ASSERT_LE(serialPort2.GetInputLatencyPercentile(50.0),
+                  serialPort2.GetInputLatencyPercentile(99.0));
+        ASSERT_LE(serialPort2.GetInputLatencyPercentile(99.0),
+                  serialPort2.GetInputLatencyPercentile(99.9));
+
+        serialPort2.ResetInputLatencyHistogram();
+        ASSERT_EQ(serialPort2.GetNumOfInputLatencySamples(), 0u);
+
+        serialPort2.DisableInputLatencyHistogram();
+        ASSERT_FALSE(serialPort2.IsInputLatencyHistogramEnabled());
 
         serialPort.Close();
+        serialPort2.Close();
+
         ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
     }
 
-    void testSerialPortReadWrite()
+    void testSerialPortReadWithTimestamps()
     {
         serialPort.Open();
         serialPort2.Open();
-        
+
         ASSERT_TRUE(serialPort.IsOpen());
         ASSERT_TRUE(serialPort2.IsOpen());
 
-        SerialPort::DataBuffer readDataBuffer;
-        SerialPort::DataBuffer writeDataBuffer;
+        SerialPort::DataBuffer dataBuffer;
+        SerialPort::ArrivalTimes arrivalTimes;
 
-        // Test using ASCII characters.
-        for (size_t i = 48; i < 122; i++)
+        // Let the first write arrive in its own chunk. The sleep is
+        // resumed when it is interrupted by the input signal.
+        serialPort.Write(writeString);
+        struct timespec delay = {0, 25000000};
+        while (nanosleep(&delay, &delay) != 0)
         {
-            writeDataBuffer.push_back(i);
         }
+        serialPort.Write(writeString);
 
-        serialPort.Write(writeDataBuffer);
-        serialPort2.Read(readDataBuffer, 74, 5);
-        ASSERT_EQ(readDataBuffer, writeDataBuffer);
+        serialPort2.ReadWithTimestamps(dataBuffer,
+                                       arrivalTimes,
+                                       2 * writeString.size(),
+                                       100);
+        ASSERT_EQ(dataBuffer.size(), 2 * writeString.size());
+        ASSERT_GE(arrivalTimes.size(), 2u);
+        ASSERT_EQ(arrivalTimes[0].offset, 0u);
+
+        for (size_t i = 1; i < arrivalTimes.size(); ++i)
+        {
+            ASSERT_GT(arrivalTimes[i].offset, arrivalTimes[i - 1].offset);
+            ASSERT_GT(arrivalTimes[i].timestamp, arrivalTimes[i - 1].timestamp);
+        }
+
+        ASSERT_LT(arrivalTimes.back().offset, dataBuffer.size());
+
+        ASSERT_THROW(serialPort2.ReadWithTimestamps(dataBuffer,
+                                                    arrivalTimes,
+                                                    1,
+                                                    1),
+                     SerialPort::ReadTimeout);
+        ASSERT_TRUE(dataBuffer.empty());
+        ASSERT_TRUE(arrivalTimes.empty());
 
         serialPort.Close();
         serialPort2.Close();
-        
+
         ASSERT_FALSE(serialPort.IsOpen());
         ASSERT_FALSE(serialPort2.IsOpen());
-        
+    }
+
+    void testSerialPortAcquireReadable()
+    {
         serialPort.Open();
         serialPort2.Open();
-        
+
         ASSERT_TRUE(serialPort.IsOpen());
         ASSERT_TRUE(serialPort2.IsOpen());
 
-        serialPort.WriteByte((unsigned char)writeByte);
-        readByte = (char)serialPort2.ReadByte(5);
-        ASSERT_EQ(readByte, writeByte);
-        
+        SerialPort::ReadableRegion regions[2];
+
+        ASSERT_THROW(serialPort2.CommitReadable(0), std::logic_error);
+        ASSERT_THROW(serialPort2.AcquireReadable(regions, 1, 1),
+                     SerialPort::ReadTimeout);
+
+        serialPort.Write(writeString + "\n");
+
+        const size_t numOfBytes = serialPort2.AcquireReadable(regions,
+                                                              writeString.size() + 1,
+                                                              25);
+        ASSERT_EQ(numOfBytes, writeString.size() + 1);
+        ASSERT_EQ(regions[0].size + regions[1].size, numOfBytes);
+
+        std::string data(reinterpret_cast<const char*>(regions[0].data), regions[0].size);
+        data.append(reinterpret_cast<const char*>(regions[1].data), regions[1].size);
+        ASSERT_EQ(data, writeString + "\n");
+
+        ASSERT_THROW(serialPort2.CommitReadable(numOfBytes + 1),
+                     std::invalid_argument);
+        ASSERT_THROW(serialPort2.AcquireReadable(regions, 1, 1),
+                     std::logic_error);
+
+        // Only the thread that acquired the data may commit it.
+        bool isCommitRejected = false;
+        std::thread otherThread([this, &isCommitRejected]()
+        {
+            try
+            {
+                serialPort2.CommitReadable(0);
+            }
+            catch (const std::logic_error&)
+            {
+                isCommitRejected = true;
+            }
+        });
+        otherThread.join();
+        ASSERT_TRUE(isCommitRejected);
+
+        serialPort2.CommitReadable(writeString.size());
+        ASSERT_EQ(serialPort2.ReadByte(25), '\n');
+
         serialPort.Close();
         serialPort2.Close();
-        
+
         ASSERT_FALSE(serialPort.IsOpen());
         ASSERT_FALSE(serialPort2.IsOpen());
-        
+    }
+
+    void testSerialPortPeek()
+    {
         serialPort.Open();
         serialPort2.Open();
-        
+
         ASSERT_TRUE(serialPort.IsOpen());
         ASSERT_TRUE(serialPort2.IsOpen());
-        
-        serialPort.Write(writeString + '\n');
+
+        SerialPort::DataBuffer dataBuffer;
+
+        ASSERT_THROW(serialPort2.Peek(dataBuffer, 1, 1), SerialPort::ReadTimeout);
+        ASSERT_TRUE(dataBuffer.empty());
+
+        serialPort.Write(writeString + "\n");
+
+        serialPort2.Peek(dataBuffer, writeString.size() + 1, 25);
+        ASSERT_EQ(std::string(dataBuffer.begin(), dataBuffer.end()), writeString + "\n");
+
+        serialPort2.Peek(dataBuffer, 1, 25);
+        ASSERT_EQ(dataBuffer.size(), 1u);
+        ASSERT_EQ(dataBuffer[0], static_cast<unsigned char>(writeString[0]));
+
+        ASSERT_EQ(serialPort2.ReadLine(25), writeString + "\n");
+
+        serialPort.Close();
+        serialPort2.Close();
+
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+    }
+
+    void testSerialPortWriteAsync()
+    {
+        serialPort.Open();
+        serialPort2.Open();
+
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+
+        ASSERT_THROW(serialPort.EnableAsyncWrite(0, 0), std::invalid_argument);
+        ASSERT_THROW(serialPort.EnableAsyncWrite(0, ~static_cast<size_t>(0)),
+                     std::invalid_argument);
+        ASSERT_THROW(serialPort.EnableAsyncWrite(0, static_cast<size_t>(1) << 62),
+                     std::runtime_error);
+
+        serialPort.EnableAsyncWrite();
+
+        const std::string writeLine = writeString + '\n';
+        ASSERT_NE(serialPort.WriteAsync(writeLine.data(), writeLine.size()), 0u);
+        ASSERT_TRUE(serialPort.WaitForAsyncWrites(1000));
+
         readString = serialPort2.ReadLine(5);
-        ASSERT_EQ(readString, writeString + '\n');
-        
+        ASSERT_EQ(readString, writeLine);
+
+        serialPort.DisableAsyncWrite();
+
         serialPort.Close();
         serialPort2.Close();
-        
+
         ASSERT_FALSE(serialPort.IsOpen());
         ASSERT_FALSE(serialPort2.IsOpen());
     }
 
-    void testSerialPortIsDataAvailableTest()
+    void testSerialPortReadLine()
     {
         serialPort.Open();
         serialPort2.Open();
@@ -340,18 +1096,50 @@ protected:
         ASSERT_TRUE(serialPort.IsOpen());
         ASSERT_TRUE(serialPort2.IsOpen());
 
-        ASSERT_FALSE(serialPort.IsDataAvailable());
+        serialPort.Write(writeString + "\r\n" + writeString + "\r\n");
+        readString = serialPort2.ReadLine(5, "\r\n");
+        ASSERT_EQ(readString, writeString + "\r\n");
 
-        serialPort.WriteByte((unsigned char)writeByte);
-        usleep(1); // @TODO - This should be replaced to a call to tcdrain();
-        ASSERT_TRUE(serialPort2.IsDataAvailable());
+        readString = serialPort2.ReadLine(5, "\r\n", 10);
+        ASSERT_EQ(readString, writeString.substr(0, 10));
 
-        readByte = (char)serialPort2.ReadByte(1);
-        ASSERT_FALSE(serialPort2.IsDataAvailable());
+        readString = serialPort2.ReadLine(5, "\r\n");
+        ASSERT_EQ(readString, writeString.substr(10) + "\r\n");
 
         serialPort.Close();
         serialPort2.Close();
-        
+
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_FALSE(serialPort2.IsOpen());
+    }
+
+    void testSerialPortConcurrentReaders()
+    {
+        serialPort.Open();
+        serialPort2.Open();
+
+        ASSERT_TRUE(serialPort.IsOpen());
+        ASSERT_TRUE(serialPort2.IsOpen());
+
+        // A reader waiting without a timeout must not keep another
+        // reader from timing out.
+        std::thread lineReader([this]()
+        {
+            readString = serialPort2.ReadLine(0);
+        });
+        struct timespec delay = {0, 25000000};
+        while (nanosleep(&delay, &delay) != 0)
+        {
+        }
+        EXPECT_THROW(serialPort2.ReadByte(10), SerialPort::ReadTimeout);
+
+        serialPort.Write(writeString + "\n");
+        lineReader.join();
+        ASSERT_EQ(readString, writeString + "\n");
+
+        serialPort.Close();
+        serialPort2.Close();
+
         ASSERT_FALSE(serialPort.IsOpen());
         ASSERT_FALSE(serialPort2.IsOpen());
     }
@@ -453,6 +1241,63 @@ protected:
         ASSERT_FALSE(serialPort.IsOpen());
     }
 
+    void testSerialPortSetGetPortSettings()
+    {
+        const SerialPort::PortSettings openSettings(SerialPort::BAUD_9600,
+                                                    SerialPort::CHAR_SIZE_7,
+                                                    SerialPort::PARITY_EVEN,
+                                                    SerialPort::STOP_BITS_2,
+                                                    SerialPort::FLOW_CONTROL_HARD);
+
+        serialPort.Open(openSettings);
+        ASSERT_TRUE(serialPort.IsOpen());
+
+        SerialPort::PortSettings portSettings = serialPort.GetPortSettings();
+        ASSERT_EQ(portSettings.baudRate, SerialPort::BAUD_9600);
+        ASSERT_EQ(portSettings.charSize, SerialPort::CHAR_SIZE_7);
+        ASSERT_EQ(portSettings.parityType, SerialPort::PARITY_EVEN);
+        ASSERT_EQ(portSettings.stopBits, SerialPort::STOP_BITS_2);
+        ASSERT_EQ(portSettings.flowControl, SerialPort::FLOW_CONTROL_HARD);
+
+        serialPort.SetPortSettings(SerialPort::PortSettings(SerialPort::BAUD_115200), true);
+        portSettings = serialPort.GetPortSettings();
+        ASSERT_EQ(portSettings.baudRate, SerialPort::BAUD_115200);
+        ASSERT_EQ(portSettings.charSize, SerialPort::CHAR_SIZE_8);
+        ASSERT_EQ(portSettings.parityType, SerialPort::PARITY_NONE);
+        ASSERT_EQ(portSettings.stopBits, SerialPort::STOP_BITS_1);
+        ASSERT_EQ(portSettings.flowControl, SerialPort::FLOW_CONTROL_NONE);
+
+        // An invalid value must leave all settings unchanged.
+        ASSERT_THROW(serialPort.SetPortSettings(SerialPort::PortSettings(SerialPort::BAUD_9600,
+                                                                         SerialPort::CHAR_SIZE_8,
+                                                                         SerialPort::PARITY_NONE,
+                                                                         SerialPort::STOP_BITS_1,
+                                                                         SerialPort::FLOW_CONTROL_SOFT)),
+                     std::invalid_argument);
+        ASSERT_EQ(serialPort.GetBaudRate(), SerialPort::BAUD_115200);
+
+        serialPort.Close();
+        ASSERT_FALSE(serialPort.IsOpen());
+    }
+
+    void testSerialPortRefreshPortSettings()
+    {
+        serialPort.Open();
+        ASSERT_TRUE(serialPort.IsOpen());
+
+        serialPort.SetBaudRate(SerialPort::BAUD_19200);
+        serialPort.SetNumOfStopBits(SerialPort::STOP_BITS_2);
+
+        // Re-reading the settings from the driver must not change them.
+        serialPort.RefreshPortSettings();
+        ASSERT_EQ(serialPort.GetBaudRate(), SerialPort::BAUD_19200);
+        ASSERT_EQ(serialPort.GetNumOfStopBits(), SerialPort::STOP_BITS_2);
+
+        serialPort.Close();
+        ASSERT_FALSE(serialPort.IsOpen());
+        ASSERT_THROW(serialPort.RefreshPortSettings(), SerialPort::NotOpen);
+    }
+
     void testSerialPortSetGetDTR()
     {
         serialPort.Open();
@@ -511,6 +1356,185 @@ protected:
         ASSERT_FALSE(serialPort.IsOpen());
     }
 
+
+    //----------------------- Ring Buffer Unit Tests ------------------------//
+
+    void testRingBufferCapacity()
+    {
+        // The capacity is rounded up to a power of two.
+        RingBuffer ringBuffer(1000);
+        ASSERT_EQ(ringBuffer.Capacity(), 1024u);
+        ASSERT_TRUE(ringBuffer.IsEmpty());
+
+        ASSERT_EQ(RingBuffer(0).Capacity(), 1u);
+        ASSERT_EQ(RingBuffer(1).Capacity(), 1u);
+        ASSERT_EQ(RingBuffer(64).Capacity(), 64u);
+        ASSERT_EQ(RingBuffer(65).Capacity(), 128u);
+        ASSERT_THROW(RingBuffer(~static_cast<size_t>(0)), std::length_error);
+
+        // Changing the capacity discards the data.
+        ASSERT_TRUE(ringBuffer.Push('a'));
+        ringBuffer.SetCapacity(3);
+        ASSERT_EQ(ringBuffer.Capacity(), 4u);
+        ASSERT_TRUE(ringBuffer.IsEmpty());
+        ASSERT_EQ(ringBuffer.GetWritePosition(), 0u);
+        ASSERT_EQ(ringBuffer.GetReadPosition(), 0u);
+
+        // Push() fails when the buffer is full and Pop() when it is empty.
+        for (unsigned char i = 0; i < 4; i++)
+        {
+            ASSERT_TRUE(ringBuffer.Push(i));
+        }
+        ASSERT_FALSE(ringBuffer.Push(4));
+        ASSERT_EQ(ringBuffer.Size(), 4u);
+
+        unsigned char dataByte = 0;
+        for (unsigned char i = 0; i < 4; i++)
+        {
+            ASSERT_TRUE(ringBuffer.Pop(dataByte));
+            ASSERT_EQ(dataByte, i);
+        }
+        ASSERT_FALSE(ringBuffer.Pop(dataByte));
+        ASSERT_EQ(ringBuffer.GetWritePosition(), 4u);
+        ASSERT_EQ(ringBuffer.GetReadPosition(), 4u);
+    }
+
+    void testRingBufferRegions()
+    {
+        RingBuffer ringBuffer(16);
+        unsigned char dataBuffer[32];
+        for (size_t i = 0; i < sizeof(dataBuffer); i++)
+        {
+            dataBuffer[i] = static_cast<unsigned char>(i);
+        }
+
+        // Move the positions close to the end of the storage.
+        ASSERT_EQ(ringBuffer.Write(dataBuffer, 10), 10u);
+        ringBuffer.Consume(10);
+        ASSERT_TRUE(ringBuffer.IsEmpty());
+
+        // The free space wraps around the end of the storage.
+        struct iovec regions[2];
+        ASSERT_EQ(ringBuffer.GetWriteRegions(regions), 16u);
+        ASSERT_EQ(regions[0].iov_len, 6u);
+        ASSERT_EQ(regions[1].iov_len, 10u);
+
+        std::memcpy(regions[0].iov_base, dataBuffer, 6);
+        std::memcpy(regions[1].iov_base, dataBuffer + 6, 6);
+        ringBuffer.CommitWrite(12);
+        ASSERT_EQ(ringBuffer.Size(), 12u);
+        ASSERT_EQ(ringBuffer.GetWritePosition(), 22u);
+
+        // So does the data.
+        ASSERT_EQ(ringBuffer.GetReadRegions(regions), 12u);
+        ASSERT_EQ(regions[0].iov_len, 6u);
+        ASSERT_EQ(regions[1].iov_len, 6u);
+        ASSERT_EQ(std::memcmp(regions[0].iov_base, dataBuffer, 6), 0);
+        ASSERT_EQ(std::memcmp(regions[1].iov_base, dataBuffer + 6, 6), 0);
+
+        // The free space is a single region now.
+        ASSERT_EQ(ringBuffer.GetWriteRegions(regions), 4u);
+        ASSERT_EQ(regions[0].iov_len, 4u);
+        ASSERT_EQ(regions[1].iov_len, 0u);
+
+        // Write() stops when the buffer is full.
+        ASSERT_EQ(ringBuffer.Write(dataBuffer + 12, 20), 4u);
+        ASSERT_EQ(ringBuffer.Size(), 16u);
+        ASSERT_EQ(ringBuffer.GetWriteRegions(regions), 0u);
+
+        // Consume() removes exactly the specified number of bytes.
+        ringBuffer.Consume(5);
+        ASSERT_EQ(ringBuffer.Size(), 11u);
+        ASSERT_EQ(ringBuffer.GetReadPosition(), 15u);
+
+        // Read() copies across the end of the storage.
+        unsigned char readBuffer[32];
+        size_t readPosition = 0;
+        ASSERT_EQ(ringBuffer.Read(readBuffer, 3, &readPosition), 3u);
+        ASSERT_EQ(readPosition, 15u);
+        ASSERT_EQ(std::memcmp(readBuffer, dataBuffer + 5, 3), 0);
+
+        // Discard() removes the oldest data, but no more than is stored.
+        ASSERT_EQ(ringBuffer.Discard(2), 2u);
+        ASSERT_EQ(ringBuffer.Read(readBuffer, sizeof(readBuffer)), 6u);
+        ASSERT_EQ(std::memcmp(readBuffer, dataBuffer + 10, 6), 0);
+        ASSERT_EQ(ringBuffer.Discard(1), 0u);
+        ASSERT_TRUE(ringBuffer.IsEmpty());
+
+        ringBuffer.Clear();
+        ASSERT_EQ(ringBuffer.GetWritePosition(), 0u);
+        ASSERT_EQ(ringBuffer.GetReadPosition(), 0u);
+    }
+
+    void testRingBufferConcurrentDiscard()
+    {
+        // The producer writes the low byte of each position and discards
+        // the oldest data whenever the buffer is full. Every byte read
+        // must therefore match the position it was read from, even if
+        // it was discarded and overwritten while Read() copied it.
+        const size_t numOfBytes = 1 << 22;
+        RingBuffer ringBuffer(64);
+
+        std::thread producerThread([&ringBuffer, numOfBytes]()
+        {
+            unsigned char dataBuffer[48];
+            size_t writePosition = 0;
+            while (writePosition < numOfBytes)
+            {
+                const size_t chunkSize = std::min(sizeof(dataBuffer),
+                                                  numOfBytes - writePosition);
+                for (size_t i = 0; i < chunkSize; i++)
+                {
+                    dataBuffer[i] = static_cast<unsigned char>(writePosition + i);
+                }
+                size_t numOfBytesWritten = ringBuffer.Write(dataBuffer, chunkSize);
+                if (numOfBytesWritten < chunkSize)
+                {
+                    ringBuffer.Discard(chunkSize - numOfBytesWritten);
+                    numOfBytesWritten += ringBuffer.Write(dataBuffer + numOfBytesWritten,
+                                                          chunkSize - numOfBytesWritten);
+                }
+                writePosition += numOfBytesWritten;
+            }
+        });
+
+        // Keep reading after a mismatch so that the producer can finish.
+        unsigned char readBuffer[40];
+        size_t nextReadPosition = 0;
+        size_t numOfBytesRead = 0;
+        size_t numOfMismatches = 0;
+        while (ringBuffer.GetReadPosition() < numOfBytes)
+        {
+            size_t readPosition = 0;
+            const size_t numOfBytesCopied = ringBuffer.Read(readBuffer,
+                                                            sizeof(readBuffer),
+                                                            &readPosition);
+            if (0 == numOfBytesCopied)
+            {
+                continue;
+            }
+            if (readPosition < nextReadPosition)
+            {
+                numOfMismatches++;
+            }
+            for (size_t i = 0; i < numOfBytesCopied; i++)
+            {
+                if (readBuffer[i] != static_cast<unsigned char>(readPosition + i))
+                {
+                    numOfMismatches++;
+                }
+            }
+            nextReadPosition = readPosition + numOfBytesCopied;
+            numOfBytesRead += numOfBytesCopied;
+        }
+        producerThread.join();
+
+        ASSERT_EQ(numOfMismatches, 0u);
+        ASSERT_EQ(ringBuffer.GetWritePosition(), numOfBytes);
+        ASSERT_GT(numOfBytesRead, 0u);
+        ASSERT_LE(numOfBytesRead, numOfBytes);
+    }
+
     SerialPort::BaudRate        serialPortBaudRate[30];
     SerialPort::CharacterSize   serialPortCharacterSize[4];
     SerialPort::Parity          serialPortParity[3];
@@ -581,6 +1605,48 @@ TEST_F(LibSerialTest, testSerialStreamSetGetStopBits)
     testSerialStreamSetGetStopBits();
 }
 
+TEST_F(LibSerialTest, testSerialStreamBufPeek)
+{
+    SCOPED_TRACE("Serial Stream Buffer Peek Test");
+    testSerialStreamBufPeek();
+}
+
+TEST_F(LibSerialTest, testSerialStreamBufSetBuf)
+{
+    SCOPED_TRACE("Serial Stream Buffer SetBuf Test");
+    testSerialStreamBufSetBuf();
+}
+
+TEST_F(LibSerialTest, testSerialStreamBufOutputBuffer)
+{
+    SCOPED_TRACE("Serial Stream Buffer Output Buffer Test");
+    testSerialStreamBufOutputBuffer();
+}
+
+TEST_F(LibSerialTest, testSerialStreamBufInAvail)
+{
+    SCOPED_TRACE("Serial Stream Buffer In Avail Test");
+    testSerialStreamBufInAvail();
+}
+
+TEST_F(LibSerialTest, testSerialStreamReadWriteTimeout)
+{
+    SCOPED_TRACE("Serial Stream Read and Write Timeout Test");
+    testSerialStreamReadWriteTimeout();
+}
+
+TEST_F(LibSerialTest, testSerialStreamReadWriteBlock)
+{
+    SCOPED_TRACE("Serial Stream Read and Write Block Test");
+    testSerialStreamReadWriteBlock();
+}
+
+TEST_F(LibSerialTest, testSerialStreamSerialPortEngine)
+{
+    SCOPED_TRACE("Serial Stream Serial Port Engine Test");
+    testSerialStreamSerialPortEngine();
+}
+
 
 
 //------------------------- Serial Port Unit Tests --------------------------//
@@ -591,6 +1657,12 @@ TEST_F(LibSerialTest, testSerialPortOpenClose)
     testSerialStreamOpenClose();
 }
 
+TEST_F(LibSerialTest, testSerialPortOpenFailure)
+{
+    SCOPED_TRACE("Serial Port Open Failure Test");
+    testSerialPortOpenFailure();
+}
+
 TEST_F(LibSerialTest, testSerialPortReadWrite)
 {
     SCOPED_TRACE("Serial Port Read and Write Test");
@@ -607,6 +1679,84 @@ TEST_F(LibSerialTest, testSerialPortIsDataAvailableTest)
     testSerialPortIsDataAvailableTest();
 }
 
+TEST_F(LibSerialTest, testSerialPortReadWriteRawBuffer)
+{
+    SCOPED_TRACE("Serial Port Read and Write Raw Buffer Test");
+    testSerialPortReadWriteRawBuffer();
+}
+
+TEST_F(LibSerialTest, testSerialPortReactor)
+{
+    SCOPED_TRACE("Serial Port Reactor Test");
+    testSerialPortReactor();
+}
+
+TEST_F(LibSerialTest, testSerialPortInputSignal)
+{
+    SCOPED_TRACE("Serial Port Real-Time Input Signal Test");
+    testSerialPortInputSignal();
+}
+
+TEST_F(LibSerialTest, testSerialPortDispatcherThread)
+{
+    SCOPED_TRACE("Serial Port Signal Dispatcher Thread Test");
+    testSerialPortDispatcherThread();
+}
+
+TEST_F(LibSerialTest, testSerialPortInputOverflowPolicy)
+{
+    SCOPED_TRACE("Serial Port Input Overflow Policy Test");
+    testSerialPortInputOverflowPolicy();
+}
+
+TEST_F(LibSerialTest, testSerialPortStatistics)
+{
+    SCOPED_TRACE("Serial Port Statistics Test");
+    testSerialPortStatistics();
+}
+
+TEST_F(LibSerialTest, testSerialPortInputLatencyHistogram)
+{
+    SCOPED_TRACE("Serial Port Input Latency Histogram Test");
+    testSerialPortInputLatencyHistogram();
+}
+
+TEST_F(LibSerialTest, testSerialPortReadWithTimestamps)
+{
+    SCOPED_TRACE("Serial Port Read With Timestamps Test");
+    testSerialPortReadWithTimestamps();
+}
+
+TEST_F(LibSerialTest, testSerialPortAcquireReadable)
+{
+    SCOPED_TRACE("Serial Port Acquire Readable Test");
+    testSerialPortAcquireReadable();
+}
+
+TEST_F(LibSerialTest, testSerialPortPeek)
+{
+    SCOPED_TRACE("Serial Port Peek Test");
+    testSerialPortPeek();
+}
+
+TEST_F(LibSerialTest, testSerialPortWriteAsync)
+{
+    SCOPED_TRACE("Serial Port Asynchronous Write Test");
+    testSerialPortWriteAsync();
+}
+
+TEST_F(LibSerialTest, testSerialPortReadLine)
+{
+    SCOPED_TRACE("Serial Port Read Line Test");
+    testSerialPortReadLine();
+}
+
+TEST_F(LibSerialTest, testSerialPortConcurrentReaders)
+{
+    SCOPED_TRACE("Serial Port Concurrent Readers Test");
+    testSerialPortConcurrentReaders();
+}
+
 TEST_F(LibSerialTest, testSerialPortSetGetBaudRate)
 {
     SCOPED_TRACE("Serial Port Set and Get Baud Rate Test");
@@ -636,6 +1786,19 @@ TEST_F(LibSerialTest, testSerialPortSetGetStopBits)
     SCOPED_TRACE("Serial Port Set and Get Stop Bits Test");
     testSerialPortSetGetStopBits();
 }
+
+TEST_F(LibSerialTest, testSerialPortSetGetPortSettings)
+{
+    SCOPED_TRACE("Serial Port Set and Get Port Settings Test");
+    testSerialPortSetGetPortSettings();
+}
+
+TEST_F(LibSerialTest, testSerialPortRefreshPortSettings)
+{
+    SCOPED_TRACE("Serial Port Refresh Port Settings Test");
+    testSerialPortRefreshPortSettings();
+}
+
 TEST_F(LibSerialTest, testSerialPortSetGetDTR)
 {
     SCOPED_TRACE("Serial Port Set and Get DTR Test");
@@ -658,4 +1821,27 @@ TEST_F(LibSerialTest, testSerialPortGetDSR)
 {
     SCOPED_TRACE("Serial Port Get DSR Test");
     testSerialPortGetDSR();
-}
\ No newline at end of file
+}
+
+
+
+//------------------------- Ring Buffer Unit Tests --------------------------//
+
+
+TEST_F(LibSerialTest, testRingBufferCapacity)
+{
+    SCOPED_TRACE("Ring Buffer Capacity Test");
+    testRingBufferCapacity();
+}
+
+TEST_F(LibSerialTest, testRingBufferRegions)
+{
+    SCOPED_TRACE("Ring Buffer Regions Test");
+    testRingBufferRegions();
+}
+
+TEST_F(LibSerialTest, testRingBufferConcurrentDiscard)
+{
+    SCOPED_TRACE("Ring Buffer Concurrent Discard Test");
+    testRingBufferConcurrentDiscard();
+}